@@ -0,0 +1,121 @@
+/*
+AllocationGuard.cpp
+
+Definitions of the AllocationGuard scope and the allocation
+hooks behind it. Compiled to nothing unless
+__ALLOCATION_GUARD__ is defined.
+*/
+
+#include "AllocationGuard.h"
+
+#if defined(__ALLOCATION_GUARD__)
+
+#include <cstdlib>
+#include <cstdio>
+#include <new>
+
+#if defined(__OS_WINDOWS__)
+  #include <crtdbg.h>
+  #define GUARD_THREAD_LOCAL __declspec(thread)
+#else
+  #define GUARD_THREAD_LOCAL __thread
+#endif
+
+//Scopes alive on this thread
+static GUARD_THREAD_LOCAL int depth = 0;
+
+//Reports and stops. Nothing in here may allocate, stderr is unbuffered
+static void refuse(const char* what){
+    depth = 0;
+    fputs("AllocationGuard: ", stderr);
+    fputs(what, stderr);
+    fputs(" called inside the audio callback\n", stderr);
+    abort();
+}
+
+namespace AllocationGuard{
+
+    Scope::Scope(){
+        depth++;
+    }
+
+    Scope::~Scope(){
+        depth--;
+    }
+}
+
+#if defined(__OS_WINDOWS__) && defined(_DEBUG)
+
+//The debug CRT sees every malloc, new and realloc
+static int allocHook(int allocType, void*, size_t, int, long, const unsigned char*, int){
+    if(depth > 0 && allocType != _HOOK_FREE)
+        refuse("an allocation was");
+
+    return 1; //let it through, TRUE needs <windows.h>
+}
+
+//Installs the hook before main() runs
+static struct HookInstaller{
+    HookInstaller(){
+        _CrtSetAllocHook(allocHook);
+    }
+} hookInstaller;
+
+#elif defined(__GLIBC__)
+
+//glibc lets a program replace malloc and still reach the real one,
+//which also catches operator new and STK's StkFrames
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+
+extern "C" void* malloc(size_t size){
+    if(depth > 0)
+        refuse("malloc");
+
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size){
+    if(depth > 0)
+        refuse("calloc");
+
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size){
+    if(depth > 0)
+        refuse("realloc");
+
+    return __libc_realloc(ptr, size);
+}
+
+#else
+
+//No portable malloc hook, catch the C++ allocations at least
+void* operator new(size_t size) throw(std::bad_alloc){
+    if(depth > 0)
+        refuse("operator new");
+
+    void* ptr = malloc(size > 0 ? size : 1);
+    if(ptr == 0)
+        throw std::bad_alloc();
+
+    return ptr;
+}
+
+void* operator new[](size_t size) throw(std::bad_alloc){
+    return operator new(size);
+}
+
+void operator delete(void* ptr) throw(){
+    free(ptr);
+}
+
+void operator delete[](void* ptr) throw(){
+    free(ptr);
+}
+
+#endif
+
+#endif
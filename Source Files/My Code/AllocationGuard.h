@@ -0,0 +1,42 @@
+#ifndef __ALLOCATIONGUARD_H__
+#define __ALLOCATIONGUARD_H__
+
+#include "Stk.h"
+
+/*  Debug check that nothing allocates on the audio thread. Every
+    buffer an effect or the host needs is sized in prepare(), so a
+    heap allocation inside the callback is a bug: it can block on
+    the allocator's lock and glitch the stream.
+
+    Define __ALLOCATION_GUARD__ (or build STK with _STK_DEBUG_) to
+    turn it on. While a Scope is alive on a thread, any allocation
+    on that thread prints what happened and aborts. The hook is the
+    debug CRT's alloc hook on Windows, malloc itself on glibc and
+    operator new everywhere else. Without the flag a Scope is empty
+    and costs nothing.
+*/
+#if defined(_STK_DEBUG_) && !defined(__ALLOCATION_GUARD__)
+  #define __ALLOCATION_GUARD__
+#endif
+
+namespace AllocationGuard{
+
+    //Marks the calling thread as inside the audio callback for as long as it lives
+    class Scope{
+    public:
+    #if defined(__ALLOCATION_GUARD__)
+        Scope(void);
+        ~Scope(void);
+    #else
+        Scope(void){}
+        ~Scope(void){}
+    #endif
+
+    private:
+        //Not copyable, a scope belongs to one block of code
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+    };
+}
+
+#endif
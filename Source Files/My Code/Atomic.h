@@ -0,0 +1,54 @@
+#ifndef __ATOMIC_H__
+#define __ATOMIC_H__
+
+#include "Stk.h"
+
+#if defined(__OS_WINDOWS__)
+  #include <windows.h>
+#endif
+
+/*  Minimal memory ordering for data shared between the control
+    thread and the audio thread. VS2008 has no <atomic>, so the
+    fence comes from the platform: MemoryBarrier() on Windows and
+    the GCC builtin everywhere else.
+
+    A single aligned unsigned int is read and written in one piece
+    on every platform STK runs on, the fences only keep the data it
+    guards from being reordered around it.
+*/
+namespace Atomic{
+
+    //Full memory fence
+    inline void fence(){
+    #if defined(__OS_WINDOWS__)
+        MemoryBarrier();
+    #else
+        __sync_synchronize();
+    #endif
+    }
+
+    //Reads value before anything that depends on it (acquire)
+    inline unsigned int load(const volatile unsigned int& value){
+        unsigned int result = value;
+        fence();
+        return result;
+    }
+
+    //Writes value after everything that came before it (release)
+    inline void store(volatile unsigned int& value, unsigned int newValue){
+        fence();
+        value = newValue;
+    }
+
+    //Adds one in a single step, for counters shared by several writers.
+    //Returns the value before the increment
+    inline unsigned int fetchIncrement(volatile unsigned int& value){
+    #if defined(__OS_WINDOWS__)
+        return static_cast<unsigned int>(InterlockedIncrement((volatile LONG *) &value)) - 1;
+    #else
+        return __sync_fetch_and_add(&value, 1u);
+    #endif
+    }
+}
+
+#endif
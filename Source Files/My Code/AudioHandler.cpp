@@ -13,6 +13,10 @@ the type *.wav
 
 #include "Stk.h"
 #include "AudioHandler.h"
+#include "AllocationGuard.h"
+#include "SegmentRenderer.h"
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 using std::strstr;
@@ -29,23 +33,199 @@ double AudioHandler::fs = 44100.0;
 unsigned int AudioHandler::bufferFrames = 256;
 unsigned int AudioHandler::nChannels = 2;
 bool AudioHandler::done = false;
+double AudioHandler::lookahead = 0.5; //half a second
+unsigned int AudioHandler::renderThreads = 0; //one per processor
+double AudioHandler::statsInterval = 0.0; //off, the reports would break into the menus
+double AudioHandler::simulatedSpeed = 1.0; //as fast as a device
+double AudioHandler::simulatedJitter = 0.0; //on the dot
+RtAudio::Api AudioHandler::api = RtAudio::UNSPECIFIED;
+int AudioHandler::outputDevice = -1; //the default one
+unsigned int AudioHandler::numberOfBuffers = 0; //the API's choice
+int AudioHandler::priority = 0; //normal scheduling
+bool AudioHandler::minimizeLatency = false;
+bool AudioHandler::hogDevice = true;
+
+static const unsigned long RENDER_WINDOW_BLOCKS = 256; //Blocks of input each render thread gets per window
+
+//Audio APIs by the names the options use
+struct ApiName{
+    const char* name;
+    RtAudio::Api api;
+};
+
+static const ApiName API_NAMES[] = {
+    {"alsa", RtAudio::LINUX_ALSA},
+    {"oss", RtAudio::LINUX_OSS},
+    {"jack", RtAudio::UNIX_JACK},
+    {"core", RtAudio::MACOSX_CORE},
+    {"asio", RtAudio::WINDOWS_ASIO},
+    {"ds", RtAudio::WINDOWS_DS},
+    {"dummy", RtAudio::RTAUDIO_DUMMY}
+};
+
+static const char* apiName(RtAudio::Api api){
+    for(uint n = 0; n < sizeof(API_NAMES) / sizeof(API_NAMES[0]); n++){
+        if(API_NAMES[n].api == api)
+            return API_NAMES[n].name;
+    }
+    return "unspecified";
+}
+
+
+/*
+AudioHandler()
+
+opens the audio API chosen by api,
+or the first compiled one with a device
+*/
+AudioHandler::AudioHandler() : rtout(AudioHandler::api){
+    outType = realtimeOutput;
+}
+
+/*
+setOption()
+
+sets one of the real-time output
+statics from an option such as
+api=alsa, device=2, buffer=64,
+periods=2, priority=80, stats=10,
+speed=0, jitter=0.2, minimize or
+share. Returns false for anything
+that is not an output option, and
+for a device the api picked so far
+does not have
+*/
+bool AudioHandler::setOption(const string& option){
+    if(option == "minimize"){
+        AudioHandler::minimizeLatency = true;
+        return true;
+    }
+    if(option == "share"){
+        AudioHandler::hogDevice = false;
+        return true;
+    }
+
+    size_t equals = option.find('=');
+    if(equals == string::npos)
+        return false;
+
+    string key = option.substr(0, equals);
+    string value = option.substr(equals + 1);
+
+    if(key == "api"){
+        for(uint n = 0; n < sizeof(API_NAMES) / sizeof(API_NAMES[0]); n++){
+            if(value == API_NAMES[n].name){
+                AudioHandler::api = API_NAMES[n].api;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //Seconds and the simulated clock take a decimal number
+    if(key == "stats" || key == "speed" || key == "jitter"){
+        char* end = 0;
+        double decimal = std::strtod(value.c_str(), &end);
+        if(value.empty() || *end != '\0' || decimal < 0.0)
+            return false;
+
+        if(key == "stats")
+            AudioHandler::statsInterval = decimal;
+        else if(key == "speed")
+            AudioHandler::simulatedSpeed = decimal;
+        else if(decimal <= 1.0)
+            AudioHandler::simulatedJitter = decimal;
+        else
+            return false;
+
+        return true;
+    }
+
+    //Everything else takes a whole number
+    if(value.empty() || value.find_first_not_of("0123456789") != string::npos)
+        return false;
+    int number = std::atoi(value.c_str());
+
+    if(key == "device"){
+        //Only the devices of the api picked so far, so api= goes first
+        RtAudio audio(AudioHandler::api);
+        if(static_cast<uint>(number) >= audio.getDeviceCount())
+            return false;
+
+        AudioHandler::outputDevice = number;
+    }
+    else if(key == "buffer" && number > 0)
+        AudioHandler::bufferFrames = number;
+    else if(key == "periods" && number > 0)
+        AudioHandler::numberOfBuffers = number;
+    else if(key == "priority" && number <= 99)
+        AudioHandler::priority = number;
+    else if(key == "threads")
+        AudioHandler::renderThreads = number;
+    else
+        return false;
+
+    return true;
+}
+
+/*
+listDevices()
+
+prints the compiled audio APIs and
+the output devices of the one api
+picks, with the numbers device=
+takes
+*/
+void AudioHandler::listDevices(){
+    std::vector<RtAudio::Api> apis;
+    RtAudio::getCompiledApi(apis);
+
+    cout << "Compiled APIs:";
+    for(uint a = 0; a < apis.size(); a++)
+        cout << " " << apiName(apis[a]);
+    cout << endl;
+
+    RtAudio audio(AudioHandler::api);
+    uint count = audio.getDeviceCount();
+
+    cout << "Output devices of " << apiName(audio.getCurrentApi()) << ":" << endl;
+    for(uint d = 0; d < count; d++){
+        RtAudio::DeviceInfo info;
+        try{
+            info = audio.getDeviceInfo(d);
+        }
+        catch ( RtError& ) {
+            continue;
+        }
+
+        if(!info.probed || info.outputChannels == 0)
+            continue;
+
+        cout << "   " << d << ") " << info.name << ", " << info.outputChannels << " channels";
+        if(info.isDefaultOutput)
+            cout << ", default";
+        cout << endl;
+    }
+}
 
 
 /*
 selectOutput()
 
 selects whether the output is
-real-time or file-based
+real-time, file-based or the
+real-time path into a file
 */
 void AudioHandler::selectOutput(){
     uint select = 0;
 
-    cout << "Select (0) Real-Time Output or (1) File-based Output:";
+    cout << "Select (0) Real-Time Output, (1) File-based Output or (2) Simulated Real-Time Output:";
     cin >> select;
 
-    bool fileBased = static_cast<bool>(select);
-
-    if(fileBased){
+    if(select == 2){
+        outType = simulatedOutput;
+    }
+    else if(select == 1){
         outType = fileOutput;
     }
     else{
@@ -59,61 +239,345 @@ openOutput()
 opens the output stream according
 to the output type currently
 designated by outType in this instance
-of AudioHandler
+of AudioHandler. A device that does
+not open falls back to the simulated
+stream, one that does not start ends
+the run
 */
 void AudioHandler::openOutput(){
+    //Without a device the real-time path still runs, on a simulated clock
+    if(outType == realtimeOutput && rtout.getDeviceCount() < 1){
+        cout << "\nNo audio devices found, simulating the real-time stream into a file.\n";
+        outType = simulatedOutput;
+    }
+
     //File-based output branch
     if(outType == fileOutput){
-        Stk::StkFormat format = ( sizeof(StkFloat) == 8 ) ? Stk::STK_FLOAT64 : Stk::STK_FLOAT32;
-
-        string file;
-        cout << "Enter the name for the output file (do not include .wav): ";
-        cin >> file;
-        file += ".wav";
-
-        flout.openFile(file, AudioHandler::nChannels, FileWrite::FILE_WAV, format);
-
-        StkFrames frames;
-
-        for ( unsigned int i=0; !in.isFinished(); i++ ){     
-            flout.tickFrame( effect.tick(&in, AudioHandler::bufferFrames, frames) );
+        openOutputFile();
+
+        prepareBlocks(AudioHandler::bufferFrames);
+
+        //A feed-forward effect renders on every processor, anything else in one pass
+        uint threads = AudioHandler::renderThreads ? AudioHandler::renderThreads : Thread::countProcessors();
+        if(threads > 1 && SegmentRenderer::canSplit(effect))
+            renderSegments(threads);
+        else{
+            for ( unsigned int i=0; !inputFinished(); i++ ){     
+                readBlock(AudioHandler::bufferFrames);
+                effect.process(&inChannels[0], &inChannels[0], AudioHandler::bufferFrames); //in place
+                flout.tickFrame( frames );
+            }
         }
 
         AudioHandler::done = true;
 
     }
+    //Simulated real-time branch, the callback driven without a device
+    else if(outType == simulatedOutput){
+        openOutputFile();
+
+        prepareBlocks(AudioHandler::bufferFrames);
+        monitor.reset(AudioHandler::bufferFrames, this->fs);
+        startPrefetcher(AudioHandler::bufferFrames);
+
+        simulator.openStream(AudioHandler::nChannels, this->fs, AudioHandler::bufferFrames, &AudioHandler::callback, (void *)this);
+        simulator.setClock(AudioHandler::simulatedSpeed, AudioHandler::simulatedJitter);
+        simulator.setReadyCheck(&AudioHandler::inputReady);
+        simulator.setFileSink(&flout);
+        simulator.startStream();
+
+        if(AudioHandler::statsInterval > 0.0)
+            monitor.startReports(std::clog, AudioHandler::statsInterval);
+    }
     //Real-time output branch
     else{
-        if(rtout.getDeviceCount() < 1){
-        cout << "\nNo audio devices found!\n";
-        exit ( 1 );
-        }
-
         rtout.showWarnings( true );       
 
         RtAudio::StreamParameters oParams;
-        oParams.deviceId = rtout.getDefaultOutputDevice();
+        oParams.deviceId = (AudioHandler::outputDevice >= 0) ? AudioHandler::outputDevice : rtout.getDefaultOutputDevice();
         oParams.nChannels = AudioHandler::nChannels;
         RtAudioFormat format = ( sizeof(StkFloat) == 8 ) ? RTAUDIO_FLOAT64 : RTAUDIO_FLOAT32;
 
         RtAudio::StreamOptions options;
-        options.flags = RTAUDIO_HOG_DEVICE;
+        //Effects keep one delay line per channel and write one contiguous block per channel
+        options.flags = RTAUDIO_NONINTERLEAVED;
+        if(AudioHandler::hogDevice)
+            options.flags |= RTAUDIO_HOG_DEVICE;
+        if(AudioHandler::minimizeLatency)
+            options.flags |= RTAUDIO_MINIMIZE_LATENCY;
+        if(AudioHandler::priority > 0){
+            options.flags |= RTAUDIO_SCHEDULE_REALTIME;
+            options.priority = AudioHandler::priority;
+        }
+        options.numberOfBuffers = AudioHandler::numberOfBuffers;
 
         uint nonConstBufferFrames = AudioHandler::bufferFrames;
 
         try {
-            rtout.openStream( &oParams, NULL, format, this->fs, &nonConstBufferFrames, &Effect::callback, (void *)&in, &options );
+            rtout.openStream( &oParams, NULL, format, this->fs, &nonConstBufferFrames, &AudioHandler::callback, (void *)this, &options );
         }
         catch ( RtError& e ) {
             e.printMessage();
         }
 
+        //A device, buffer or period count the device refused, the stream still runs on a simulated clock
+        if(!rtout.isStreamOpen()){
+            cout << "\nThe device did not open, simulating the real-time stream into a file.\n";
+            outType = simulatedOutput;
+            openOutput();
+            return;
+        }
+
+        //What the device settled on, the buffers and periods can differ from the ones asked for
+        cout << "\nStreaming to device " << oParams.deviceId << " through " << apiName(rtout.getCurrentApi()) << ": "
+             << nonConstBufferFrames << " frames x " << options.numberOfBuffers << " buffers, latency "
+             << rtout.getStreamLatency() << " frames (" << rtout.getStreamLatency() * 1000.0 / rtout.getStreamSampleRate() << "ms)";
+        if(AudioHandler::priority > 0)
+            cout << ", real-time priority " << options.priority;
+        cout << endl;
+
+        //The device may have settled on a different buffer size than requested
+        prepareBlocks(nonConstBufferFrames);
+        monitor.reset(nonConstBufferFrames, this->fs);
+        startPrefetcher(nonConstBufferFrames);
+
         try{
             rtout.startStream();
         }
         catch (RtError &error ) {
             error.printMessage();
+
+            //No callback will ever finish the stream, closeOutput() cleans up
+            AudioHandler::done = true;
+            return;
         }
+
+        //Reports go to clog, redirect it to keep them apart from the menus
+        if(AudioHandler::statsInterval > 0.0)
+            monitor.startReports(std::clog, AudioHandler::statsInterval);
+    }
+}
+
+/*
+callback()
+
+RtAudio callback for real-time output. Takes the next
+block of the input file from the prefetcher, which only
+touches memory, and runs it through the effect straight
+into the device buffer. Nothing in here
+may allocate, debug builds abort if it does.
+The monitor times every call and counts the
+xruns RtAudio flags in status
+*/
+int AudioHandler::callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData ){
+    AllocationGuard::Scope guard; //every buffer was sized by prepareBlocks()
+
+    AudioHandler *audio = (AudioHandler *) userData;
+    CallbackMonitor::Scope timing(audio->monitor, status);
+    StkFloat *out = (StkFloat *) outputBuffer;
+
+    //The stream is non-interleaved, one contiguous block per channel
+    for(uint c = 0; c < AudioHandler::nChannels; c++)
+        audio->outChannels[c] = out + c * nBufferFrames;
+
+    const StkFloat* const* block = audio->prefetcher.acquire();
+
+    //The reader fell behind (or the file is over), play silence rather than wait on the disk
+    if(block == 0){
+        for(uint i = 0; i < AudioHandler::nChannels * nBufferFrames; i++)
+            out[i] = 0.0;
+
+        if ( audio->prefetcher.isDrained() ) {
+            AudioHandler::done = true;
+            return 1;
+        }
+        return 0;
+    }
+
+    audio->effect.process(block, &audio->outChannels[0], nBufferFrames);
+    audio->prefetcher.release();
+
+    return 0;
+}
+
+/*
+openOutputFile()
+
+asks for the name of the output
+file and opens it for the stream's
+channels at full precision
+*/
+void AudioHandler::openOutputFile(){
+    Stk::StkFormat format = ( sizeof(StkFloat) == 8 ) ? Stk::STK_FLOAT64 : Stk::STK_FLOAT32;
+
+    string file;
+    cout << "Enter the name for the output file (do not include .wav): ";
+    cin >> file;
+    file += ".wav";
+
+    flout.openFile(file, AudioHandler::nChannels, FileWrite::FILE_WAV, format);
+}
+
+/*
+startPrefetcher()
+
+starts the reader thread that keeps
+lookahead seconds of the input file
+decoded in blocks of nFrames. The
+callback never reads the file itself
+*/
+void AudioHandler::startPrefetcher(uint nFrames){
+    unsigned long lookaheadFrames = static_cast<unsigned long>(AudioHandler::lookahead * AudioHandler::fs);
+    if(mapped.isOpen())
+        prefetcher.open(&mapped, nFrames, AudioHandler::nChannels, lookaheadFrames);
+    else
+        prefetcher.open(&in, nFrames, AudioHandler::nChannels, lookaheadFrames);
+}
+
+/*
+inputReady()
+
+true once the prefetcher has the
+callback's next block, so a simulated
+stream never plays silence because
+the reader was not scheduled in time
+*/
+bool AudioHandler::inputReady(void* userData){
+    AudioHandler *audio = (AudioHandler *) userData;
+
+    return audio->prefetcher.isReady();
+}
+
+/*
+prepareBlocks()
+
+sizes the block buffers and the effect
+for blocks of up to nFrames. Nothing is
+allocated once streaming has started.
+A file render, which has no callback, and
+an unpaced simulated stream, which has no
+deadline, wait for a late convolution tail
+so their output is the same every run
+*/
+void AudioHandler::prepareBlocks(uint nFrames){
+    frames.resize(nFrames, AudioHandler::nChannels);
+    frames.setInterleaved(false); //one contiguous block per channel
+
+    inChannels.resize(AudioHandler::nChannels);
+    outChannels.resize(AudioHandler::nChannels);
+
+    ConvolutionReverb::WAIT_FOR_TAIL = (outType == fileOutput)
+        || (outType == simulatedOutput && AudioHandler::simulatedSpeed == 0.0);
+
+    effect.prepare(AudioHandler::fs, nFrames, AudioHandler::nChannels);
+}
+
+/*
+readBlock()
+
+reads the next nFrames of the input
+file into frames. A mapped file is
+converted straight into the block
+*/
+void AudioHandler::readBlock(uint nFrames){
+    frames.resize(nFrames, AudioHandler::nChannels); //never grows past prepareBlocks()
+
+    for(uint c = 0; c < AudioHandler::nChannels; c++)
+        inChannels[c] = &frames[c * nFrames];
+
+    if(mapped.isOpen())
+        mapped.read(&inChannels[0], nFrames);
+    else
+        in.tickFrame( frames );
+}
+
+/*
+inputFinished()
+
+true once the input file has
+been read to its end
+*/
+bool AudioHandler::inputFinished() const{
+    if(mapped.isOpen())
+        return mapped.isFinished();
+
+    return in.isFinished();
+}
+
+/*
+renderSegments()
+
+reads the input file in the blocks the serial
+render would read, a window at a time, renders
+each window through copies of the effect on
+numThreads threads and writes its blocks out.
+A window starts with the last blocks of the one
+before it, enough to cover the effect's memory.
+The output is the same as the serial render's
+*/
+void AudioHandler::renderSegments(uint numThreads){
+    uint nFrames = AudioHandler::bufferFrames;
+    uint nChannels = AudioHandler::nChannels;
+
+    //Every thread gets at least as many new blocks as the prefix it has to hear
+    unsigned long memoryBlocks = SegmentRenderer::getMemoryBlocks(effect, nFrames);
+    unsigned long threadBlocks = (memoryBlocks > RENDER_WINDOW_BLOCKS) ? memoryBlocks : RENDER_WINDOW_BLOCKS;
+    unsigned long windowBlocks = memoryBlocks + numThreads * threadBlocks;
+
+    std::vector< std::vector<StkFloat> > window(nChannels, std::vector<StkFloat>(windowBlocks * nFrames));
+    std::vector< std::vector<StkFloat> > rendered(nChannels, std::vector<StkFloat>(windowBlocks * nFrames));
+    std::vector<const StkFloat*> windowChannels(nChannels);
+    std::vector<StkFloat*> renderedChannels(nChannels);
+    for(uint c = 0; c < nChannels; c++){
+        windowChannels[c] = &window[c][0];
+        renderedChannels[c] = &rendered[c][0];
+    }
+
+    SegmentRenderer segments;
+    bool split = true;
+    unsigned long heard = 0; //Blocks at the front of the window from the one before
+
+    while(!inputFinished()){
+        unsigned long numBlocks = heard;
+        while(numBlocks < windowBlocks && !inputFinished()){
+            readBlock(nFrames);
+            for(uint c = 0; c < nChannels; c++)
+                std::copy(inChannels[c], inChannels[c] + nFrames, window[c].begin() + numBlocks * nFrames);
+            numBlocks++;
+        }
+
+        if(split){
+            split = segments.render(effect, &windowChannels[0], &renderedChannels[0], heard * nFrames,
+                numBlocks * nFrames, AudioHandler::fs, nFrames, nChannels, numThreads);
+
+            //A copy of the effect could not be set up, the rest is rendered here in one
+            //pass. The effect has not heard anything yet, the prefix fills its delay lines
+            for(unsigned long b = 0; !split && b < heard; b++){
+                for(uint c = 0; c < nChannels; c++){
+                    inChannels[c] = &frames[c * nFrames];
+                    std::copy(window[c].begin() + b * nFrames, window[c].begin() + (b + 1) * nFrames, inChannels[c]);
+                }
+                effect.process(&inChannels[0], &inChannels[0], nFrames); //in place
+            }
+        }
+
+        for(unsigned long b = heard; b < numBlocks; b++){
+            for(uint c = 0; c < nChannels; c++){
+                const std::vector<StkFloat>& source = split ? rendered[c] : window[c];
+                inChannels[c] = &frames[c * nFrames];
+                std::copy(source.begin() + b * nFrames, source.begin() + (b + 1) * nFrames, inChannels[c]);
+            }
+
+            if(!split)
+                effect.process(&inChannels[0], &inChannels[0], nFrames); //in place
+
+            flout.tickFrame( frames );
+        }
+
+        //The last blocks of this window are the prefix of the next one
+        heard = (numBlocks < memoryBlocks) ? numBlocks : memoryBlocks;
+        for(uint c = 0; c < nChannels; c++)
+            std::copy(window[c].begin() + (numBlocks - heard) * nFrames, window[c].begin() + numBlocks * nFrames, window[c].begin());
     }
 }
 
@@ -128,7 +592,22 @@ void AudioHandler::closeOutput(){
         flout.closeFile();
     }
     else{
-        rtout.closeStream();
+        if(outType == simulatedOutput){
+            simulator.closeStream();
+            flout.closeFile();
+        }
+        else
+            rtout.closeStream();
+        prefetcher.close();
+        monitor.stopReports();
+
+        if(prefetcher.getUnderruns() > 0)
+            cout << "\nThe input reader fell behind " << prefetcher.getUnderruns() << " times.\n";
+        if(effect.getLateTails() > 0)
+            cout << "\nThe convolution tail was late " << effect.getLateTails() << " times.\n";
+
+        cout << "\n";
+        CallbackMonitor::report(monitor.getSnapshot(), cout);
     }
 }
 
@@ -141,7 +620,7 @@ bool AudioHandler::openInput(){
     string file;
     int sampleRate = 44100;
 
-    cout << "Enter the path of a valid (non 24-bit) .wav file:";
+    cout << "Enter the path of a valid .wav file:";
     cin >> file;
 
     //if .wav is not found to be the extension format, prompt until it is
@@ -150,17 +629,29 @@ bool AudioHandler::openInput(){
         cin >> file;
    }
 
-   try{
-       in.openFile(file);
+   //Map the file if its format allows, otherwise let STK read it
+   if(mapped.open(file)){
+       AudioHandler::fs = mapped.getFileRate();
+       AudioHandler::nChannels = mapped.getChannels();
    }
-   catch( StkError & ) {
-       cout << "\nInput file did not open correctly.\n";
-       return false;
+   else{
+       try{
+           in.openFile(file);
+       }
+       catch( StkError & ) {
+           cout << "\nInput file did not open correctly.\n";
+           return false;
+       }
+
+       AudioHandler::fs = in.getFileRate();
+       AudioHandler::nChannels = in.getChannels();
    }
 
-   AudioHandler::fs = in.getFileRate();
-  // Stk::setSampleRate( AudioHandler::fs );
-   AudioHandler::nChannels = in.getChannels();
+   //Run STK at the file rate so the file is read (and written) without resampling
+   Stk::setSampleRate( AudioHandler::fs );
+
+   //Size every effect buffer for this file before anything streams
+   effect.prepare(AudioHandler::fs, AudioHandler::bufferFrames, AudioHandler::nChannels);
 
    return true;
 }
@@ -172,7 +663,10 @@ closes the input stream.
 necessary for looping the main program
 */
 void AudioHandler::closeInput(){
-    in.closeFile();
+    if(mapped.isOpen())
+        mapped.close();
+    else
+        in.closeFile();
 }
 
 /*
@@ -189,14 +683,30 @@ void AudioHandler::selectEffect(){
 }
 
 /*
-destroyChorus()
+destroyEffect()
 
-makes a call to the destructor of
-the ChorusUnit class. This is necessary
-to loop the main program, allowing for
-a new instantiation of the member object
-for the chorus unit within the audioHandler
+empties the effect chain. This is
+necessary to loop the main program,
+allowing a new effect to be chosen
 */
 void AudioHandler::destroyEffect(){
-    effect.~Effect();
+    effect.clearProcessors();
+}
+
+/*
+tweakEffect()
+
+lets the user change effect parameters
+while a real-time stream plays. The changes
+go through the effect's parameter queue, so
+the callback never sees a half-made change.
+Returns when the user is done or the
+stream has finished
+*/
+void AudioHandler::tweakEffect(){
+    if(outType == fileOutput)
+        return;
+
+    while(!AudioHandler::done && effect.tweakEffect())
+        ;
 }
\ No newline at end of file
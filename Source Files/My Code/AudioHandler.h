@@ -2,8 +2,15 @@
 #define __AUDIOHANDLER_H__
 
 #include "Effect.h"
+#include "RtAudio.h"
 #include "FileWvIn.h"
+#include "MappedWavFile.h"
 #include "FileWvOut.h"
+#include "InputPrefetcher.h"
+#include "CallbackMonitor.h"
+#include "OfflineDriver.h"
+#include <string>
+#include <vector>
 
 class AudioHandler{
 
@@ -12,14 +19,41 @@ public:
     static unsigned int nChannels; //# of Channels
     static double fs; //Sample rate
     static bool done;
+    static double lookahead; //Seconds of input the reader thread decodes ahead of the real-time callback
+    static unsigned int renderThreads; //Threads of a file render of a feed-forward effect, 0 for one per processor
+    static double statsInterval; //Seconds between callback reports on clog while streaming, 0 for none
+    static double simulatedSpeed; //Simulated seconds per real second of the simulated stream, 0 for back to back
+    static double simulatedJitter; //Largest shift of a simulated callback, as a fraction of the buffer period
+
+    //Real-time output device, set before the AudioHandler is made
+    static RtAudio::Api api; //Audio API of the real-time output, UNSPECIFIED for the first compiled one with a device
+    static int outputDevice; //Device of the real-time output, -1 for the API's default
+    static unsigned int numberOfBuffers; //Periods the device buffers, 0 for the API's choice
+    static int priority; //Real-time priority of the callback thread (1-99), 0 for normal scheduling
+    static bool minimizeLatency; //Asks the API for its lowest latency settings
+    static bool hogDevice; //Takes the device for the stream alone
+
+    //Sets one of the statics above from an option like buffer=64, see DSP Effects.cpp.
+    //Returns false if option is not one of them or its value is not valid
+    static bool setOption(const std::string& option);
+
+    //Lists the compiled APIs and the output devices of api
+    static void listDevices(void);
+
+    AudioHandler(void);
 
     RtAudio rtout;
+    OfflineDriver simulator; //Runs the real-time callback without a device
     FileWvIn in;
+    MappedWavFile mapped; //Used instead of in whenever the file can be mapped
     FileWvOut flout;
 
     Effect effect;
 
-    enum outputType {fileOutput, realtimeOutput} outType;
+    enum outputType {fileOutput, realtimeOutput, simulatedOutput} outType;
+
+    //RtAudio callback for real-time output, userData is the AudioHandler
+    static int callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData );
 
     //Member functions
     void selectOutput(void);
@@ -31,6 +65,38 @@ public:
     
     void selectEffect(void);
     void destroyEffect(void);
+
+    //Lets the user change effect parameters while a real-time stream plays
+    void tweakEffect(void);
+
+private:
+    InputPrefetcher prefetcher; //reads the input file ahead of the real-time callback
+    CallbackMonitor monitor; //times the real-time callback and counts its xruns
+    StkFrames frames; //non-interleaved block read from the input file
+    std::vector<StkFloat*> inChannels; //start of each channel in frames
+    std::vector<StkFloat*> outChannels; //start of each channel in the device buffer
+
+    //Asks for the name of the output file and opens it
+    void openOutputFile(void);
+
+    //Starts the reader thread that feeds the callback blocks of nFrames
+    void startPrefetcher(unsigned int nFrames);
+
+    //True once the prefetcher has the callback's next block, userData is the AudioHandler
+    static bool inputReady(void* userData);
+
+    //Sizes the block buffers and the effect chain for blocks of up to nFrames
+    void prepareBlocks(unsigned int nFrames);
+
+    //Reads the next nFrames of the input file into frames
+    void readBlock(unsigned int nFrames);
+
+    //True once the input file has been read to its end
+    bool inputFinished(void) const;
+
+    //Renders the input file in segments on numThreads threads, a window of
+    //blocks at a time, and writes it out. Only for effects SegmentRenderer can split
+    void renderSegments(unsigned int numThreads);
 };
 
 #endif
\ No newline at end of file
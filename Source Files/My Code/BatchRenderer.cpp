@@ -0,0 +1,379 @@
+/*
+BatchRenderer.cpp
+
+Definitions of the BatchRenderer class. Renders a manifest
+of (input, effect, output) jobs on a pool of worker threads
+and reports the wall time and realtime factor of each job.
+*/
+
+#include "BatchRenderer.h"
+#include "MappedWavFile.h"
+#include "FileRead.h"
+#include "FileWvIn.h"
+#include "FileWvOut.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+
+using std::cout;
+using std::endl;
+using std::string;
+
+//static variables
+unsigned int BatchRenderer::BLOCK_FRAMES = 256;
+
+BatchRenderer::~BatchRenderer(){
+}
+
+BatchRenderer::BatchRenderer(){
+    nextJob = 0;
+    precision = Processor::FLOAT64;
+    compare = false;
+}
+
+void BatchRenderer::setPrecision(Processor::Precision tPrecision){
+    precision = tPrecision;
+}
+
+void BatchRenderer::setCompare(bool tCompare){
+    compare = tCompare;
+}
+
+bool BatchRenderer::loadManifest(const string& fileName){
+    std::ifstream manifest(fileName.c_str());
+
+    if(!manifest){
+        cout << "\nThe manifest " << fileName << " did not open.\n";
+        return false;
+    }
+
+    jobs.clear();
+
+    string line;
+    std::vector<string> tokens;
+
+    for(int lineNumber = 1; std::getline(manifest, line); lineNumber++){
+        splitLine(line, tokens);
+
+        if(tokens.empty() || (!tokens[0].empty() && tokens[0][0] == '#'))
+            continue;
+
+        if(tokens.size() < 3){
+            cout << "\n" << fileName << ", line " << lineNumber
+                 << ": expected <input .wav> <output .wav> <effect answers>\n";
+            return false;
+        }
+
+        Job job;
+        job.line = lineNumber;
+        job.inputFile = tokens[0];
+        job.outputFile = tokens[1];
+        job.fileRate = 0.0;
+        job.rendered = false;
+        job.frames = 0;
+        job.seconds = 0.0;
+        job.maxError = 0.0;
+        job.rmsError = 0.0;
+
+        //Answers with spaces stay quoted, the menus read them as one
+        for(unsigned int t = 2; t < tokens.size(); t++){
+            if(tokens[t].find_first_of(" \t") != string::npos)
+                job.answers += "\"" + tokens[t] + "\" ";
+            else
+                job.answers += tokens[t] + " ";
+        }
+
+        jobs.push_back(job);
+    }
+
+    return true;
+}
+
+bool BatchRenderer::run(unsigned int numThreads){
+    if(numThreads == 0)
+        numThreads = Thread::countProcessors();
+
+    //Only the header is needed to group the jobs by rate
+    for(unsigned int j = 0; j < jobs.size(); j++){
+        try{
+            FileRead header(jobs[j].inputFile);
+            jobs[j].fileRate = header.fileRate();
+            jobs[j].frames = header.fileSize();
+        }
+        catch( StkError & ){
+            //STK does not know every format the mapping reads
+            MappedWavFile mapped;
+            if(mapped.open(jobs[j].inputFile)){
+                jobs[j].fileRate = mapped.getFileRate();
+                jobs[j].frames = mapped.getFrames();
+            }
+            else
+                jobs[j].error = "input file did not open";
+        }
+    }
+
+    cout << "\nRendering " << jobs.size() << " jobs on " << numThreads << " threads...\n";
+
+    double start = Thread::now();
+    std::vector<bool> grouped(jobs.size(), false);
+
+    for(unsigned int j = 0; j < jobs.size(); j++){
+        if(grouped[j] || jobs[j].fileRate <= 0.0)
+            continue;
+
+        //Every job at this rate. The workers must not run while the rate changes
+        double rate = jobs[j].fileRate;
+        queue.clear();
+        for(unsigned int k = j; k < jobs.size(); k++){
+            if(!grouped[k] && jobs[k].fileRate == rate){
+                queue.push_back(k);
+                grouped[k] = true;
+            }
+        }
+
+        Stk::setSampleRate(rate);
+        nextJob = 0;
+
+        unsigned int numWorkers = (numThreads < queue.size()) ? numThreads : queue.size();
+        Worker* workers = new Worker[numWorkers];
+
+        for(unsigned int w = 0; w < numWorkers; w++){
+            workers[w].batch = this;
+            if(!workers[w].thread.start(&BatchRenderer::workerThread, (void *)&workers[w]))
+                workerThread((void *)&workers[w]); //no thread, do its share on this one
+        }
+        for(unsigned int w = 0; w < numWorkers; w++)
+            workers[w].thread.wait();
+
+        delete[ ] workers;
+    }
+
+    report(Thread::now() - start);
+
+    for(unsigned int j = 0; j < jobs.size(); j++){
+        if(!jobs[j].rendered)
+            return false;
+    }
+    return true;
+}
+
+//Worker thread body. Takes jobs off the queue until it is empty
+THREAD_RETURN THREAD_TYPE BatchRenderer::workerThread(void* ptr){
+    Worker* worker = (Worker *) ptr;
+    BatchRenderer* batch = worker->batch;
+    unsigned int next;
+
+    while((next = Atomic::fetchIncrement(batch->nextJob)) < batch->queue.size())
+        batch->render(batch->jobs[batch->queue[next]], worker->file);
+
+    return 0;
+}
+
+//Renders one job the way file-based output does, with its own effect and files
+void BatchRenderer::render(Job& job, FileWvIn& in){
+    double start = Thread::now();
+
+    MappedWavFile mapped;
+    unsigned int nChannels;
+
+    if(mapped.open(job.inputFile))
+        nChannels = mapped.getChannels();
+    else{
+        try{
+            in.openFile(job.inputFile);
+        }
+        catch( StkError & ){
+            job.error = "input file did not open";
+            return;
+        }
+        nChannels = in.getChannels();
+    }
+
+    Effect effect;
+    if(!setEffect(effect, job, compare ? Processor::FLOAT64 : precision, nChannels))
+        return;
+
+    //In compare mode the same chain runs again in float beside it
+    Effect single;
+    if(compare && !setEffect(single, job, Processor::FLOAT32, nChannels))
+        return;
+
+    FileWvOut out;
+    try{
+        Stk::StkFormat format = ( sizeof(StkFloat) == 8 ) ? Stk::STK_FLOAT64 : Stk::STK_FLOAT32;
+        out.openFile(job.outputFile, nChannels, FileWrite::FILE_WAV, format);
+    }
+    catch( StkError & ){
+        job.error = "output file did not open";
+        return;
+    }
+
+    StkFrames frames(BLOCK_FRAMES, nChannels);
+    frames.setInterleaved(false); //one contiguous block per channel
+
+    std::vector<StkFloat*> channels(nChannels);
+    for(unsigned int c = 0; c < nChannels; c++)
+        channels[c] = &frames[c * BLOCK_FRAMES];
+
+    //The float render's copy of each block
+    StkFrames singleFrames(compare ? BLOCK_FRAMES : 1, nChannels);
+    singleFrames.setInterleaved(false);
+    std::vector<StkFloat*> singleChannels(nChannels);
+    for(unsigned int c = 0; c < nChannels && compare; c++)
+        singleChannels[c] = &singleFrames[c * BLOCK_FRAMES];
+
+    double squares = 0.0;
+    double samples = 0.0;
+
+    while(mapped.isOpen() ? !mapped.isFinished() : !in.isFinished()){
+        if(mapped.isOpen())
+            mapped.read(&channels[0], BLOCK_FRAMES);
+        else
+            in.tickFrame(frames);
+
+        if(compare){
+            for(unsigned int i = 0; i < BLOCK_FRAMES * nChannels; i++)
+                singleFrames[i] = frames[i];
+        }
+
+        effect.process(&channels[0], &channels[0], BLOCK_FRAMES); //in place
+
+        if(compare){
+            single.process(&singleChannels[0], &singleChannels[0], BLOCK_FRAMES);
+
+            for(unsigned int i = 0; i < BLOCK_FRAMES * nChannels; i++){
+                double error = fabs(singleFrames[i] - frames[i]);
+                if(error > job.maxError)
+                    job.maxError = error;
+                squares += error * error;
+            }
+            samples += BLOCK_FRAMES * nChannels;
+        }
+
+        out.tickFrame(frames);
+    }
+
+    if(samples > 0.0)
+        job.rmsError = sqrt(squares / samples);
+
+    out.closeFile();
+    if(!mapped.isOpen())
+        in.closeFile();
+
+    job.seconds = Thread::now() - start;
+    job.rendered = true;
+}
+
+//Sets up an effect from a job's answers, at precision
+bool BatchRenderer::setEffect(Effect& effect, Job& job, Processor::Precision tPrecision, unsigned int nChannels){
+    //The menus read the manifest's answers, their questions go nowhere
+    std::istringstream answers(job.answers);
+    std::ostream prompts(0);
+
+    effect.setConsole(answers, prompts);
+    effect.setPrecision(tPrecision);
+    effect.prepare(job.fileRate, BLOCK_FRAMES, nChannels);
+    bool ready = effect.chooseEffect();
+
+    if(answers.fail()){
+        job.error = "too few answers for the chosen effect";
+        return false;
+    }
+    answers >> std::ws;
+    if(!answers.eof()){
+        job.error = "more answers than the chosen effect takes";
+        return false;
+    }
+    if(!ready){
+        job.error = effect.getError();
+        return false;
+    }
+
+    effect.prepare(job.fileRate, BLOCK_FRAMES, nChannels);
+    return true;
+}
+
+//Prints one line per job and the totals
+void BatchRenderer::report(double seconds) const{
+    double audioSeconds = 0.0;
+    unsigned int failed = 0;
+
+    cout << "\n  Line    Wall (s)   Realtime";
+    if(compare)
+        cout << "   Max error  RMS error";
+    cout << "   Output\n";
+    cout << std::fixed;
+
+    for(unsigned int j = 0; j < jobs.size(); j++){
+        const Job& job = jobs[j];
+        cout << std::setw(6) << job.line;
+
+        if(job.rendered){
+            double jobAudio = job.frames / job.fileRate;
+            audioSeconds += jobAudio;
+
+            cout << std::setw(12) << std::setprecision(3) << job.seconds;
+            if(job.seconds > 0.0)
+                cout << std::setw(10) << std::setprecision(1) << jobAudio / job.seconds << "x";
+            else
+                cout << std::setw(11) << "-";
+
+            //The float render's difference, in dB below full scale
+            if(compare){
+                cout << std::setprecision(1);
+                if(job.maxError > 0.0)
+                    cout << std::setw(9) << 20.0 * log10(job.maxError) << "dB";
+                else
+                    cout << std::setw(11) << "exact";
+                if(job.rmsError > 0.0)
+                    cout << std::setw(9) << 20.0 * log10(job.rmsError) << "dB";
+                else
+                    cout << std::setw(11) << "exact";
+            }
+            cout << "   " << job.outputFile << "\n";
+        }
+        else{
+            cout << "   FAILED: " << job.error << " (" << job.inputFile << ")\n";
+            failed++;
+        }
+    }
+
+    cout << "\n" << jobs.size() - failed << " of " << jobs.size() << " jobs rendered in "
+         << std::setprecision(3) << seconds << "s";
+    if(seconds > 0.0)
+        cout << ", " << std::setprecision(1) << audioSeconds / seconds << "x realtime overall";
+    cout << ".\n";
+
+    cout.unsetf(std::ios::floatfield);
+}
+
+//Splits a manifest line into whitespace separated, optionally quoted, tokens
+void BatchRenderer::splitLine(const string& line, std::vector<string>& tokens){
+    tokens.clear();
+
+    string::size_type i = 0;
+    while(i < line.size()){
+        //Skip whitespace, including the \r of Windows line ends
+        if(line[i] == ' ' || line[i] == '\t' || line[i] == '\r'){
+            i++;
+            continue;
+        }
+
+        string token;
+        if(line[i] == '"'){
+            string::size_type close = line.find('"', i + 1);
+            if(close == string::npos)
+                close = line.size();
+
+            token = line.substr(i + 1, close - i - 1);
+            i = close + 1;
+        }
+        else{
+            while(i < line.size() && line[i] != ' ' && line[i] != '\t' && line[i] != '\r')
+                token += line[i++];
+        }
+
+        tokens.push_back(token);
+    }
+}
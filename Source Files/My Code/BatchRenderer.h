@@ -0,0 +1,103 @@
+#ifndef __BATCHRENDERER_H__
+#define __BATCHRENDERER_H__
+
+#include "Effect.h"
+#include "Thread.h"
+#include "Atomic.h"
+#include "FileWvIn.h"
+#include <string>
+#include <vector>
+
+/*  Renders a manifest of jobs without asking anything. Each line
+    of the manifest is one job:
+
+        <input .wav> <output .wav> <answers to the effect menus>
+
+    The answers are the numbers typed at the interactive menus,
+    in the same order, starting with the effect choice. Paths with
+    spaces go in double quotes, lines starting with # are comments.
+
+        # single delay of 200ms, 90% dry, 50% wet
+        W.WAV "Delays/Single Delay/single_delay_200ms.wav" 1 200 0.9 0.5
+
+    Every job gets its own Effect, input and output file, and the
+    jobs run on a pool of worker threads. STK writes the output
+    header at the global STK sample rate, so jobs are rendered in
+    groups of equal input rate with the rate set between groups.
+
+    In compare mode every job is rendered twice, block by block: at
+    FLOAT64, which is written out, and at FLOAT32 beside it. The
+    report gives the largest and the RMS difference between the two.
+*/
+class BatchRenderer{
+public:
+    static unsigned int BLOCK_FRAMES; //Frames rendered per block, as in file-based output
+
+    ~BatchRenderer(void);
+    BatchRenderer(void);
+
+    //Reads the jobs of a manifest. Returns false if it can't be read or a line is malformed
+    bool loadManifest(const std::string& fileName);
+
+    //Precision of the effects' delay lines, FLOAT64 by default
+    void setPrecision(Processor::Precision tPrecision);
+
+    //Renders every job at FLOAT64 and FLOAT32 and reports the difference
+    void setCompare(bool tCompare);
+
+    //Renders every job on numThreads worker threads (0 for one per processor)
+    //and reports each job. Returns true if every job rendered
+    bool run(unsigned int numThreads);
+
+private:
+    //One line of the manifest and how it went
+    struct Job{
+        int line; //Line of the manifest, for the report
+        std::string inputFile; //File to read
+        std::string outputFile; //File to write
+        std::string answers; //Answers to the effect menus
+        double fileRate; //Sample rate of the input
+        bool rendered; //True once the output file is complete
+        std::string error; //Why the job failed
+        unsigned long frames; //Frames of input
+        double seconds; //Wall time of the job
+        double maxError; //Largest difference of the FLOAT32 render, in compare mode
+        double rmsError; //RMS difference of the FLOAT32 render, in compare mode
+    };
+
+    //One thread of the pool. Built on the main thread: STK keeps every
+    //FileWvIn in a static list, so none may be constructed on a worker
+    struct Worker{
+        BatchRenderer* batch; //Renderer the jobs come from
+        FileWvIn file; //Reads inputs that can't be mapped
+        Thread thread; //Runs workerThread(this)
+    };
+
+    //Worker thread body. Takes jobs off the queue until it is empty
+    static THREAD_RETURN THREAD_TYPE workerThread(void* ptr);
+
+    //Renders one job start to finish on the calling thread. in is only used
+    //when the input can't be mapped
+    void render(Job& job, FileWvIn& in);
+
+    //Prints one line per job and the totals
+    void report(double seconds) const;
+
+    //Sets up an effect from a job's answers, at precision. Returns false if the answers don't fit
+    static bool setEffect(Effect& effect, Job& job, Processor::Precision tPrecision, unsigned int nChannels);
+
+    //Splits a manifest line into whitespace separated, optionally quoted, tokens
+    static void splitLine(const std::string& line, std::vector<std::string>& tokens);
+
+    Processor::Precision precision; //Precision of the rendered output
+    bool compare; //True to render every job at both precisions
+    std::vector<Job> jobs; //Every job of the manifest
+    std::vector<unsigned int> queue; //Jobs of the rate group being rendered
+    volatile unsigned int nextJob; //Next cell of queue a worker takes
+
+    //Not copyable, workers point at the renderer
+    BatchRenderer(const BatchRenderer&);
+    BatchRenderer& operator=(const BatchRenderer&);
+};
+
+#endif
@@ -0,0 +1,170 @@
+/*
+CallbackMonitor.cpp
+
+Definitions of the CallbackMonitor class. Times the real-time
+callback against the buffer period, counts the xruns RtAudio
+reports and writes the counts out from a thread of its own.
+*/
+
+#include "CallbackMonitor.h"
+#include <iomanip>
+
+using std::endl;
+
+//static variables
+static const unsigned long REPORT_NAP_MS = 100; //How often the reporter checks whether it should stop
+
+CallbackMonitor::~CallbackMonitor(){
+    stopReports();
+}
+
+CallbackMonitor::CallbackMonitor(){
+    reports = 0;
+    reportInterval = 0.0;
+    stopping = 0;
+
+    reset(256, 44100.0);
+}
+
+void CallbackMonitor::reset(unsigned int blockFrames, double sampleRate){
+    period = blockFrames / sampleRate;
+    start = 0.0;
+    lastStart = 0.0;
+    callbacks = 0;
+    for(unsigned int b = 0; b < NUM_BINS; b++)
+        bins[b] = 0;
+    inputOverflows = 0;
+    outputUnderflows = 0;
+    maxProcessing = 0;
+    maxInterval = 0;
+
+    Atomic::fence();
+}
+
+//Stamps the start of a callback and counts its xruns
+void CallbackMonitor::begin(RtAudioStreamStatus status){
+    start = Thread::now();
+
+    if(lastStart > 0.0){
+        unsigned int interval = toNanoseconds(start - lastStart);
+        if(interval > maxInterval)
+            maxInterval = interval;
+    }
+    lastStart = start;
+
+    //Single writer, a plain increment of the aligned count is enough
+    if(status & RTAUDIO_INPUT_OVERFLOW)
+        inputOverflows = inputOverflows + 1;
+    if(status & RTAUDIO_OUTPUT_UNDERFLOW)
+        outputUnderflows = outputUnderflows + 1;
+}
+
+//Files the time since begin()
+void CallbackMonitor::end(){
+    double elapsed = Thread::now() - start;
+
+    unsigned int bin = static_cast<unsigned int>(elapsed / period * (NUM_BINS - 1));
+    if(bin >= NUM_BINS)
+        bin = NUM_BINS - 1;
+    bins[bin] = bins[bin] + 1;
+
+    unsigned int processing = toNanoseconds(elapsed);
+    if(processing > maxProcessing)
+        maxProcessing = processing;
+
+    callbacks = callbacks + 1;
+}
+
+CallbackMonitor::Snapshot CallbackMonitor::getSnapshot() const{
+    Snapshot snapshot;
+
+    snapshot.callbacks = Atomic::load(callbacks);
+    for(unsigned int b = 0; b < NUM_BINS; b++)
+        snapshot.bins[b] = Atomic::load(bins[b]);
+    snapshot.inputOverflows = Atomic::load(inputOverflows);
+    snapshot.outputUnderflows = Atomic::load(outputUnderflows);
+    snapshot.period = period;
+    snapshot.maxProcessing = Atomic::load(maxProcessing) * 1e-9;
+    snapshot.maxInterval = Atomic::load(maxInterval) * 1e-9;
+
+    return snapshot;
+}
+
+//Writes a snapshot as a few lines of text
+void CallbackMonitor::report(const Snapshot& snapshot, std::ostream& out){
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    double worst = snapshot.maxProcessing / snapshot.period;
+
+    out << std::fixed << std::setprecision(3);
+    out << "Callbacks: " << snapshot.callbacks << " of " << snapshot.period * 1e3 << "ms, ";
+    out << "slowest " << snapshot.maxProcessing * 1e3 << "ms (" << std::setprecision(1) << worst * 100.0 << "% of the period, ";
+    out << (worst < 1.0 ? (1.0 - worst) * 100.0 : 0.0) << "% headroom), ";
+    out << "longest gap " << std::setprecision(3) << snapshot.maxInterval * 1e3 << "ms" << endl;
+
+    out << "Xruns: " << snapshot.inputOverflows << " input overflows, " << snapshot.outputUnderflows << " output underflows" << endl;
+
+    //Only the bins something landed in
+    out << "Load:";
+    for(unsigned int b = 0; b < NUM_BINS; b++){
+        if(snapshot.bins[b] == 0)
+            continue;
+
+        unsigned int percent = b * 100 / (NUM_BINS - 1);
+        if(b == NUM_BINS - 1)
+            out << " >=100%:" << snapshot.bins[b];
+        else
+            out << " " << percent << "-" << percent + 100 / (NUM_BINS - 1) << "%:" << snapshot.bins[b];
+    }
+    out << endl;
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+bool CallbackMonitor::startReports(std::ostream& out, double interval){
+    if(reporter.isRunning() || interval <= 0.0)
+        return false;
+
+    reports = &out;
+    reportInterval = interval;
+    Atomic::store(stopping, 0);
+
+    return reporter.start(&CallbackMonitor::reporterThread, (void *)this);
+}
+
+void CallbackMonitor::stopReports(){
+    if(!reporter.isRunning())
+        return;
+
+    Atomic::store(stopping, 1);
+    reporter.wait();
+}
+
+//Reporter thread body. Naps in short steps so stopReports() does not wait out a whole interval
+THREAD_RETURN THREAD_TYPE CallbackMonitor::reporterThread(void* ptr){
+    CallbackMonitor* monitor = (CallbackMonitor *) ptr;
+    double next = Thread::now() + monitor->reportInterval;
+
+    while(!Atomic::load(monitor->stopping)){
+        Thread::sleep(REPORT_NAP_MS);
+
+        if(Thread::now() >= next){
+            report(monitor->getSnapshot(), *monitor->reports);
+            next += monitor->reportInterval;
+        }
+    }
+
+    return 0;
+}
+
+//Seconds to nanoseconds, held at the largest unsigned int
+unsigned int CallbackMonitor::toNanoseconds(double seconds){
+    double nanoseconds = seconds * 1e9;
+    if(nanoseconds >= 4294967295.0)
+        return 4294967295u;
+    if(nanoseconds <= 0.0)
+        return 0;
+    return static_cast<unsigned int>(nanoseconds);
+}
@@ -0,0 +1,104 @@
+#ifndef __CALLBACKMONITOR_H__
+#define __CALLBACKMONITOR_H__
+
+#include "RtAudio.h"
+#include "Thread.h"
+#include "Atomic.h"
+#include <iostream>
+
+/*  Measures the real-time callback without getting in its way. A
+    Scope at the top of the callback stamps the time, counts the
+    xruns RtAudio reports in the stream status and, when the
+    callback returns, files the block's processing time, as a
+    fraction of the buffer period, in a histogram and raises the
+    watermarks.
+
+    Only the audio thread writes the counts, each an aligned
+    unsigned int, so they need no lock and any thread may read
+    them. A snapshot is not taken in one piece, a callback can land
+    between two counts; that is close enough for a report. The
+    reporter thread writes one every few seconds, the callback
+    itself never prints.
+*/
+class CallbackMonitor{
+public:
+    static const unsigned int NUM_BINS = 21; //5% of the period per bin, the last one for blocks that took a whole period or more
+
+    //Times one callback for as long as it lives. Audio thread only
+    class Scope{
+    public:
+        Scope(CallbackMonitor& tMonitor, RtAudioStreamStatus status) : monitor(tMonitor) { monitor.begin(status); }
+        ~Scope(void){ monitor.end(); }
+
+    private:
+        CallbackMonitor& monitor; //Monitor the callback is counted in
+
+        //Not copyable, a scope belongs to one callback
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+    };
+
+    //The counts at one moment
+    struct Snapshot{
+        unsigned int callbacks; //Callbacks measured
+        unsigned int bins[NUM_BINS]; //Callbacks by processing time, 5% of the period per bin
+        unsigned int inputOverflows; //Callbacks flagged RTAUDIO_INPUT_OVERFLOW
+        unsigned int outputUnderflows; //Callbacks flagged RTAUDIO_OUTPUT_UNDERFLOW
+        double period; //Seconds of audio in a block
+        double maxProcessing; //Longest time spent in one callback, seconds
+        double maxInterval; //Longest time between the starts of two callbacks, seconds
+    };
+
+    ~CallbackMonitor(void);
+    CallbackMonitor(void);
+
+    //Clears the counts for blocks of blockFrames at sampleRate. Not while streaming
+    void reset(unsigned int blockFrames, double sampleRate);
+
+    //Audio thread only. Stamps the start of a callback and counts its xruns
+    void begin(RtAudioStreamStatus status);
+
+    //Audio thread only. Files the time since begin()
+    void end(void);
+
+    //The counts so far. Safe while streaming
+    Snapshot getSnapshot(void) const;
+
+    //Writes a snapshot as a few lines of text
+    static void report(const Snapshot& snapshot, std::ostream& out);
+
+    //Starts a thread that reports to out every interval seconds. Returns false
+    //if it is already running, interval is not positive or the thread can't start
+    bool startReports(std::ostream& out, double interval);
+
+    //Stops the reporter thread
+    void stopReports(void);
+
+private:
+    //Reporter thread body
+    static THREAD_RETURN THREAD_TYPE reporterThread(void* ptr);
+
+    //Seconds to nanoseconds, held at the largest unsigned int
+    static unsigned int toNanoseconds(double seconds);
+
+    double period; //Seconds of audio in a block
+    double start; //When the current callback began, audio thread only
+    double lastStart; //When the one before it began, 0 before the first
+    volatile unsigned int callbacks; //Callbacks measured
+    volatile unsigned int bins[NUM_BINS]; //Histogram of processing time over the period
+    volatile unsigned int inputOverflows; //Callbacks flagged RTAUDIO_INPUT_OVERFLOW
+    volatile unsigned int outputUnderflows; //Callbacks flagged RTAUDIO_OUTPUT_UNDERFLOW
+    volatile unsigned int maxProcessing; //Longest callback, nanoseconds
+    volatile unsigned int maxInterval; //Longest time between callbacks, nanoseconds
+
+    std::ostream* reports; //Where the reporter thread writes
+    double reportInterval; //Seconds between reports
+    volatile unsigned int stopping; //Set by stopReports() to stop the reporter
+    Thread reporter; //Writes the reports
+
+    //Not copyable, the reporter thread points at the monitor
+    CallbackMonitor(const CallbackMonitor&);
+    CallbackMonitor& operator=(const CallbackMonitor&);
+};
+
+#endif
@@ -3,16 +3,16 @@ Definitions for static variables and member functions of the classes:
 MultiChorus, FeedbackChorus, ChorusUnit, and Modulator
 */
 
-#include "AudioHandler.h"
 #include "Chorus.h"
 #include "Interpolation.h"
+#include "Thread.h"
 #include <math.h>
 #include <cmath>
+#include <iostream>
 
 using std::cout;
 using std::cin;
 using std::endl;
-using Interpolation::sincBand;
 using Interpolation::linInterp;
 
 //Declare M_PI for Bullshit VS2008 Error
@@ -20,38 +20,39 @@ using Interpolation::linInterp;
 #define M_PI 3.14159265358979323846
 #endif 
 
-//Global variable used
-const double fsPerMs = (AudioHandler::fs / 1000.0);
-
 //Definition for Destructor necessary
 Chorus::~Chorus(){}
 
     MultiChorus::~MultiChorus(){
         destroyDelayBuffer();
-        mod1.~Modulator();
-        mod2.~Modulator();
-        mod3.~Modulator();
     }
     
     //Default Constructor
     MultiChorus::MultiChorus(){
         dry = 50;
         wet = 50;
+        dryGain.setValue(dry / 100.0);
+        wetGain.setValue(wet / 100.0);
         delay1 = 100;
         delay2 = 200;
         delay3 = 400;
         numDelays = 3;
         //mod1.setModulator();
         numModulators = 1;
-        bufferLength = 2 + (delay3 / 1000.0) * MAX_BUFFER_LENGTH;
-        writeCell = 0;
-
-        initializeDelayBuffer();
+        bufferLength = 2;
+        maxBufferLength = 0;
+        fsPerMs = 0.0;
+        factors = 0;
+        maxFrames = 0;
+        channels = 0;
+        numChannels = 0;
+        isBandlimited = false;
+        kernel = selectKernel(numDelays, numModulators, isBandlimited);
     }
 
     //Main Setter
     void MultiChorus::setMultiChorus(int tDry, int tWet, int tDelay1, int tDelay2, int tDelay3,
-        int tNumDelays, int tNumModulators, bool bandlimited){
+        int tNumDelays, int tNumModulators, bool bandlimited, std::istream& input, std::ostream& prompts){
         if(tDry >= 0 && tDry <= 100)
             dry = tDry;
         else
@@ -62,6 +63,10 @@ Chorus::~Chorus(){}
         else
             wet = 50;
 
+        //prepare() settles the gains before streaming
+        dryGain.setTarget(dry / 100.0);
+        wetGain.setTarget(wet / 100.0);
+
         if(tDelay1 > 0 && tDelay1 <= MAX_MS_DELAY)
             delay1 = tDelay1;
         else
@@ -91,19 +96,19 @@ Chorus::~Chorus(){}
         //Initialize all the necessary modulators
         switch(numModulators){
             case 1:
-                mod1.setModulator();
+                mod1.setModulator(input, prompts);
                 break;
             case 2:
-                mod1.setModulator();
-                mod2.setModulator();
+                mod1.setModulator(input, prompts);
+                mod2.setModulator(input, prompts);
                 break;
             case 3:
-                mod1.setModulator();
-                mod2.setModulator();
-                mod3.setModulator();
+                mod1.setModulator(input, prompts);
+                mod2.setModulator(input, prompts);
+                mod3.setModulator(input, prompts);
                 break;
             default:
-                mod1.setModulator();
+                mod1.setModulator(input, prompts);
         }
     
         //Prioritize delay orderings
@@ -124,615 +129,290 @@ Chorus::~Chorus(){}
         }
 
 
-        //Define the buffer size
-        switch(numDelays){
-            case 1:
-                bufferLength = 2 + static_cast<int>((delay1 / (1.0 *MAX_MS_DELAY)) * MAX_BUFFER_LENGTH);
-                break;
-            case 2:
-                bufferLength = 2 + static_cast<int>((delay2 / (1.0 *MAX_MS_DELAY)) * MAX_BUFFER_LENGTH);
-                break;
-            case 3:
-                bufferLength = 2 + static_cast<int>((delay3 / (1.0 *MAX_MS_DELAY)) * MAX_BUFFER_LENGTH);
-                break;
-            default:
-                bufferLength = 2 + static_cast<int>((delay1 / (1.0 *MAX_MS_DELAY)) * MAX_BUFFER_LENGTH);
-        }
-
         initializeDelayBuffer();
 
-        delayCell1 = (int) (-1) * (fsPerMs * delay1);
-        delayCell2 = (int) (-1) * (fsPerMs * delay2);
-        delayCell3 = (int) (-1) * (fsPerMs * delay3);
-        writeCell = 0;
+        isBandlimited = bandlimited;
 
-        if(bandlimited){
-            isBandlimited = true;
-        }
+        //Pick the loop for these settings once, process() only calls it
+        kernel = selectKernel(numDelays, numModulators, isBandlimited);
     }
 
-    //initializes the delayBuffer into an array of proper size
-    void MultiChorus::initializeDelayBuffer(){
-        destroyDelayBuffer();
+    //Live parameter changes, applied between blocks
+    const char* MultiChorus::PARAMETER_NAMES[] = {"Dry (0-100)", "Wet (0-100)"};
 
-        delayBuffer = new double[bufferLength];
-     }
-    //destroys the current delay buffer
-    void MultiChorus::destroyDelayBuffer(){
-        delete[ ] delayBuffer;
-        delayBuffer = 0; 
+    int MultiChorus::getNumParameters() const{
+        return NUM_PARAMETERS;
     }
+    const char* MultiChorus::getParameterName(int parameter) const{
+        if(parameter < 0 || parameter >= NUM_PARAMETERS)
+            return "";
 
-    int MultiChorus::callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData ){
-        FileWvIn *input = (FileWvIn *) userData;
-        
-        tick(outputBuffer, input, nBufferFrames); 
-
-        if ( input->isFinished() ) {
-            AudioHandler::done = true;
-            return 1;
-        }
-        else
-            return 0;
+        return PARAMETER_NAMES[parameter];
     }
-    //real time overload
-    void MultiChorus::tick(void *outputBuffer, void *input,int nBufferFrames){
-        register StkFloat* out = (StkFloat *) outputBuffer;
-
-        FileWvIn *in = (FileWvIn *) input;
-        
-        StkFrames frames;
-        unsigned int channels = AudioHandler::nChannels;
-        frames.resize( nBufferFrames, channels );
-        
-        in->tickFrame( frames );
-
-        for(unsigned int i = 0; i<frames.size(); i++){
-
-            //If delay milliseconds have passed since the delay buffer was initialized then add in delay
-            if(delayCell1 >= 0){
-
-                //********************VARY THE DELAY TIME ********************************
-                //************************************************************************
-                double factor1 = 1, factor2 = 1, factor3 = 1; //the factors by which to vary delays
-    
-                /*Modulate the delay length*/
-
-                //***************CASE : ONE MODULATOR *************
-                if(numModulators == 1){
-                    factor1 = mod1.nextCoefficient();
-                    factor2 = factor1;
-                    factor3 = factor1;
-
-                    double tmpDelay = delay1 * factor1;
-                    delayCell1 = writeCell - tmpDelay;
+    void MultiChorus::setParameter(int parameter, double value){
+        int percent = static_cast<int>(value);
 
-                    //Conditionals to keep delayCell in bounds
-                    if(delayCell1 < 0){
-                        delayCell1 += bufferLength;
-                    }
-                    else if(delayCell1 > bufferLength){
-                        while(delayCell1 > bufferLength){
-                            delayCell1 -= bufferLength;
-                        }
-                    }
-
-                    if(numDelays >= 2){
-                        tmpDelay = delay2 * factor1;
-                        delayCell2 = writeCell - tmpDelay;
-    
-                        //Conditionals to keep delayCell in bounds
-                        if(delayCell2 < 0){
-                            delayCell2 += bufferLength;
-                        }
-                        else if(delayCell2 > bufferLength){
-                            while(delayCell2 > bufferLength){
-                                delayCell2 -= bufferLength;
-                            }
-                        }
-                    }
-                    if(numDelays >= 3){
-                        tmpDelay = delay3 * factor1;
-                        delayCell3 = writeCell - tmpDelay;
-    
-                        //Conditionals to keep delayCell in bounds
-                        if(delayCell3 < 0){
-                            delayCell3 += bufferLength;
-                        }
-                        else if(delayCell3 > bufferLength){
-                            while(delayCell3 > bufferLength){
-                                delayCell3 -= bufferLength;
-                            }
-                        }
-                    }
-                }
-                //*************CASE: TWO MODULATORS *********************
-                else if(numModulators == 2){
-                    factor1 = mod1.nextCoefficient();
-                    factor3 = factor1;
+        if(percent < 0 || percent > 100)
+            return;
 
-                    double tmpDelay = delay1 * factor1;
-                    delayCell1 = writeCell - tmpDelay;
+        switch(parameter){
+            case DRY:
+                dry = percent;
+                dryGain.setTarget(dry / 100.0);
+                break;
+            case WET:
+                wet = percent;
+                wetGain.setTarget(wet / 100.0);
+                break;
+        }
+    }
 
-                    //Conditionals to keep delayCell in bounds
-                    if(delayCell1 < 0){
-                        delayCell1 += bufferLength;
-                    }
-                    else if(delayCell1 > bufferLength){
-                        while(delayCell1 > bufferLength){
-                            delayCell1 -= bufferLength;
-                        }
-                    }
+    //allocates the delay buffers, modulators and sinc table for the stream
+    void MultiChorus::prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels){
+        destroyDelayBuffer();
 
-                    factor2 = mod2.nextCoefficient();
-                    tmpDelay = delay2 * factor2;
-                    delayCell2 = writeCell - tmpDelay;
+        fsPerMs = tSampleRate / 1000.0;
+        //The modulators stretch a delay by up to (1 + depth) < 2, so keep twice the longest delay
+        maxBufferLength = static_cast<int>(2 * (MAX_MS_DELAY / 1000.0) * tSampleRate);
 
-                    //Conditionals to keep delayCell in bounds
-                    if(delayCell2 < 0){
-                        delayCell2 += bufferLength;
-                    }
-                    else if(delayCell2 > bufferLength){
-                        while(delayCell2 > bufferLength){
-                            delayCell2 -= bufferLength;
-                        }
-                    }
+        numChannels = nChannels;
+        channels = new Channel[numChannels];
 
-                    if(numDelays >= 3){
-                        tmpDelay = delay3 * factor1;
-                        delayCell3 = writeCell - tmpDelay;
-    
-                        //Conditionals to keep delayCell in bounds
-                        if(delayCell3 < 0){
-                            delayCell3 += bufferLength;
-                        }
-                        else if(delayCell3 > bufferLength){
-                            while(delayCell3 > bufferLength){
-                                delayCell3 -= bufferLength;
-                            }
-                        }
-                    }
-                }
-                //*****************CASE: THREE MODULATORS *********
-                else if(numModulators == 3){
-                    factor1 = mod1.nextCoefficient();
-                    double tmpDelay = delay1 * factor1;
-                    delayCell1 = writeCell - tmpDelay;
-
-                    //Conditionals to keep delayCell in bounds
-                    if(delayCell1 < 0){
-                        delayCell1 += bufferLength;
-                    }
-                    else if(delayCell1 > bufferLength){
-                        while(delayCell1 > bufferLength){
-                            delayCell1 -= bufferLength;
-                        }
-                    }
+        for(unsigned int c = 0; c < numChannels; c++)
+            channels[c].delayBuffer = new double[2 + maxBufferLength];
 
-                    factor2 = mod2.nextCoefficient();
-                    tmpDelay = delay2 * factor2;
-                    delayCell2 = writeCell - tmpDelay;
+        maxFrames = maxBlockSize;
+        factors = new double[maxFrames * MAX_DELAYS];
 
-                    //Conditionals to keep delayCell in bounds
-                    if(delayCell2 < 0){
-                        delayCell2 += bufferLength;
-                    }
-                    else if(delayCell2 > bufferLength){
-                        while(delayCell2 > bufferLength){
-                            delayCell2 -= bufferLength;
-                        }
-                    }
+        mod1.prepare(tSampleRate);
+        mod2.prepare(tSampleRate);
+        mod3.prepare(tSampleRate);
+        dryGain.prepare(tSampleRate);
+        wetGain.prepare(tSampleRate);
 
-                    factor3 = mod3.nextCoefficient();
-                    tmpDelay = delay3 * factor3;
-                    delayCell3 = writeCell - tmpDelay;
+        //Build the sinc table now so the callback only does lookups
+        interpolator.initialize(tSampleRate);
 
-                    //Conditionals to keep delayCell in bounds
-                    if(delayCell3 < 0){
-                        delayCell3 += bufferLength;
-                    }
-                    else if(delayCell3 > bufferLength){
-                        while(delayCell3 > bufferLength){
-                            delayCell3 -= bufferLength;
-                        }
-                    }
-                }
+        initializeDelayBuffer();
+    }
 
-                //*******************INTERPOLATE SAMPLE ***********************************
-                //*************************************************************************
+    //sets the delay buffer length for the current delays and clears the buffers
+    void MultiChorus::initializeDelayBuffer(){
+        //Size the ring for the longest delay in use
+        switch(numDelays){
+            case 1:
+                bufferLength = 2 + static_cast<int>((delay1 / (1.0 *MAX_MS_DELAY)) * maxBufferLength);
+                break;
+            case 2:
+                bufferLength = 2 + static_cast<int>((delay2 / (1.0 *MAX_MS_DELAY)) * maxBufferLength);
+                break;
+            case 3:
+                bufferLength = 2 + static_cast<int>((delay3 / (1.0 *MAX_MS_DELAY)) * maxBufferLength);
+                break;
+            default:
+                bufferLength = 2 + static_cast<int>((delay1 / (1.0 *MAX_MS_DELAY)) * maxBufferLength);
+        }
 
-                double delayVal1 = 0; //Initialize value that is the signal from the delay line
-                double delayVal2 = 0;
-                double delayVal3 = 0;
+        //The default delays run past MAX_MS_DELAY, never outgrow the prepared buffers
+        if(bufferLength > 2 + maxBufferLength)
+            bufferLength = 2 + maxBufferLength;
 
-                //*******************CASE: ONE DELAY **********************
-                if(numDelays >= 1){
-                    int delayCellInt1 = static_cast<int>(delayCell1);
+        for(unsigned int c = 0; c < numChannels; c++){
+            //zeroed, the sinc taps read ahead of the write cell
+            for(int i = 0; i < bufferLength; i++)
+                channels[c].delayBuffer[i] = 0.0;
 
-                    //Take an already existing sample if we have one
-                    if(delayCell1 - (delayCellInt1 < 0.00001)){
-                      delayVal1 = delayBuffer[delayCellInt1];
-                    }
-                    else{//interpolate!
-                        //bandlimited interpolation
-                        if(isBandlimited){
-                            delayVal1 = sincBand(delayBuffer, bufferLength, delayCell1, AudioHandler::fs, AudioHandler::fs*factor1);
-                        }
-                        //linear interpolation
-                        else{
-                            int delayCellPlus = delayCellInt1 + 1;
-                            delayCellPlus %= bufferLength;
-                            double slope = delayBuffer[delayCellPlus] - delayBuffer[delayCellInt1];
-
-                            delayVal1 = linInterp(delayCell1 - delayCellInt1, slope, delayBuffer[delayCellInt1]);
-                        }
-                    }
-                }
-                //******************CASE: TWO DELAYS *******************
-                if(numDelays >= 2){
-                    int delayCellInt2 = static_cast<int>(delayCell2);
+            channels[c].writeCell = 0;
+            channels[c].delayCell1 = (int) (-1) * (fsPerMs * delay1);
+            channels[c].delayCell2 = (int) (-1) * (fsPerMs * delay2);
+            channels[c].delayCell3 = (int) (-1) * (fsPerMs * delay3);
+        }
+     }
+    //destroys the current delay buffer
+    void MultiChorus::destroyDelayBuffer(){
+        for(unsigned int c = 0; c < numChannels; c++)
+            delete[ ] channels[c].delayBuffer;
 
-                    //Take an already existing sample if we have one
-                    if(delayCell2 - (delayCellInt2 < 0.00001)){
-                      delayVal2 = delayBuffer[delayCellInt2];
-                    }
-                    else{//interpolate!
-                        //bandlimited interpolation
-                        if(isBandlimited){
-                            delayVal2 = sincBand(delayBuffer, bufferLength, delayCell2, AudioHandler::fs, AudioHandler::fs*factor2);
-                        }
-                        //linear interpolation
-                        else{
-                            int delayCellPlus = delayCellInt2 + 1;
-                            delayCellPlus %= bufferLength;
-                            double slope = delayBuffer[delayCellPlus] - delayBuffer[delayCellInt2];
-
-                            delayVal2 = linInterp(delayCell2 - delayCellInt2, slope, delayBuffer[delayCellInt2]);
-                        }
-                    }
-                }
-                //*****************CASE: THREE DELAYS ****************
-                if(numDelays >= 3){
-                    int delayCellInt3 = static_cast<int>(delayCell3);
+        delete[ ] channels;
+        channels = 0; 
+        numChannels = 0;
 
-                    //Take an already existing sample if we have one
-                    if(delayCell3 - (delayCellInt3 < 0.00001)){
-                      delayVal3 = delayBuffer[delayCellInt3];
-                    }
-                    else{//interpolate!
-                        //bandlimited interpolation
-                        if(isBandlimited){
-                            delayVal3 = sincBand(delayBuffer, bufferLength, delayCell3, AudioHandler::fs, AudioHandler::fs*factor3);
-                        }
-                        //linear interpolation
-                        else{
-                            int delayCellPlus = delayCellInt3 + 1;
-                            delayCellPlus %= bufferLength;
-                            double slope = delayBuffer[delayCellPlus] - delayBuffer[delayCellInt3];
-
-                            delayVal3 = linInterp(delayCell3 - delayCellInt3, slope, delayBuffer[delayCellInt3]);
-                        }
-                    }
-                }
+        delete[ ] factors;
+        factors = 0;
+        maxFrames = 0;
+    }
 
-                //******************COMPUTE OUTPUT ****************************************
-                
-                //Only need one case since delayVal2 and delayVal3 will be 0 if those delays don't "exist"
-                *out = (frames[i] * (dry/100.0)) + (delayVal1 * (wet/100.0)) + (delayVal2 * (wet/100.0)) + (delayVal3 * (wet/100.0)); //Compute the signal at the sum point
-                
-                //limiter
-                if(*out > 1)
-                    *out = 1;
-                else if(*out < -1)
-                    *out = -1;
-                
-                //*******************UPDATE DELAY BUFFER ***********************************
-                if(writeCell >= bufferLength) //Loop around the buffer if reached the end
-                    writeCell %= bufferLength;
+    void MultiChorus::process(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+        //Nothing to do until the delay lines are prepared
+        if(numChannels == 0 || static_cast<unsigned int>(nFrames) > maxFrames)
+            return;
 
-                delayBuffer[writeCell++] = frames[i]; //write input to delay buffer
-            }
+        (this->*kernel)(in, out, nFrames);
+    }
 
-            //************************CASE: DELAY HAS NOT STARTED YET *********************
-            else{
-                *out = frames[i];
-                 
-                if(writeCell >= bufferLength)
-                    writeCell %= bufferLength;
-                delayBuffer[writeCell++] = frames[i];
-
-                delayCell1++; //increment delayCell so it can get up to 0
-                delayCell2++;
-                delayCell3++;
+    //The kernel for the current settings. setMultiChorus() keeps numModulators <= numDelays
+    MultiChorus::Kernel MultiChorus::selectKernel(int tNumDelays, int tNumModulators, bool bandlimited){
+        if(bandlimited){
+            switch(tNumDelays * 4 + tNumModulators){
+                case 2 * 4 + 1: return &MultiChorus::processBlock<2, 1, BANDLIMITED>;
+                case 2 * 4 + 2: return &MultiChorus::processBlock<2, 2, BANDLIMITED>;
+                case 3 * 4 + 1: return &MultiChorus::processBlock<3, 1, BANDLIMITED>;
+                case 3 * 4 + 2: return &MultiChorus::processBlock<3, 2, BANDLIMITED>;
+                case 3 * 4 + 3: return &MultiChorus::processBlock<3, 3, BANDLIMITED>;
+                default: return &MultiChorus::processBlock<1, 1, BANDLIMITED>;
             }
-
-            out++;
+        }
+        switch(tNumDelays * 4 + tNumModulators){
+            case 2 * 4 + 1: return &MultiChorus::processBlock<2, 1, LINEAR>;
+            case 2 * 4 + 2: return &MultiChorus::processBlock<2, 2, LINEAR>;
+            case 3 * 4 + 1: return &MultiChorus::processBlock<3, 1, LINEAR>;
+            case 3 * 4 + 2: return &MultiChorus::processBlock<3, 2, LINEAR>;
+            case 3 * 4 + 3: return &MultiChorus::processBlock<3, 3, LINEAR>;
+            default: return &MultiChorus::processBlock<1, 1, LINEAR>;
         }
     }
 
+    template <int NumDelays, int NumMods, MultiChorus::InterpKind Interp>
+    void MultiChorus::processBlock(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+        //********************VARY THE DELAY TIME ********************************
+        //************************************************************************
+        //Every channel has to see the same modulation, so step the modulators once
+        //per frame up front. Frames still inside the initial delay get no coefficient.
+        //Delays without a modulator of their own follow the first one
+        int warmup = 0;
+        if(channels[0].delayCell1 < 0)
+            warmup = static_cast<int>(ceil(-channels[0].delayCell1));
+
+        if(warmup < nFrames){
+            double* f = &factors[warmup * MAX_DELAYS]; //the first frame's factors, one per delay
+            int count = nFrames - warmup;
+
+            mod1.nextCoefficients(f, count, MAX_DELAYS);
+            if(NumMods >= 2)
+                mod2.nextCoefficients(f + 1, count, MAX_DELAYS);
+            if(NumMods >= 3)
+                mod3.nextCoefficients(f + 2, count, MAX_DELAYS);
+
+            for(int i = 0; i < count * MAX_DELAYS; i += MAX_DELAYS){
+                if(NumDelays >= 2 && NumMods < 2)
+                    f[i + 1] = f[i];
+                if(NumDelays >= 3 && NumMods < 3)
+                    f[i + 2] = f[i];
+            }
+        }
 
-    
-    //file writing overload
-    StkFrames& MultiChorus::tick(void *input, int nBufferFrames, StkFrames& frames){
-        FileWvIn *in = (FileWvIn *) input;
-        
-        unsigned int channels = AudioHandler::nChannels;
-        frames.resize( nBufferFrames, channels );
-        
-        in->tickFrame( frames );
-
-        for(unsigned int i = 0; i<frames.size(); i++){
-
-            //If delay milliseconds have passed since the delay buffer was initialized then add in delay
-            if(delayCell1 >= 0){
-
-                //********************VARY THE DELAY TIME ********************************
-                //************************************************************************
-                double factor1 = 1, factor2 = 1, factor3 = 1; //the factors by which to vary delays
-    
-                /*Modulate the delay length*/
-
-                //***************CASE : ONE MODULATOR *************
-                if(numModulators == 1){
-                    factor1 = mod1.nextCoefficient();
-                    factor2 = factor1;
-                    factor3 = factor1;
-
-                    double tmpDelay = delay1 * factor1;
-                    delayCell1 = writeCell - tmpDelay;
-
-                    //Conditionals to keep delayCell in bounds
-                    if(delayCell1 < 0){
-                        delayCell1 += bufferLength;
-                    }
-                    else if(delayCell1 > bufferLength){
-                        while(delayCell1 > bufferLength){
-                            delayCell1 -= bufferLength;
-                        }
-                    }
+        //Mix gains of this block, every channel walks the same ramps
+        double dryStep, wetStep;
+        double dryStart = dryGain.begin(nFrames, dryStep);
+        double wetStart = wetGain.begin(nFrames, wetStep);
 
-                    if(numDelays >= 2){
-                        tmpDelay = delay2 * factor1;
-                        delayCell2 = writeCell - tmpDelay;
-    
-                        //Conditionals to keep delayCell in bounds
-                        if(delayCell2 < 0){
-                            delayCell2 += bufferLength;
-                        }
-                        else if(delayCell2 > bufferLength){
-                            while(delayCell2 > bufferLength){
-                                delayCell2 -= bufferLength;
-                            }
-                        }
-                    }
-                    if(numDelays >= 3){
-                        tmpDelay = delay3 * factor1;
-                        delayCell3 = writeCell - tmpDelay;
-    
-                        //Conditionals to keep delayCell in bounds
-                        if(delayCell3 < 0){
-                            delayCell3 += bufferLength;
-                        }
-                        else if(delayCell3 > bufferLength){
-                            while(delayCell3 > bufferLength){
-                                delayCell3 -= bufferLength;
-                            }
-                        }
-                    }
-                }
-                //*************CASE: TWO MODULATORS *********************
-                else if(numModulators == 2){
-                    factor1 = mod1.nextCoefficient();
-                    factor3 = factor1;
+        for(unsigned int c = 0; c < numChannels; c++){
+            Channel &ch = channels[c];
+            const StkFloat *input = in[c];
+            StkFloat *output = out[c];
+            double dryNow = dryStart;
+            double wetNow = wetStart;
 
-                    double tmpDelay = delay1 * factor1;
-                    delayCell1 = writeCell - tmpDelay;
+            for(int i = 0; i<nFrames; i++){
+                StkFloat sample = input[i];
+                const double* f = &factors[i * MAX_DELAYS];
 
-                    //Conditionals to keep delayCell in bounds
-                    if(delayCell1 < 0){
-                        delayCell1 += bufferLength;
-                    }
-                    else if(delayCell1 > bufferLength){
-                        while(delayCell1 > bufferLength){
-                            delayCell1 -= bufferLength;
-                        }
-                    }
+                //If delay milliseconds have passed since the delay buffer was initialized then add in delay
+                if(ch.delayCell1 >= 0){
 
-                    factor2 = mod2.nextCoefficient();
-                    tmpDelay = delay2 * factor2;
-                    delayCell2 = writeCell - tmpDelay;
+                    //*******************INTERPOLATE SAMPLE ***********************************
+                    //*************************************************************************
+                    //The NumDelays tests are constant, the compiler drops the stages not in use
+                    ch.delayCell1 = ch.writeCell - delay1 * fsPerMs * f[0];
+                    double delayVal1 = readCell<Interp>(ch.delayBuffer, ch.delayCell1, f[0]);
 
-                    //Conditionals to keep delayCell in bounds
-                    if(delayCell2 < 0){
-                        delayCell2 += bufferLength;
-                    }
-                    else if(delayCell2 > bufferLength){
-                        while(delayCell2 > bufferLength){
-                            delayCell2 -= bufferLength;
-                        }
-                    }
+                    //******************COMPUTE OUTPUT ****************************************
+                    sample = (sample * dryNow) + (delayVal1 * wetNow); //Compute the signal at the sum point
 
-                    if(numDelays >= 3){
-                        tmpDelay = delay3 * factor1;
-                        delayCell3 = writeCell - tmpDelay;
-    
-                        //Conditionals to keep delayCell in bounds
-                        if(delayCell3 < 0){
-                            delayCell3 += bufferLength;
-                        }
-                        else if(delayCell3 > bufferLength){
-                            while(delayCell3 > bufferLength){
-                                delayCell3 -= bufferLength;
-                            }
-                        }
+                    if(NumDelays >= 2){
+                        ch.delayCell2 = ch.writeCell - delay2 * fsPerMs * f[1];
+                        sample += readCell<Interp>(ch.delayBuffer, ch.delayCell2, f[1]) * wetNow;
                     }
-                }
-                //*****************CASE: THREE MODULATORS *********
-                else if(numModulators == 3){
-                    factor1 = mod1.nextCoefficient();
-                    double tmpDelay = delay1 * factor1;
-                    delayCell1 = writeCell - tmpDelay;
-
-                    //Conditionals to keep delayCell in bounds
-                    if(delayCell1 < 0){
-                        delayCell1 += bufferLength;
-                    }
-                    else if(delayCell1 > bufferLength){
-                        while(delayCell1 > bufferLength){
-                            delayCell1 -= bufferLength;
-                        }
+                    if(NumDelays >= 3){
+                        ch.delayCell3 = ch.writeCell - delay3 * fsPerMs * f[2];
+                        sample += readCell<Interp>(ch.delayBuffer, ch.delayCell3, f[2]) * wetNow;
                     }
 
-                    factor2 = mod2.nextCoefficient();
-                    tmpDelay = delay2 * factor2;
-                    delayCell2 = writeCell - tmpDelay;
+                    //limiter
+                    if(sample > 1)
+                        sample = 0.9999;
+                    else if(sample < -1)
+                        sample = -0.9999;
 
-                    //Conditionals to keep delayCell in bounds
-                    if(delayCell2 < 0){
-                        delayCell2 += bufferLength;
-                    }
-                    else if(delayCell2 > bufferLength){
-                        while(delayCell2 > bufferLength){
-                            delayCell2 -= bufferLength;
-                        }
-                    }
+                   //*******************UPDATE DELAY BUFFER ***********************************
+                    if(ch.writeCell >= bufferLength) //Loop around the buffer if reached the end
+                        ch.writeCell %= bufferLength;
 
-                    factor3 = mod3.nextCoefficient();
-                    tmpDelay = delay3 * factor3;
-                    delayCell3 = writeCell - tmpDelay;
-
-                    //Conditionals to keep delayCell in bounds
-                    if(delayCell3 < 0){
-                        delayCell3 += bufferLength;
-                    }
-                    else if(delayCell3 > bufferLength){
-                        while(delayCell3 > bufferLength){
-                            delayCell3 -= bufferLength;
-                        }
-                    }
+                    ch.delayBuffer[ch.writeCell++] = sample; //write input to delay buffer
                 }
 
-                //*******************INTERPOLATE SAMPLE ***********************************
-                //*************************************************************************
-
-                double delayVal1 = 0; //Initialize value that is the signal from the delay line
-                double delayVal2 = 0;
-                double delayVal3 = 0;
-
-                //*******************CASE: ONE DELAY **********************
-                if(numDelays >= 1){
-                    int delayCellInt1 = static_cast<int>(delayCell1);
+                //************************CASE: DELAY HAS NOT STARTED YET *********************
+                else{
+                    if(ch.writeCell >= bufferLength)
+                        ch.writeCell %= bufferLength;
+                    ch.delayBuffer[ch.writeCell++] = sample;
 
-                    //Take an already existing sample if we have one
-                    if(delayCell1 - (delayCellInt1 < 0.00001)){
-                      delayVal1 = delayBuffer[delayCellInt1];
-                    }
-                    else{//interpolate!
-                        //bandlimited interpolation
-                        if(isBandlimited){
-                            delayVal1 = sincBand(delayBuffer, bufferLength, delayCell1, AudioHandler::fs, AudioHandler::fs*factor1);
-                        }
-                        //linear interpolation
-                        else{
-                            int delayCellPlus = delayCellInt1 + 1;
-                            delayCellPlus %= bufferLength;
-                            double slope = delayBuffer[delayCellPlus] - delayBuffer[delayCellInt1];
-
-                            delayVal1 = linInterp(delayCell1 - delayCellInt1, slope, delayBuffer[delayCellInt1]);
-                        }
-                    }
+                    ch.delayCell1++; //increment delayCell so it can get up to 0
+                    ch.delayCell2++;
+                    ch.delayCell3++;
                 }
-                //******************CASE: TWO DELAYS *******************
-                if(numDelays >= 2){
-                    int delayCellInt2 = static_cast<int>(delayCell2);
 
-                    //Take an already existing sample if we have one
-                    if(delayCell2 - (delayCellInt2 < 0.00001)){
-                      delayVal2 = delayBuffer[delayCellInt2];
-                    }
-                    else{//interpolate!
-                        //bandlimited interpolation
-                        if(isBandlimited){
-                            delayVal2 = sincBand(delayBuffer, bufferLength, delayCell2, AudioHandler::fs, AudioHandler::fs*factor2);
-                        }
-                        //linear interpolation
-                        else{
-                            int delayCellPlus = delayCellInt2 + 1;
-                            delayCellPlus %= bufferLength;
-                            double slope = delayBuffer[delayCellPlus] - delayBuffer[delayCellInt2];
-
-                            delayVal2 = linInterp(delayCell2 - delayCellInt2, slope, delayBuffer[delayCellInt2]);
-                        }
-                    }
-                }
-                //*****************CASE: THREE DELAYS ****************
-                if(numDelays >= 3){
-                    int delayCellInt3 = static_cast<int>(delayCell3);
+                dryNow += dryStep;
+                wetNow += wetStep;
 
-                    //Take an already existing sample if we have one
-                    if(delayCell3 - (delayCellInt3 < 0.00001)){
-                      delayVal3 = delayBuffer[delayCellInt3];
-                    }
-                    else{//interpolate!
-                        //bandlimited interpolation
-                        if(isBandlimited){
-                            delayVal3 = sincBand(delayBuffer, bufferLength, delayCell3, AudioHandler::fs, AudioHandler::fs*factor3);
-                        }
-                        //linear interpolation
-                        else{
-                            int delayCellPlus = delayCellInt3 + 1;
-                            delayCellPlus %= bufferLength;
-                            double slope = delayBuffer[delayCellPlus] - delayBuffer[delayCellInt3];
-
-                            delayVal3 = linInterp(delayCell3 - delayCellInt3, slope, delayBuffer[delayCellInt3]);
-                        }
-                    }
-                }
-
-                //******************COMPUTE OUTPUT ****************************************
-                
-                //Only need one case since delayVal2 and delayVal3 will be 0 if those delays don't "exist"
-                frames[i] = (frames[i] * (dry/100.0)) + (delayVal1 * (wet/100.0)) + (delayVal2 * (wet/100.0)) + (delayVal3 * (wet/100.0)); //Compute the signal at the sum point
-                
-                //limiter
-                if(frames[i] > 1)
-                    frames[i] = 0.9999;
-                else if(frames[i] < -1)
-                    frames[i] = -0.9999;
+                output[i] = sample;
+            }
+        }
 
-               //*******************UPDATE DELAY BUFFER ***********************************
-                if(writeCell >= bufferLength) //Loop around the buffer if reached the end
-                    writeCell %= bufferLength;
+        dryGain.end(nFrames);
+        wetGain.end(nFrames);
+    }
 
-                delayBuffer[writeCell++] = frames[i]; //write input to delay buffer
+    //Wraps delayCell into the buffer and reads it, interpolating if needed
+    template <MultiChorus::InterpKind Interp>
+    double MultiChorus::readCell(const double* delayBuffer, double& delayCell, double factor){
+        //Conditionals to keep delayCell in bounds
+        if(delayCell < 0){
+            delayCell += bufferLength;
+        }
+        else if(delayCell > bufferLength){
+            while(delayCell > bufferLength){
+                delayCell -= bufferLength;
             }
+        }
 
-            //************************CASE: DELAY HAS NOT STARTED YET *********************
-            else{
-                if(writeCell >= bufferLength)
-                    writeCell %= bufferLength;
-                delayBuffer[writeCell++] = frames[i];
+        int delayCellInt = static_cast<int>(delayCell);
 
-                delayCell1++; //increment delayCell so it can get up to 0
-                delayCell2++;
-                delayCell3++;
-            }
+        //Take an already existing sample if we have one
+        if((delayCell - delayCellInt) < 0.00001){
+            return delayBuffer[delayCellInt % bufferLength];
         }
+        //bandlimited interpolation
+        if(Interp == BANDLIMITED){
+            return interpolator.interpolate(delayBuffer, bufferLength, delayCell, factor);
+        }
+        //linear interpolation
+        int delayCellPlus = delayCellInt + 1;
+        delayCellPlus %= bufferLength;
+        double slope = delayBuffer[delayCellPlus] - delayBuffer[delayCellInt];
 
-        return frames;
+        return linInterp(delayCell - delayCellInt, slope, delayBuffer[delayCellInt]);
     }
 
   
 //Static variables
 int MultiChorus::MAX_DELAYS = 3;
 int MultiChorus::MAX_MS_DELAY = 100;
-int MultiChorus::MAX_BUFFER_LENGTH = static_cast<int>((MultiChorus::MAX_MS_DELAY / 1000.0) * AudioHandler::fs);
 
 
     //Destructor
     FeedbackChorus::~FeedbackChorus(){
         destroyDelayBuffer();
-        mod.~Modulator();
     }
 
     
@@ -740,279 +420,257 @@ int MultiChorus::MAX_BUFFER_LENGTH = static_cast<int>((MultiChorus::MAX_MS_DELAY
     FeedbackChorus::FeedbackChorus(){
         decay = 70;
         delay = 20;
+        feedbackGain.setValue(decay / 100.0);
         //mod.setModulator();
-        writeCell = 0;
+        bufferLength = 2;
+        maxBufferLength = 0;
+        fsPerMs = 0.0;
+        factors = 0;
+        maxFrames = 0;
+        channels = 0;
+        numChannels = 0;
+        isBandlimited = false;
     }
 
     
     //Main Setter
-    void FeedbackChorus::setFeedbackChorus(int tDecay, int tDelay, bool bandlimited){
+    void FeedbackChorus::setFeedbackChorus(int tDecay, int tDelay, bool bandlimited,
+        std::istream& input, std::ostream& prompts){
         if(tDecay <= 100 && tDecay >= 0)
             decay = tDecay;
         else
             decay = 70;
 
+        //prepare() settles the gain before streaming
+        feedbackGain.setTarget(decay / 100.0);
+
         if(tDelay >= 0 && tDelay <= MAX_MS_DELAY)
             delay = tDelay;
         else
             delay = 20;
 
-        mod.setModulator();
+        mod.setModulator(input, prompts);
 
-        delayCell = (int) (-1) * (fsPerMs * delay);
-        writeCell = 0;
+        initializeDelayBuffer();
 
-        bufferLength = 2 + static_cast<int>((delay / (1.0 *MAX_MS_DELAY) ) * MAX_BUFFER_LENGTH);
+        isBandlimited = bandlimited;
+    }
 
-        initializeDelayBuffer();
+    //Live parameter changes, applied between blocks
+    const char* FeedbackChorus::PARAMETER_NAMES[] = {"Decay (0-100)"};
 
-        if(bandlimited){
-            isBandlimited = true;
-        }
+    int FeedbackChorus::getNumParameters() const{
+        return NUM_PARAMETERS;
     }
+    const char* FeedbackChorus::getParameterName(int parameter) const{
+        if(parameter < 0 || parameter >= NUM_PARAMETERS)
+            return "";
 
-    
-    //initializes the delayBuffer into an array of proper size
-    void FeedbackChorus::initializeDelayBuffer(){
-        destroyDelayBuffer();
+        return PARAMETER_NAMES[parameter];
+    }
+    void FeedbackChorus::setParameter(int parameter, double value){
+        int percent = static_cast<int>(value);
 
-        delayBuffer = new double[bufferLength];
-     }
-    
-    //destroys the current delay buffer
-    void FeedbackChorus::destroyDelayBuffer(){
-        delete[ ] delayBuffer;
-        delayBuffer = 0;
-     }
+        if(percent < 0 || percent > 100)
+            return;
 
-    
-    int FeedbackChorus::callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData ){
-        FileWvIn *input = (FileWvIn *) userData;
-        
-        tick(outputBuffer, input, nBufferFrames); 
-
-        if ( input->isFinished() ) {
-            AudioHandler::done = true;
-            return 1;
+        switch(parameter){
+            case DECAY:
+                decay = percent;
+                feedbackGain.setTarget(decay / 100.0);
+                break;
         }
-        else
-            return 0;
     }
 
     
-    //real-time overload
-    void FeedbackChorus::tick(void *outputBuffer, void *input,int nBufferFrames){
-        register StkFloat *out = (StkFloat *) outputBuffer;
-
-        FileWvIn *in = (FileWvIn *) input;
-        
-        StkFrames frames;
-        unsigned int channels = AudioHandler::nChannels;
-        frames.resize( nBufferFrames, channels );
-        
-        in->tickFrame( frames );
-
-        for(unsigned int i = 0; i<frames.size(); i++){
-
-            //If delay milliseconds have passed since the delay buffer was initialized then add in delay
-            if(delayCell >= 0){
-                //********************VARY THE DELAY TIME ********************************
-                
-                /*Modulate the delay length*/
-                double factor = mod.nextCoefficient(); //the factor by which to vary the delay
-                double tmpDelay = delay * factor; //the varied delay time for this sample
-            
-                delayCell = writeCell - tmpDelay; //compute the current delayed sample needed
-
-                //Conditionals to keep delayCell in bounds
-                if(delayCell < 0){
-                    delayCell += bufferLength;
-                }
-                else if(delayCell > bufferLength){
-                    while(delayCell > bufferLength){
-                        delayCell -= bufferLength;
-                    }
-                }
+    //allocates the delay buffers, modulator and sinc table for the stream
+    void FeedbackChorus::prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels){
+        destroyDelayBuffer();
 
-                //*******************INTERPOLATE SAMPLE ***********************************
+        fsPerMs = tSampleRate / 1000.0;
+        //The modulator stretches the delay by up to (1 + depth) < 2, so keep twice the longest delay
+        maxBufferLength = static_cast<int>(2 * (MAX_MS_DELAY / 1000.0) * tSampleRate);
 
-                double delayVal = 0; //Initialize value that is the signal from the delay line
+        numChannels = nChannels;
+        channels = new Channel[numChannels];
 
-                int delayCellInt = static_cast<int>(delayCell);
+        for(unsigned int c = 0; c < numChannels; c++)
+            channels[c].delayBuffer = new double[2 + maxBufferLength];
 
-                //Take an already existing sample if we have one
-                if(delayCell - (delayCellInt < 0.00001)){
-                    delayVal = delayBuffer[delayCellInt];
-                }
-                //else iterpolate!
-                else{
-                    //bandlimited interpolation
-                    if(isBandlimited){
-                        delayVal = sincBand(delayBuffer, bufferLength, delayCell, AudioHandler::fs, AudioHandler::fs*factor);
-                    }
-                    //linear interpolation
-                    else{
-                        int delayCellPlus = delayCellInt + 1;
-                        delayCellPlus %= bufferLength;
-                        double slope = delayBuffer[delayCellPlus] - delayBuffer[delayCellInt];
+        maxFrames = maxBlockSize;
+        factors = new double[maxFrames];
 
-                        delayVal = linInterp(delayCell - delayCellInt, slope, delayBuffer[delayCellInt]);
-                    }
-                }
+        mod.prepare(tSampleRate);
+        feedbackGain.prepare(tSampleRate);
 
-                //******************COMPUTE OUTPUT ****************************************
-                *out = (frames[i] + (delayVal * (decay/100.0))); //Compute the signal at the sum point
-
-                //limiter
-                if(*out > 1)
-                    *out = 1;
-                else if(*out < -1)
-                    *out = -1;
-                
-               //*******************UPDATE DELAY BUFFER ***********************************
-                if(writeCell >= bufferLength) //Loop around the buffer if reached the end
-                    writeCell %= bufferLength;
+        //Build the sinc table now so the callback only does lookups
+        interpolator.initialize(tSampleRate);
 
-                delayBuffer[writeCell++] = *out;
-            }
+        initializeDelayBuffer();
+    }
 
-            //************************CASE: DELAY HAS NOT STARTED YET *********************
-            else{
-                *out = frames[i];
-                 
-                if(writeCell >= bufferLength)
-                    writeCell %= bufferLength;
-                delayBuffer[writeCell++] = frames[i];
+    //sets the delay buffer length for the current delay and clears the buffers
+    void FeedbackChorus::initializeDelayBuffer(){
+        bufferLength = 2 + static_cast<int>((delay / (1.0 *MAX_MS_DELAY) ) * maxBufferLength);
 
-                delayCell++; //increment delayCell so it can get up to 0
-            }
+        for(unsigned int c = 0; c < numChannels; c++){
+            //zeroed, the sinc taps read ahead of the write cell
+            for(int i = 0; i < bufferLength; i++)
+                channels[c].delayBuffer[i] = 0.0;
 
-            out++;
+            channels[c].writeCell = 0;
+            channels[c].delayCell = (int) (-1) * (fsPerMs * delay);
         }
-    }
-
+     }
+    
+    //destroys the current delay buffer
+    void FeedbackChorus::destroyDelayBuffer(){
+        for(unsigned int c = 0; c < numChannels; c++)
+            delete[ ] channels[c].delayBuffer;
 
-    //file writing overload
-    StkFrames& FeedbackChorus::tick(void *input, int nBufferFrames, StkFrames& frames){
-        FileWvIn *in = (FileWvIn *) input;
-        
-        unsigned int channels = AudioHandler::nChannels;
-        frames.resize( nBufferFrames, channels );
-        
-        in->tickFrame( frames );
+        delete[ ] channels;
+        channels = 0;
+        numChannels = 0;
 
-        for(unsigned int i = 0; i<frames.size(); i++){
+        delete[ ] factors;
+        factors = 0;
+        maxFrames = 0;
+     }
 
-            //If delay milliseconds have passed since the delay buffer was initialized then add in delay
-            if(delayCell >= 0){
-                //********************VARY THE DELAY TIME ********************************
+    void FeedbackChorus::process(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+        //Nothing to do until the delay lines are prepared
+        if(numChannels == 0 || static_cast<unsigned int>(nFrames) > maxFrames)
+            return;
+
+        //********************VARY THE DELAY TIME ********************************
+        //Every channel has to see the same modulation, so step the modulator once
+        //per frame up front. Frames still inside the initial delay get no coefficient.
+        int warmup = 0;
+        if(channels[0].delayCell < 0)
+            warmup = static_cast<int>(ceil(-channels[0].delayCell));
+
+        if(warmup < nFrames)
+            mod.nextCoefficients(&factors[warmup], nFrames - warmup);
+
+        //Feedback gain of this block, every channel walks the same ramp
+        double feedbackStep;
+        double feedbackStart = feedbackGain.begin(nFrames, feedbackStep);
+
+        for(unsigned int c = 0; c < numChannels; c++){
+            Channel &ch = channels[c];
+            const StkFloat *input = in[c];
+            StkFloat *output = out[c];
+            double feedbackNow = feedbackStart;
+
+            for(int i = 0; i<nFrames; i++){
+                StkFloat sample = input[i];
+                //If delay milliseconds have passed since the delay buffer was initialized then add in delay
+                if(ch.delayCell >= 0){
+                    /*Modulate the delay length*/
+                    double tmpDelay = delay * fsPerMs * factors[i]; //the varied delay time for this sample, in samples
                 
-                /*Modulate the delay length*/
-                double factor = mod.nextCoefficient(); //the factor by which to vary the delay
-                double tmpDelay = delay * factor; //the varied delay time for this sample
-            
-                delayCell = writeCell - tmpDelay; //compute the current delayed sample needed
-
-                //Conditionals to keep delayCell in bounds
-                if(delayCell < 0){
-                    delayCell += bufferLength;
-                }
-                else if(delayCell > bufferLength){
-                    while(delayCell > bufferLength){
-                        delayCell -= bufferLength;
-                    }
-                }
+                    ch.delayCell = ch.writeCell - tmpDelay; //compute the current delayed sample needed
 
-                //*******************INTERPOLATE SAMPLE ***********************************
+                    //*******************INTERPOLATE SAMPLE ***********************************
+                    double delayVal = readCell(ch.delayBuffer, ch.delayCell, factors[i]);
 
-                double delayVal = 0; //Initialize value that is the signal from the delay line
+                    //******************COMPUTE OUTPUT ****************************************
+                    sample += (delayVal * feedbackNow); //Compute the signal at the sum point
 
-                int delayCellInt = static_cast<int>(delayCell);
+                    if(sample >= 1)
+                        sample = 0.9999;
+                    else if(sample <= -1)
+                        sample = -0.9999;
+                   //*******************UPDATE DELAY BUFFER ***********************************
+                    if(ch.writeCell >= bufferLength) //Loop around the buffer if reached the end
+                        ch.writeCell %= bufferLength;
 
-                //Take an already existing sample if we have one
-                if(delayCell - (delayCellInt < 0.00001)){
-                    delayVal = delayBuffer[delayCellInt];
+                    ch.delayBuffer[ch.writeCell++] = sample;
                 }
-                //else iterpolate!
+
+                //************************CASE: DELAY HAS NOT STARTED YET *********************
                 else{
-                    //bandlimited interpolation
-                    if(isBandlimited){
-                        delayVal = sincBand(delayBuffer, bufferLength, delayCell, AudioHandler::fs, AudioHandler::fs*factor);
-                    }
-                    //linear interpolation
-                    else{
-                        int delayCellPlus = delayCellInt + 1;
-                        delayCellPlus %= bufferLength;
-                        double slope = delayBuffer[delayCellPlus] - delayBuffer[delayCellInt];
+                    if(ch.writeCell >= bufferLength)
+                        ch.writeCell %= bufferLength;
+                    ch.delayBuffer[ch.writeCell++] = sample;
 
-                        delayVal = linInterp(delayCell - delayCellInt, slope, delayBuffer[delayCellInt]);
-                    }
+                    ch.delayCell++; //increment delayCell so it can get up to 0
                 }
 
-                //******************COMPUTE OUTPUT ****************************************
-                frames[i] += (delayVal * (decay/100.0)); //Compute the signal at the sum point
-
-                if(frames[i] >= 1)
-                    frames[i] = 0.9999;
-                else if(frames[i] <= -1)
-                    frames[i] = -0.9999;
-               //*******************UPDATE DELAY BUFFER ***********************************
-                if(writeCell >= bufferLength) //Loop around the buffer if reached the end
-                    writeCell %= bufferLength;
+                feedbackNow += feedbackStep;
 
-                delayBuffer[writeCell++] = frames[i];
+                output[i] = sample;
             }
+        }
 
-            //************************CASE: DELAY HAS NOT STARTED YET *********************
-            else{
-                if(writeCell >= bufferLength)
-                    writeCell %= bufferLength;
-                delayBuffer[writeCell++] = frames[i];
+        feedbackGain.end(nFrames);
+    }
 
-                delayCell++; //increment delayCell so it can get up to 0
+    //Wraps delayCell into the buffer and reads it, interpolating if needed
+    double FeedbackChorus::readCell(const double* delayBuffer, double& delayCell, double factor){
+        //Conditionals to keep delayCell in bounds
+        if(delayCell < 0){
+            delayCell += bufferLength;
+        }
+        else if(delayCell > bufferLength){
+            while(delayCell > bufferLength){
+                delayCell -= bufferLength;
             }
         }
 
-        return frames;
+        int delayCellInt = static_cast<int>(delayCell);
+
+        //Take an already existing sample if we have one
+        if((delayCell - delayCellInt) < 0.00001){
+            return delayBuffer[delayCellInt % bufferLength];
+        }
+        //bandlimited interpolation
+        if(isBandlimited){
+            return interpolator.interpolate(delayBuffer, bufferLength, delayCell, factor);
+        }
+        //linear interpolation
+        int delayCellPlus = delayCellInt + 1;
+        delayCellPlus %= bufferLength;
+        double slope = delayBuffer[delayCellPlus] - delayBuffer[delayCellInt];
+
+        return linInterp(delayCell - delayCellInt, slope, delayBuffer[delayCellInt]);
     }
 
 
 //Static variables
 int FeedbackChorus::MAX_MS_DELAY = 100;
-int FeedbackChorus::MAX_BUFFER_LENGTH = static_cast<int>((MultiChorus::MAX_MS_DELAY / 1000.0) * AudioHandler::fs);
     
 
-int Modulator::STD_BUFFER_LENGTH = static_cast<int>( AudioHandler::fs ); // Samples per cycle at 1Hz
 double Modulator::MAX_HZ = 10; //10Hz maximum frequency
 double Modulator::MIN_HZ = 0.5; //0.5Hz minimum frequency
 int Modulator::MAX_MODS = 3; //3 mods at most supported
+double* Modulator::tables[Modulator::NUM_SHAPES] = {0, 0, 0, 0};
+static Mutex tableLock; //Effects are prepared on several threads at once in batch mode
 
-Modulator::~Modulator(){
-    destroyCoefficients();
-}
+Modulator::~Modulator(){}
 
 Modulator::Modulator(){
     shape = sine;
     depth = 20;
     freq = 2.0;
-    
-    bufferLength =  static_cast<int>( STD_BUFFER_LENGTH * (1 / freq) );
-
-    initializeCoefficients();
+    sampleRate = 0.0;
 
-    coefficientIndex = 0;
+    phase = 0.0;
+    increment = 0.0;
 }
 
-void Modulator::setModulator(){
+void Modulator::setModulator(std::istream& input, std::ostream& prompts){
     int temp;
-    cout << "Enter the parameters for the modulator." << endl;
-    cout << "Shape: (0) sine, (1) saw, (2) triangular, (3) square:";
-    cin >> temp;
+    prompts << "Enter the parameters for the modulator." << endl;
+    prompts << "Shape: (0) sine, (1) saw, (2) triangular, (3) square:";
+    input >> temp;
+    if(temp < sine || temp >= NUM_SHAPES)
+        temp = sine;
     shape = static_cast<modShape>(temp);
-    cout << "Frequency: " << MIN_HZ << "Hz - " << MAX_HZ << "Hz:";
-    cin >> freq;
-    cout << "Depth: amplitude of wave from 0% - 99%:";
-    cin >> depth;
+    prompts << "Frequency: " << MIN_HZ << "Hz - " << MAX_HZ << "Hz:";
+    input >> freq;
+    prompts << "Depth: amplitude of wave from 0% - 99%:";
+    input >> depth;
 
     //adjust to a decimal percent
     depth /= 100;
@@ -1027,71 +685,112 @@ void Modulator::setModulator(){
     while(freq < 0.5){
         freq += 0.2;
     }
-    
-    bufferLength =  static_cast<int>( STD_BUFFER_LENGTH * (1 / freq) );
 
-    initializeCoefficients();
+    setFrequency(freq);
 }
 
-//Creates a buffer ring containing coefficient values calculated for
-//the given Wave shape over 1 period of the shape
-void Modulator::initializeCoefficients(){
-    destroyCoefficients();
+//Sets the phase increment for the stream's sample rate and restarts the cycle
+void Modulator::prepare(double tSampleRate){
+    initializeTables();
 
-    coefficient = new double[bufferLength];
+    sampleRate = tSampleRate;
+    phase = 0.0;
 
-    //initialize loop variables
-    int i = 0;
-    double t = 0.0;
+    setFrequency(freq);
+}
 
-    //Fill coefficient table. Uses samples from 1 period of the specified wave shape
-    //and gets freq samples of the one period at even intervals
-    switch(shape){
-        case sine:
-            for(i = 0, t = 0.0; i < bufferLength; i++, t += 1.0/bufferLength){
-                //Sine wave adjustable by depth parameters centered around 1
-                coefficient[i] = (depth * sin( 2 * M_PI * t ) ) + 1;
-                //^^ is continuous, not adjustable for integer i's, hence t
+//Changes the frequency without restarting the cycle
+void Modulator::setFrequency(double tFreq){
+    if(tFreq < MIN_HZ)
+        tFreq = MIN_HZ;
+    else if(tFreq > MAX_HZ)
+        tFreq = MAX_HZ;
 
-            }
-            break;
-        case saw:
-            for(i = 0, t = 0.0; i < bufferLength; i++, t += 1.0/bufferLength){
-                //Sawtooth wave adjustable by freq. and depth parameters centered around 1
-                coefficient[i] = (1 - (2 * depth)) + ((t - floor( t + 0.5 ) + 1 ) * 2 * depth); 
-                //^^ is continuous, not adjustable for integer i's, hence t
-            }
-            break;
-        case triangular:
-            //Note, t increments 2/bufferLength because triangular wave has period spanning [0,2)
-            for(i = 0, t = -0.5; i < bufferLength; i++, t += 2.0/bufferLength){
-                //Triangular wave adjustable by freq. and depth parameter centered around 1
-                coefficient[i] = (2 * depth) * fabs( (t ) - 2 * floor( t / 2.0 ) - 1 ) + (1 - depth);
-                //^^ is continuous, not adjustable for integer i's, hence t
-            }
-        case square:
-            for(i = 0; i < bufferLength; i++){
-                //Low part of square
-                if(i < static_cast<int>(bufferLength / 2) )
-                    coefficient[i] = 1.0 - depth;
-                //High part of square
-                else
-                    coefficient[i] = 1.0 + depth;
-            }
-            break;
-    }
+    freq = tFreq;
+
+    if(sampleRate > 0.0)
+        increment = TABLE_LENGTH * freq / sampleRate;
 }
 
-void Modulator::destroyCoefficients(){
-    delete[ ] coefficient;
-    coefficient = 0;
+double Modulator::getFrequency() const{
+    return freq;
 }
 
+//Fills one cycle of every shape, from -1 to 1, the first time a modulator is prepared.
+//The tables are kept for the life of the program
+void Modulator::initializeTables(){
+    tableLock.lock();
+
+    if(!tables[sine]){
+        //initialize loop variables
+        int i = 0;
+        double t = 0.0;
+
+        //Fill each table with samples from 1 period of its shape at even intervals.
+        //The point past the end repeats the first so reads can interpolate without wrapping
+        for(int s = sine; s < NUM_SHAPES; s++){
+            double* table = new double[TABLE_LENGTH + 1];
+
+            switch(s){
+                case sine:
+                    for(i = 0, t = 0.0; i < TABLE_LENGTH; i++, t += 1.0/TABLE_LENGTH){
+                        table[i] = sin( 2 * M_PI * t );
+                        //^^ is continuous, not adjustable for integer i's, hence t
+                    }
+                    break;
+                case saw:
+                    for(i = 0, t = 0.0; i < TABLE_LENGTH; i++, t += 1.0/TABLE_LENGTH){
+                        //Rises from 0 to 1 over the first half, jumps to -1 and rises back to 0
+                        table[i] = 2 * (t - floor( t + 0.5 ));
+                    }
+                    break;
+                case triangular:
+                    //Note, t increments 2/TABLE_LENGTH because triangular wave has period spanning [0,2)
+                    for(i = 0, t = -0.5; i < TABLE_LENGTH; i++, t += 2.0/TABLE_LENGTH){
+                        table[i] = 2 * fabs( (t ) - 2 * floor( t / 2.0 ) - 1 ) - 1;
+                    }
+                    break;
+                case square:
+                    for(i = 0; i < TABLE_LENGTH; i++){
+                        //Low half, then high half
+                        table[i] = (i < TABLE_LENGTH / 2) ? -1.0 : 1.0;
+                    }
+                    break;
+            }
+            table[TABLE_LENGTH] = table[0];
+
+            tables[s] = table;
+        }
+    }
+
+    tableLock.unlock();
+}
 
 double Modulator::nextCoefficient(){
-    if(coefficientIndex >= bufferLength)
-        coefficientIndex %= bufferLength;
+    double coefficient;
+    nextCoefficients(&coefficient, 1);
 
-    return coefficient[coefficientIndex++];
+    return coefficient;
 }
 
+//The next nFrames coefficients, written stride apart
+void Modulator::nextCoefficients(double* coefficients, int nFrames, int stride){
+    const double* table = tables[shape];
+    double now = phase; //kept local so it stays in a register
+    double step = increment;
+    double amount = depth;
+
+    for(int i = 0; i < nFrames; i++){
+        int index = static_cast<int>(now);
+        double fraction = now - index;
+        double wave = table[index] + fraction * (table[index + 1] - table[index]);
+
+        coefficients[i * stride] = 1.0 + amount * wave;
+
+        now += step;
+        if(now >= TABLE_LENGTH)
+            now -= TABLE_LENGTH;
+    }
+
+    phase = now;
+}
@@ -1,20 +1,18 @@
 #ifndef __CHORUS_H__
 #define __CHORUS_H__
 
-#include "RtAudio.h"
+#include "Processor.h"
 #include "Modulator.h"
-#include "FileWvOut.h"
+#include "Interpolation.h"
+#include "Smoother.h"
 
 //Generic Base class for Chorus
-class Chorus{
+class Chorus : public Processor{
 public:
 
         //Destructor
         virtual ~Chorus();
 
-        //callback function
-        virtual int callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData ) = 0;
-
         virtual void initializeDelayBuffer(void) = 0 ;
 
         virtual void destroyDelayBuffer(void) = 0;
@@ -23,34 +21,73 @@ public:
 class MultiChorus : public Chorus{
 public:
     static int MAX_DELAYS; //Static variable for maximum number of stages to chorus
-    static int MAX_BUFFER_LENGTH; //Static variable for maximum buffer length
     static int MAX_MS_DELAY; //Maximum length of the delay (chorus unit delays are short)
 
+    //Live parameters, see Processor::setParameter()
+    enum Parameter {DRY, WET, NUM_PARAMETERS};
+
     //Destructor
     ~MultiChorus(void);
     
     //Default Constructor
     MultiChorus(void);
 
-
-    //Main Setter
+    //Main Setter. The modulators are asked for on input and prompts
     void setMultiChorus(int tDry, int tWet, int tDelay1, int tDelay2, int tDelay3,
-        int tNumDelays, int tNumModulators, bool bandlimited);
+        int tNumDelays, int tNumModulators, bool bandlimited,
+        std::istream& input = std::cin, std::ostream& prompts = std::cout);
+
+    //Live parameter changes, applied between blocks
+    int getNumParameters(void) const;
+    const char* getParameterName(int parameter) const;
+    void setParameter(int parameter, double value);
+
+    //allocates the delay buffers, modulators and sinc table for the stream
+    void prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels);
 
-    //initializes the delayBuffer into an array of proper size
+    //Processes one block, one channel at a time
+    void process(const StkFloat* const* in, StkFloat* const* out, int nFrames);
+
+    //sets the delay buffer length for the current delays and clears the buffers
     void initializeDelayBuffer(void);
 
     //destroys the current delay buffer
     void destroyDelayBuffer(void);
 
-    int callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData );
+private:
+static const char* PARAMETER_NAMES[]; //Menu names of the live parameters
+
+//Delay line state of a single channel
+struct Channel{
+    int writeCell; //Index of the cell to write input samples to
+    double delayCell1; //Index of the first delay in buffer
+    double delayCell2; //Index of the second delay in buffer
+    double delayCell3; //Index of the third delay in buffer
+    double* delayBuffer; //Pointer to the head of the delay buffer
+};
 
-    void tick(void *outputBuffer, void *input,int nBufferFrames);
-    StkFrames& tick(void *input, int nBufferFrames, StkFrames& frames);
+//Interpolation of the delay reads, a template argument of the kernels
+enum InterpKind {LINEAR, BANDLIMITED};
+
+//A whole block of process(), one instantiation per delay, modulator and interpolation count
+typedef void (MultiChorus::*Kernel)(const StkFloat* const* in, StkFloat* const* out, int nFrames);
+
+//The kernel for the current settings, chosen once by setMultiChorus()
+static Kernel selectKernel(int tNumDelays, int tNumModulators, bool bandlimited);
+
+//Body of process(). The delay, modulator and interpolation cases are compile time
+//constants here, so the per-sample loop has no branches on them
+template <int NumDelays, int NumMods, InterpKind Interp>
+void processBlock(const StkFloat* const* in, StkFloat* const* out, int nFrames);
+
+//Wraps delayCell into the buffer and reads it, interpolating if needed
+template <InterpKind Interp>
+double readCell(const double* delayBuffer, double& delayCell, double factor);
 
-private:
 int dry; //Dry signal % (0-100)
 int wet; //Wet signal % (0-100)
+Smoother dryGain; //dry / 100, ramped when it changes live
+Smoother wetGain; //wet / 100, ramped when it changes live
 int delay1; //First delay length 0-MAX_MS_DELAY ms
 int delay2; //Second delay length 0-MAX_MS_DELAY ms
 int delay3; //Third delay length 0-MAX_MS_DELAY ms
@@ -60,18 +97,23 @@ Modulator mod2; //Modulator object 2
 Modulator mod3; //Modulator object 3
 int numModulators; //Number of sample rate modulator objects
 int bufferLength; //Actual buffer length
-int writeCell; //Index of the cell to write input samples to
-double delayCell1; //Index of the first delay in buffer
-double delayCell2; //Index of the second delay in buffer
-double delayCell3; //Index of the third delay in buffer
-double* delayBuffer; //Pointer to the head of the delay buffer
+int maxBufferLength; //Buffer length of twice MAX_MS_DELAY at the prepared rate, headroom for modulation
+double fsPerMs; //Samples per millisecond at the prepared sample rate
+double* factors; //Per-frame modulation factors for each delay, sized for the largest block
+unsigned int maxFrames; //Frames factors has room for
+Channel* channels; //One delay line per channel
+unsigned int numChannels; //Number of delay lines in channels
 bool isBandlimited; //Flags the type of interpolation to use
+Kernel kernel; //processBlock() instantiation for numDelays, numModulators and isBandlimited
+Interpolation::SincInterpolator interpolator; //Polyphase sinc table for bandlimited interpolation
 };
 
 class FeedbackChorus : public Chorus{
 public:
     static int MAX_MS_DELAY; //Maximum length of the delay
-    static int MAX_BUFFER_LENGTH; //Maximum length the delay buffer can be
+
+    //Live parameters, see Processor::setParameter()
+    enum Parameter {DECAY, NUM_PARAMETERS};
 
     //Destructor
     ~FeedbackChorus(void);
@@ -79,28 +121,52 @@ public:
     //Default Constructor
     FeedbackChorus(void);
 
-    //Main Setter
-    void setFeedbackChorus(int tDecay, int tDelay, bool bandlimited);
+    //Main Setter. The modulator is asked for on input and prompts
+    void setFeedbackChorus(int tDecay, int tDelay, bool bandlimited,
+        std::istream& input = std::cin, std::ostream& prompts = std::cout);
+
+    //Live parameter changes, applied between blocks
+    int getNumParameters(void) const;
+    const char* getParameterName(int parameter) const;
+    void setParameter(int parameter, double value);
 
-    //initializes the delayBuffer into an array of proper size
+    //allocates the delay buffers, modulators and sinc table for the stream
+    void prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels);
+
+    //Processes one block, one channel at a time
+    void process(const StkFloat* const* in, StkFloat* const* out, int nFrames);
+
+    //sets the delay buffer length for the current delays and clears the buffers
     void initializeDelayBuffer(void);
     //destroys the current delay buffer
     void destroyDelayBuffer(void);
 
-    int callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData );
+private:
+    static const char* PARAMETER_NAMES[]; //Menu names of the live parameters
 
-    void tick(void *outputBuffer, void *input,int nBufferFrames);
-    StkFrames& tick(void *input, int nBufferFrames, StkFrames& frames);
+    //Delay line state of a single channel
+    struct Channel{
+        int writeCell; //Index of the cell to write feedback+input samples to
+        double delayCell; //Index of the variable delay. Represented as a double because of variable nature of the value
+        double* delayBuffer; //pointer to head of the delay buffer
+    };
+
+    //Wraps delayCell into the buffer and reads it, interpolating if needed
+    double readCell(const double* delayBuffer, double& delayCell, double factor);
 
-private:
     int decay; // % attenuation of feedback signal
+    Smoother feedbackGain; //decay / 100, ramped when it changes live
     int delay; // delay time in ms
     Modulator mod; // Modulator object
     int bufferLength; //actual buffer length
-    int writeCell; //Index of the cell to write feedback+input samples to
-    double delayCell; //Index of the variable delay. Represented as a double because of variable nature of the value
-    double* delayBuffer; //pointer to head of the delay buffer
+    int maxBufferLength; //Buffer length of twice MAX_MS_DELAY at the prepared rate, headroom for modulation
+    double fsPerMs; //Samples per millisecond at the prepared sample rate
+    double* factors; //Per-frame modulation factors for each delay, sized for the largest block
+    unsigned int maxFrames; //Frames factors has room for
+    Channel* channels; //One delay line per channel
+    unsigned int numChannels; //Number of delay lines in channels
     bool isBandlimited; //Flags the type of interpolation to use
+    Interpolation::SincInterpolator interpolator; //Polyphase sinc table for bandlimited interpolation
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,216 @@
+/*
+CombBank.cpp
+
+Definitions of the CombBank class. Parallel comb filters
+run in lockstep over struct-of-arrays delay lines, two
+lanes per SSE2 register.
+*/
+
+#include "CombBank.h"
+
+CombBank::~CombBank(){
+}
+
+CombBank::CombBank(){
+    numCombs = 0;
+    lanes = 0;
+    lowPass = false;
+    precision = Processor::FLOAT64;
+    rows = 1;
+
+    for(int k = 0; k < MAX_COMBS; k++){
+        combs[k] = 0;
+        lowPassCombs[k] = 0;
+        readOffset1[k] = 0;
+        readOffset2[k] = 0;
+        feedback1[k] = 0.0;
+        feedback2[k] = 0.0;
+    }
+}
+
+bool CombBank::addComb(const Comb* comb){
+    if(numCombs == MAX_COMBS || (numCombs > 0 && lowPass))
+        return false;
+
+    lowPass = false;
+    combs[numCombs++] = comb;
+    return true;
+}
+
+bool CombBank::addComb(const LPComb* comb){
+    if(numCombs == MAX_COMBS || (numCombs > 0 && !lowPass))
+        return false;
+
+    lowPass = true;
+    lowPassCombs[numCombs++] = comb;
+    return true;
+}
+
+//Sizes and clears one delay line per channel for the combs' current delays
+void CombBank::prepare(double tSampleRate, unsigned int nChannels){
+    lanes = (numCombs + 1) & ~1; //whole registers, the spare lane runs silent
+    rows = 1;
+
+    //How many samples back each tap of a comb reads, worked out from
+    //its pointers: the delay tap trails the write pointer by lag,
+    //the low-pass tap by lag + 1, both modulo the buffer length.
+    //A tap on the write cell reads before the write, a full buffer back
+    int age1[MAX_COMBS], age2[MAX_COMBS];
+    for(int k = 0; k < lanes; k++){
+        int lag = 0;
+        int length = 1;
+
+        if(k < numCombs){
+            if(lowPass)
+                lowPassCombs[k]->getDelayLine(tSampleRate, lag, length);
+            else
+                combs[k]->getDelayLine(tSampleRate, lag, length);
+        }
+
+        age1[k] = (lag + length - 1) % length + 1;
+        age2[k] = lag % length + 1;
+
+        if(age1[k] > rows)
+            rows = age1[k];
+        if(lowPass && age2[k] > rows)
+            rows = age2[k];
+    }
+
+    for(int k = 0; k < lanes; k++){
+        readOffset1[k] = (rows - age1[k]) * lanes + k;
+        readOffset2[k] = (rows - age2[k]) * lanes + k;
+    }
+
+    rings.allocate(nChannels, rows, lanes, precision);
+}
+
+void CombBank::setPrecision(Processor::Precision tPrecision){
+    precision = tPrecision;
+}
+
+//Runs every comb over nFrames of channel and writes the sum of their outputs
+void CombBank::process(const StkFloat* in, StkFloat* out, int nFrames, unsigned int channel){
+    if(numCombs == 0){
+        for(int i = 0; i < nFrames; i++)
+            out[i] = 0.0;
+        return;
+    }
+
+    loadFeedback();
+
+    MirroredRings::Channel& ch = rings[channel];
+    if(ch.ring32)
+        processLanes(ch.ring32, ch.writeRow, in, out, nFrames);
+    else
+        processLanes(ch.ring, ch.writeRow, in, out, nFrames);
+}
+
+//Every lane reads both taps, the ring is silent until a lane's first echo
+template <class Sample>
+void CombBank::processLanes(Sample* ring, int& writeRow, const StkFloat* in, StkFloat* out, int nFrames){
+    int mirror = rings.getMirror();
+    double comb[MAX_COMBS];
+
+#if defined(__SIMD_SSE2__)
+    const __m128d high = _mm_set1_pd(1.0);
+    const __m128d low = _mm_set1_pd(-1.0);
+    const __m128d highLimit = _mm_set1_pd(0.9999);
+    const __m128d lowLimit = _mm_set1_pd(-0.9999);
+    const __m128d signBit = _mm_set1_pd(-0.0);
+
+    __m128d gain1[MAX_COMBS / 2], gain2[MAX_COMBS / 2], outGain[MAX_COMBS / 2];
+    for(int j = 0; j < lanes / 2; j++){
+        gain1[j] = _mm_loadu_pd(feedback1 + 2 * j);
+        gain2[j] = _mm_loadu_pd(feedback2 + 2 * j);
+        outGain[j] = _mm_xor_pd(gain1[j], signBit); //-feedback1
+    }
+
+    for(int i = 0; i < nFrames; i++){
+        Sample* row = ring + writeRow * lanes;
+        __m128d input = _mm_set1_pd(in[i]);
+
+        for(int j = 0; j < lanes / 2; j++){
+            int a = 2 * j;
+            int b = a + 1;
+
+            //Each lane reads its own tap
+            __m128d delayComponent = _mm_set_pd(row[readOffset1[b]], row[readOffset1[a]]);
+
+            if(lowPass){
+                __m128d older = _mm_set_pd(row[readOffset2[b]], row[readOffset2[a]]);
+                delayComponent = _mm_add_pd(_mm_mul_pd(older, gain2[j]), delayComponent);
+            }
+            delayComponent = _mm_mul_pd(delayComponent, gain1[j]);
+
+            __m128d sum = _mm_add_pd(input, delayComponent);
+
+            //Every lane writes the same row
+            storePair(row + a, sum);
+            storePair(row + mirror + a, sum);
+
+            //Limiting, as a select so no lane branches
+            __m128d y = _mm_mul_pd(sum, outGain[j]);
+            __m128d over = _mm_cmpge_pd(y, high);
+            __m128d under = _mm_cmple_pd(y, low);
+            __m128d limit = _mm_or_pd(_mm_and_pd(over, highLimit), _mm_and_pd(under, lowLimit));
+            y = _mm_or_pd(_mm_andnot_pd(_mm_or_pd(over, under), y), limit);
+
+            _mm_storeu_pd(comb + a, y);
+        }
+
+        //Summed in order so the result matches the reverbs' sums exactly
+        double total = comb[0];
+        for(int k = 1; k < numCombs; k++)
+            total += comb[k];
+        out[i] = total;
+
+        if(++writeRow == rows)
+            writeRow = 0;
+    }
+#else
+    for(int i = 0; i < nFrames; i++){
+        Sample* row = ring + writeRow * lanes;
+
+        for(int k = 0; k < lanes; k++){
+            double delayComponent = row[readOffset1[k]];
+            if(lowPass)
+                delayComponent = row[readOffset2[k]] * feedback2[k] + delayComponent;
+            delayComponent *= feedback1[k];
+
+            double sum = in[i] + delayComponent;
+            row[k] = static_cast<Sample>(sum);
+            row[mirror + k] = static_cast<Sample>(sum);
+
+            double y = sum * (-feedback1[k]);
+            if(y >= 1.0)
+                y = 0.9999;
+            else if(y <= -1.0)
+                y = -0.9999;
+            comb[k] = y;
+        }
+
+        double total = comb[0];
+        for(int k = 1; k < numCombs; k++)
+            total += comb[k];
+        out[i] = total;
+
+        if(++writeRow == rows)
+            writeRow = 0;
+    }
+#endif
+}
+
+//Reads feedback from the combs into the lane arrays
+void CombBank::loadFeedback(){
+    for(int k = 0; k < numCombs; k++){
+        if(lowPass){
+            feedback1[k] = lowPassCombs[k]->getFeedback1();
+            feedback2[k] = lowPassCombs[k]->getFeedback2();
+        }
+        else{
+            feedback1[k] = combs[k]->getFeedback();
+            feedback2[k] = 0.0;
+        }
+    }
+}
+
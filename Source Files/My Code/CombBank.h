@@ -0,0 +1,73 @@
+#ifndef __COMBBANK_H__
+#define __COMBBANK_H__
+
+#include "Filters.h"
+#include "MirroredRings.h"
+#include "Simd.h"
+
+/*  A bank of parallel comb filters that all hear the same input
+    and are summed, as in Reverb2 and Reverb3. The combs run in
+    lockstep, one lane per comb, two lanes per SSE2 register.
+
+    The delay lines are MirroredRings, one lane per comb. All
+    lanes write the same row, so there is one shared write index
+    and one wrap test per sample instead of one per comb, and a
+    row is written with vector stores.
+
+    The bank reproduces the Comb and LPComb it was given: the same
+    taps on a ring that starts silent, feedback, clamp, and the
+    lanes are summed in order. The combs keep their settings. The bank
+    reads their delays in prepare() and their decays every block,
+    so live decay changes need nothing extra.
+*/
+class CombBank{
+public:
+    static const int MAX_COMBS = 8; //Lanes a bank has room for
+
+    ~CombBank(void);
+    CombBank(void);
+
+    //Adds comb as the next lane. A bank runs either Combs or LPCombs, not both.
+    //Returns false if the bank is full or holds the other kind
+    bool addComb(const Comb* comb);
+    bool addComb(const LPComb* comb);
+
+    //Sizes and clears one delay line per channel for the combs' current delays.
+    //Delay changes take effect here, like Comb::prepare()
+    void prepare(double tSampleRate, unsigned int nChannels);
+
+    //Sample type of the rings, heard from the next prepare()
+    void setPrecision(Processor::Precision tPrecision);
+
+    //Runs every comb over nFrames of channel and writes the sum of their outputs
+    void process(const StkFloat* in, StkFloat* out, int nFrames, unsigned int channel);
+
+private:
+    //Per-sample kernel, every lane at once, over a ring of Sample
+    template <class Sample>
+    void processLanes(Sample* ring, int& writeRow, const StkFloat* in, StkFloat* out, int nFrames);
+
+    //Reads feedback from the combs into the lane arrays
+    void loadFeedback(void);
+
+    const Comb* combs[MAX_COMBS]; //Comb of each lane, or 0
+    const LPComb* lowPassCombs[MAX_COMBS]; //LPComb of each lane, or 0
+    int numCombs; //Lanes holding a comb
+    int lanes; //numCombs rounded up to whole registers
+    bool lowPass; //True for a bank of LPCombs
+    Processor::Precision precision; //Sample type of the rings
+
+    int readOffset1[MAX_COMBS]; //Offset from the write row's first lane to the lane's delay tap
+    int readOffset2[MAX_COMBS]; //Same for the tap one sample older (LPComb only)
+    double feedback1[MAX_COMBS]; //Feedback of each lane
+    double feedback2[MAX_COMBS]; //Low-pass feedback of each lane (LPComb only)
+
+    int rows; //Rows in one copy of the ring
+    MirroredRings rings; //One delay line per channel
+
+    //Not copyable, the rings belong to one bank
+    CombBank(const CombBank&);
+    CombBank& operator=(const CombBank&);
+};
+
+#endif
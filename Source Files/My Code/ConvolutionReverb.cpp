@@ -0,0 +1,415 @@
+/*
+ConvolutionReverb.cpp
+
+Definitions of the ConvolutionReverb class. An impulse
+response convolved in two parts: a short-partition head on
+the audio thread and a long-partition tail on its own thread.
+*/
+
+#include "ConvolutionReverb.h"
+#include "Atomic.h"
+#include "MappedWavFile.h"
+#include "FileRead.h"
+#include <cmath>
+
+//static variables
+unsigned int ConvolutionReverb::HEAD_FRAMES = 128;
+unsigned int ConvolutionReverb::TAIL_FRAMES = 4096;
+int ConvolutionReverb::MAX_SECONDS = 20; //20s
+bool ConvolutionReverb::WAIT_FOR_TAIL = true; //the host turns it off for a callback with a deadline
+
+ConvolutionReverb::~ConvolutionReverb(){
+    stopTail();
+    destroyChannels();
+}
+ConvolutionReverb::ConvolutionReverb(){
+    impulseRate = 44100.0;
+
+    channels = 0;
+    numChannels = 0;
+    headLength = 0;
+    hasTail = false;
+    tailThreaded = false;
+    tailWaits = true;
+
+    headFill = 0;
+    tailFill = 0;
+    tailBlocks = 0;
+    tailSubmitted = 0;
+    tailDone = 0;
+    stopping = 0;
+    lateTails = 0;
+
+    setMix(30);
+}
+
+//Reads the impulse response, keeps the one before if the file does not open
+bool ConvolutionReverb::loadImpulse(const std::string& fileName){
+    std::vector< std::vector<double> > loaded;
+    double rate;
+
+    try{
+        FileRead file(fileName);
+        unsigned long frames = file.fileSize();
+        unsigned int nChannels = file.channels();
+        rate = file.fileRate();
+
+        StkFrames data(frames, nChannels);
+        file.read(data, 0, false);
+
+        loaded.resize(nChannels, std::vector<double>(frames));
+        for(unsigned int c = 0; c < nChannels; c++){
+            for(unsigned long i = 0; i < frames; i++)
+                loaded[c][i] = data(i, c);
+        }
+    }
+    catch( StkError & ){
+        //STK does not know every format the mapping reads
+        MappedWavFile mapped;
+        if(!mapped.open(fileName))
+            return false;
+
+        unsigned long frames = mapped.getFrames();
+        unsigned int nChannels = mapped.getChannels();
+        rate = mapped.getFileRate();
+
+        loaded.resize(nChannels, std::vector<double>(frames));
+        std::vector<StkFloat*> out(nChannels);
+        for(unsigned int c = 0; c < nChannels; c++)
+            out[c] = frames ? &loaded[c][0] : 0;
+
+        if(frames)
+            mapped.read(&out[0], frames);
+    }
+
+    if(loaded.empty() || loaded[0].empty())
+        return false;
+
+    impulse.swap(loaded);
+    impulseRate = rate;
+    return true;
+}
+
+bool ConvolutionReverb::hasImpulse() const{
+    return !impulse.empty();
+}
+
+unsigned long ConvolutionReverb::getLateTails() const{
+    return lateTails;
+}
+
+//Resamples and partitions the impulse response, starts the tail thread
+void ConvolutionReverb::prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels){
+    stopTail();
+    destroyChannels();
+
+    dryMix.prepare(tSampleRate);
+    wetMix.prepare(tSampleRate);
+
+    //The response at the stream's rate, linear interpolation is enough for a room
+    unsigned int irChannels = impulse.empty() ? 1 : impulse.size();
+    std::vector< std::vector<double> > resampled(irChannels);
+    long length = 0;
+
+    if(!impulse.empty()){
+        long frames = impulse[0].size();
+        double ratio = impulseRate / tSampleRate; //file frames per stream frame
+        length = static_cast<long>((frames - 1) / ratio) + 1;
+
+        long longest = static_cast<long>(MAX_SECONDS * tSampleRate);
+        if(length > longest)
+            length = longest;
+
+        for(unsigned int c = 0; c < irChannels; c++){
+            resampled[c].resize(length);
+            for(long i = 0; i < length; i++){
+                double position = i * ratio;
+                long index = static_cast<long>(position);
+                if(index > frames - 1)
+                    index = frames - 1;
+                double fraction = position - index;
+                double next = (index + 1 < frames) ? impulse[c][index + 1] : 0.0;
+
+                resampled[c][i] = impulse[c][index] + fraction * (next - impulse[c][index]);
+            }
+        }
+
+        //Unit energy in the loudest channel, so white noise comes out as loud as it went in
+        double energy = 0.0;
+        for(unsigned int c = 0; c < irChannels; c++){
+            double sum = 0.0;
+            for(long i = 0; i < length; i++)
+                sum += resampled[c][i] * resampled[c][i];
+            if(sum > energy)
+                energy = sum;
+        }
+
+        if(energy > 0.0){
+            double gain = 1.0 / sqrt(energy);
+            for(unsigned int c = 0; c < irChannels; c++){
+                for(long i = 0; i < length; i++)
+                    resampled[c][i] *= gain;
+            }
+        }
+    }
+
+    //The head covers the taps the tail thread has no time for
+    headLength = 2 * static_cast<long>(TAIL_FRAMES);
+    hasTail = (length > headLength);
+    if(!hasTail)
+        headLength = length;
+
+    numChannels = nChannels;
+    channels = new Channel[numChannels];
+
+    for(unsigned int c = 0; c < numChannels; c++){
+        Channel& ch = channels[c];
+
+        //A response of fewer channels than the stream is used round robin
+        const double* taps = length ? &resampled[c % irChannels][0] : 0;
+
+        ch.head.setImpulse(taps, headLength, HEAD_FRAMES);
+        ch.headInput = new double[HEAD_FRAMES];
+        ch.headOutput = new double[HEAD_FRAMES];
+        for(unsigned int i = 0; i < HEAD_FRAMES; i++){
+            ch.headInput[i] = 0.0;
+            ch.headOutput[i] = 0.0;
+        }
+
+        for(unsigned int s = 0; s < TAIL_SLOTS; s++){
+            ch.tailInput[s] = 0;
+            ch.tailOutput[s] = 0;
+        }
+        if(hasTail){
+            ch.tail.setImpulse(taps + headLength, length - headLength, TAIL_FRAMES);
+            for(unsigned int s = 0; s < TAIL_SLOTS; s++){
+                ch.tailInput[s] = new double[TAIL_FRAMES];
+                ch.tailOutput[s] = new double[TAIL_FRAMES];
+            }
+        }
+
+        ch.wetBlock = new double[maxBlockSize];
+    }
+
+    headFill = 0;
+    tailFill = 0;
+    tailBlocks = 0;
+    tailSubmitted = 0;
+    tailDone = 0;
+    stopping = 0;
+    lateTails = 0;
+    tailWaits = WAIT_FOR_TAIL;
+
+    tailThreaded = hasTail && tail.start(&ConvolutionReverb::tailThread, (void *)this);
+}
+
+void ConvolutionReverb::process(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+    //Gather the block into head blocks, the wet signal is the head block before
+    int done = 0;
+    while(done < nFrames){
+        int take = HEAD_FRAMES - headFill;
+        if(take > nFrames - done)
+            take = nFrames - done;
+
+        for(unsigned int c = 0; c < numChannels; c++){
+            Channel& ch = channels[c];
+            for(int i = 0; i < take; i++){
+                ch.headInput[headFill + i] = in[c][done + i];
+                ch.wetBlock[done + i] = ch.headOutput[headFill + i];
+            }
+        }
+
+        done += take;
+        headFill += take;
+
+        if(headFill == HEAD_FRAMES)
+            runHead();
+    }
+
+    //Mix gains of this block, every channel walks the same ramps
+    double dryStep, wetStep;
+    double dryStart = dryMix.begin(nFrames, dryStep);
+    double wetStart = wetMix.begin(nFrames, wetStep);
+
+    for(unsigned int c = 0; c < numChannels; c++){
+        const StkFloat *input = in[c];
+        StkFloat *output = out[c];
+        const double *wet = channels[c].wetBlock;
+        double dryNow = dryStart;
+        double wetNow = wetStart;
+
+        for(int i = 0; i<nFrames; i++){
+            StkFloat sample = input[i];
+            computeSample(sample, wet[i], dryNow, wetNow); //sample is passed by reference
+            output[i] = sample;
+
+            dryNow += dryStep;
+            wetNow += wetStep;
+        }
+    }
+
+    dryMix.end(nFrames);
+    wetMix.end(nFrames);
+}
+
+double ConvolutionReverb::computeSample(double& in, double wetComponent, double dryGain, double wetGain){
+    //Compute input component
+    double inComponent = in * dryGain;
+
+    //Adjust wet signal by mix
+    wetComponent *= wetGain;
+
+    in = inComponent + wetComponent;
+
+    //limit output
+    if(in >= 1.0)
+        in = 0.9999;
+    else if(in <= -1.0)
+        in = -0.9999;
+
+    return in;
+}
+
+//Convolves the head block just gathered, adds in the tail and hands the input on to the tail
+void ConvolutionReverb::runHead(){
+    for(unsigned int c = 0; c < numChannels; c++)
+        channels[c].head.process(channels[c].headInput, channels[c].headOutput);
+
+    headFill = 0;
+
+    if(!hasTail)
+        return;
+
+    //The tail starts headLength = 2 * TAIL_FRAMES taps in, so this head
+    //block lines up with the same stretch of the tail block two back
+    if(tailBlocks >= 2){
+        unsigned int block = tailBlocks - 2;
+        while(tailWaits && Atomic::load(tailDone) <= block)
+            Thread::sleep(0); //the tail thread fell behind, a stream without a deadline can wait
+
+        //A callback can't, the head block goes out without its tail
+        if(Atomic::load(tailDone) <= block)
+            lateTails++;
+        else{
+            unsigned int slot = block % TAIL_SLOTS;
+            for(unsigned int c = 0; c < numChannels; c++){
+                const double* tailOut = channels[c].tailOutput[slot] + tailFill;
+                double* headOut = channels[c].headOutput;
+                for(unsigned int i = 0; i < HEAD_FRAMES; i++)
+                    headOut[i] += tailOut[i];
+            }
+        }
+    }
+
+    //The slot was last used by tailBlocks - TAIL_SLOTS, which is done by now.
+    //Only a tail thread that far behind in a real-time stream still needs it,
+    //it then convolves this block's input in its place
+    unsigned int slot = tailBlocks % TAIL_SLOTS;
+    for(unsigned int c = 0; c < numChannels; c++){
+        const double* headIn = channels[c].headInput;
+        double* tailIn = channels[c].tailInput[slot] + tailFill;
+        for(unsigned int i = 0; i < HEAD_FRAMES; i++)
+            tailIn[i] = headIn[i];
+    }
+
+    tailFill += HEAD_FRAMES;
+    if(tailFill == TAIL_FRAMES){
+        tailFill = 0;
+        tailBlocks++;
+
+        if(tailThreaded)
+            Atomic::store(tailSubmitted, tailBlocks);
+        else{
+            runTail(tailBlocks - 1);
+            tailDone = tailBlocks;
+        }
+    }
+}
+
+//Convolves tail block number block of every channel
+void ConvolutionReverb::runTail(unsigned int block){
+    unsigned int slot = block % TAIL_SLOTS;
+
+    for(unsigned int c = 0; c < numChannels; c++)
+        channels[c].tail.process(channels[c].tailInput[slot], channels[c].tailOutput[slot]);
+}
+
+//Tail thread body. Convolves every block handed over, in order, and naps when there is none
+THREAD_RETURN THREAD_TYPE ConvolutionReverb::tailThread(void* ptr){
+    ConvolutionReverb* verb = (ConvolutionReverb *) ptr;
+
+    while(!Atomic::load(verb->stopping)){
+        unsigned int next = verb->tailDone;
+
+        if(next == Atomic::load(verb->tailSubmitted)){
+            Thread::sleep(1);
+            continue;
+        }
+
+        verb->runTail(next);
+
+        //Publish the block only after it is convolved
+        Atomic::store(verb->tailDone, next + 1);
+    }
+
+    return 0;
+}
+
+void ConvolutionReverb::stopTail(){
+    if(tail.isRunning()){
+        Atomic::store(stopping, 1);
+        tail.wait();
+        stopping = 0;
+    }
+    tailThreaded = false;
+}
+
+void ConvolutionReverb::setMix(int tMix){
+    mix = tMix;
+
+    if(mix > 100 || mix < 0)
+        mix = 30;
+
+    //Ramps while streaming, prepare() settles it before
+    dryMix.setTarget((100 - mix) / 100.0);
+    wetMix.setTarget(mix / 100.0);
+}
+
+void ConvolutionReverb::destroyChannels(){
+    for(unsigned int c = 0; c < numChannels; c++){
+        delete[ ] channels[c].headInput;
+        delete[ ] channels[c].headOutput;
+        for(unsigned int s = 0; s < TAIL_SLOTS; s++){
+            delete[ ] channels[c].tailInput[s];
+            delete[ ] channels[c].tailOutput[s];
+        }
+        delete[ ] channels[c].wetBlock;
+    }
+
+    delete[ ] channels;
+    channels = 0;
+    numChannels = 0;
+}
+
+//Live parameter changes, applied between blocks
+const char* ConvolutionReverb::PARAMETER_NAMES[] = {"Mix (0-100)"};
+
+int ConvolutionReverb::getNumParameters() const{
+    return NUM_PARAMETERS;
+}
+const char* ConvolutionReverb::getParameterName(int parameter) const{
+    if(parameter < 0 || parameter >= NUM_PARAMETERS)
+        return "";
+
+    return PARAMETER_NAMES[parameter];
+}
+void ConvolutionReverb::setParameter(int parameter, double value){
+    int amount = static_cast<int>(value);
+
+    switch(parameter){
+        case MIX:
+            if(amount >= 0 && amount <= 100)
+                setMix(amount);
+            break;
+    }
+}
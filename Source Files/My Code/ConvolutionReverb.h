@@ -0,0 +1,127 @@
+#ifndef __CONVOLUTIONREVERB_H__
+#define __CONVOLUTIONREVERB_H__
+
+#include "Processor.h"
+#include "Smoother.h"
+#include "Convolver.h"
+#include "Thread.h"
+#include <string>
+#include <vector>
+
+/*  Convolution reverb. The room is an impulse response read from
+    a .wav file, any sample rate, mono or with one response per
+    channel, and every output sample is the input convolved with it.
+
+    The response is cut in two, non-uniformly. The head, the first
+    2 * TAIL_FRAMES taps, is convolved on the audio thread in short
+    partitions of HEAD_FRAMES, which is all the latency the wet
+    signal has. The tail, everything after it, is convolved in long
+    partitions of TAIL_FRAMES on a background thread: the head hides
+    the time the tail takes, since a tail block is not heard until
+    two tail blocks after its input came in.
+
+    If the tail thread falls behind, a real-time stream never waits
+    for it: the head block goes out without its tail and is counted,
+    see getLateTails(). With WAIT_FOR_TAIL set it waits instead, so
+    the output is the same from run to run. The host sets it for a
+    file render and for a simulated stream at speed 0, neither has a
+    deadline to miss. If the tail thread can't be started, the tail
+    is convolved in line.
+*/
+class ConvolutionReverb : public Processor{
+public:
+    static unsigned int HEAD_FRAMES; //Partition of the head and latency of the wet signal, a power of two
+    static unsigned int TAIL_FRAMES; //Partition of the tail, a power of two and a multiple of HEAD_FRAMES
+    static int MAX_SECONDS; //Longest impulse response kept, the rest is cut off
+    static bool WAIT_FOR_TAIL; //Waits for a late tail block, only for streams without a deadline
+
+    //Live parameters, see Processor::setParameter()
+    enum Parameter {MIX, NUM_PARAMETERS};
+
+    ~ConvolutionReverb(void);
+    ConvolutionReverb(void);
+
+    //Reads the impulse response from fileName. Keeps the one before and returns
+    //false if the file does not open. Heard from the next prepare()
+    bool loadImpulse(const std::string& fileName);
+
+    //True once an impulse response has been loaded
+    bool hasImpulse(void) const;
+
+    //Head blocks that went out without their tail since prepare(), the tail thread was late
+    unsigned long getLateTails(void) const;
+
+    //Resamples the impulse response to the stream, partitions it and starts
+    //the tail thread. Call once before streaming starts
+    void prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels);
+
+    //Processes one block. The convolution runs over the whole block first,
+    //then it is mixed with the dry signal one channel at a time
+    void process(const StkFloat* const* in, StkFloat* const* out, int nFrames);
+
+    //wetComponent is the convolution's output at this sample, dryGain and wetGain are the mix
+    double computeSample(double& in, double wetComponent, double dryGain, double wetGain);
+
+    void setMix(int tMix);
+
+    //Live parameter changes, applied between blocks
+    int getNumParameters(void) const;
+    const char* getParameterName(int parameter) const;
+    void setParameter(int parameter, double value);
+
+private:
+    static const char* PARAMETER_NAMES[]; //Menu names of the live parameters
+    static const unsigned int TAIL_SLOTS = 4; //Tail blocks in flight between the threads
+
+    //Convolution state of a single channel
+    struct Channel{
+        Convolver head; //First 2 * TAIL_FRAMES taps, on the audio thread
+        Convolver tail; //The rest, on the tail thread
+        double* headInput; //HEAD_FRAMES of input being gathered
+        double* headOutput; //Wet output of the last head block, heard while the next one gathers
+        double* tailInput[TAIL_SLOTS]; //Input blocks handed to the tail thread
+        double* tailOutput[TAIL_SLOTS]; //What the tail thread made of them
+        double* wetBlock; //The wet signal of one block
+    };
+
+    //Tail thread body. Convolves every block handed over, in order
+    static THREAD_RETURN THREAD_TYPE tailThread(void* ptr);
+
+    //Convolves the head block just gathered, adds in the tail and hands the input on to the tail
+    void runHead(void);
+
+    //Convolves tail block number block of every channel
+    void runTail(unsigned int block);
+
+    void stopTail(void);
+    void destroyChannels(void);
+
+    int mix; //ratio of Wet / Dry signals
+    Smoother dryMix; //(100 - mix) / 100, ramped when the mix changes live
+    Smoother wetMix; //mix / 100, ramped when the mix changes live
+
+    std::vector< std::vector<double> > impulse; //The response as read, one vector per channel
+    double impulseRate; //Sample rate of the file
+
+    Channel* channels; //One convolution per channel
+    unsigned int numChannels; //Number of channels in channels
+    long headLength; //Taps in the head
+    bool hasTail; //False if the head holds the whole response
+    bool tailThreaded; //False if the tail runs in line
+    bool tailWaits; //WAIT_FOR_TAIL as of prepare()
+
+    unsigned int headFill; //Frames of the current head block gathered so far
+    unsigned int tailFill; //Frames of the current tail block gathered so far
+    unsigned int tailBlocks; //Tail blocks gathered so far
+    volatile unsigned int tailSubmitted; //Tail blocks handed to the tail thread
+    volatile unsigned int tailDone; //Tail blocks the tail thread has finished
+    volatile unsigned int stopping; //Set to ask the tail thread to return
+    volatile unsigned long lateTails; //Only written by the audio thread
+    Thread tail; //Tail thread
+
+    //Not copyable, the buffers and the thread belong to one reverb
+    ConvolutionReverb(const ConvolutionReverb&);
+    ConvolutionReverb& operator=(const ConvolutionReverb&);
+};
+
+#endif
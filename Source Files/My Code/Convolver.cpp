@@ -0,0 +1,140 @@
+/*
+Convolver.cpp
+
+Definitions of the Convolver class. Uniformly partitioned
+overlap-save convolution with a frequency-domain delay line.
+*/
+
+#include "Convolver.h"
+
+Convolver::~Convolver(){
+    destroyBuffers();
+}
+
+Convolver::Convolver(){
+    partition = 0;
+    bins = 0;
+    numPartitions = 0;
+    impulseRe = 0;
+    impulseIm = 0;
+    historyRe = 0;
+    historyIm = 0;
+    newest = 0;
+    window = 0;
+    sumRe = 0;
+    sumIm = 0;
+    result = 0;
+}
+
+//Cuts the impulse into partitions and transforms them
+void Convolver::setImpulse(const double* impulse, long length, int tPartition){
+    destroyBuffers();
+
+    partition = tPartition;
+    bins = partition + 1;
+    numPartitions = static_cast<int>((length + partition - 1) / partition);
+    if(numPartitions < 1)
+        numPartitions = 1; //silent, but the blocks keep flowing
+
+    fft.setSize(2 * partition);
+
+    impulseRe = new double[numPartitions * bins];
+    impulseIm = new double[numPartitions * bins];
+    historyRe = new double[numPartitions * bins];
+    historyIm = new double[numPartitions * bins];
+    window = new double[2 * partition];
+    sumRe = new double[bins];
+    sumIm = new double[bins];
+    result = new double[2 * partition];
+
+    //Each partition zero padded to the transform size, so the
+    //circular convolution of a window holds one clean block
+    for(int p = 0; p < numPartitions; p++){
+        for(int i = 0; i < 2 * partition; i++){
+            long tap = static_cast<long>(p) * partition + i;
+            window[i] = (i < partition && tap < length) ? impulse[tap] : 0.0;
+        }
+        fft.forward(window, impulseRe + p * bins, impulseIm + p * bins);
+    }
+
+    reset();
+}
+
+//Forgets every block of input so far
+void Convolver::reset(){
+    for(int i = 0; i < numPartitions * bins; i++){
+        historyRe[i] = 0.0;
+        historyIm[i] = 0.0;
+    }
+    for(int i = 0; i < 2 * partition; i++)
+        window[i] = 0.0;
+
+    newest = 0;
+}
+
+//One block in, one block out
+void Convolver::process(const double* in, double* out){
+    //Slide the window on by a block
+    for(int i = 0; i < partition; i++){
+        window[i] = window[partition + i];
+        window[partition + i] = in[i];
+    }
+
+    //The newest spectrum goes one slot back, so slot newest + p holds the block p blocks old
+    newest = (newest == 0) ? numPartitions - 1 : newest - 1;
+    fft.forward(window, historyRe + newest * bins, historyIm + newest * bins);
+
+    for(int k = 0; k < bins; k++){
+        sumRe[k] = 0.0;
+        sumIm[k] = 0.0;
+    }
+
+    for(int p = 0; p < numPartitions; p++){
+        int slot = newest + p;
+        if(slot >= numPartitions)
+            slot -= numPartitions;
+
+        const double* xr = historyRe + slot * bins;
+        const double* xi = historyIm + slot * bins;
+        const double* hr = impulseRe + p * bins;
+        const double* hi = impulseIm + p * bins;
+
+        for(int k = 0; k < bins; k++){
+            sumRe[k] += xr[k] * hr[k] - xi[k] * hi[k];
+            sumIm[k] += xr[k] * hi[k] + xi[k] * hr[k];
+        }
+    }
+
+    fft.inverse(sumRe, sumIm, result);
+
+    //The first half wrapped around, the second half is the new block
+    for(int i = 0; i < partition; i++)
+        out[i] = result[partition + i];
+}
+
+int Convolver::getPartitionSize() const{
+    return partition;
+}
+
+int Convolver::getNumPartitions() const{
+    return numPartitions;
+}
+
+void Convolver::destroyBuffers(){
+    delete[ ] impulseRe;
+    impulseRe = 0;
+    delete[ ] impulseIm;
+    impulseIm = 0;
+    delete[ ] historyRe;
+    historyRe = 0;
+    delete[ ] historyIm;
+    historyIm = 0;
+    delete[ ] window;
+    window = 0;
+    delete[ ] sumRe;
+    sumRe = 0;
+    delete[ ] sumIm;
+    sumIm = 0;
+    delete[ ] result;
+    result = 0;
+}
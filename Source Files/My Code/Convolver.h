@@ -0,0 +1,59 @@
+#ifndef __CONVOLVER_H__
+#define __CONVOLVER_H__
+
+#include "FFT.h"
+
+/*  Uniformly partitioned convolution of one channel, overlap-save
+    in the frequency domain. The impulse response is cut into
+    partitions of the same size and each is transformed once. Every
+    block of input is transformed once too and kept in a delay line
+    of spectra, so a block of output costs one forward FFT, one
+    inverse FFT and one complex multiply-add per partition, whatever
+    the length of the impulse response.
+
+    Output comes a block at a time, one block after the input: the
+    block that completes input block k is output block k.
+*/
+class Convolver{
+public:
+    ~Convolver(void);
+    Convolver(void);
+
+    //Cuts length samples of impulse into partitions of tPartition samples, a
+    //power of two, and transforms them. Allocates, call before streaming
+    void setImpulse(const double* impulse, long length, int tPartition);
+
+    //Forgets every block of input so far
+    void reset(void);
+
+    //in holds the next partition samples of input, out receives the next partition samples of output
+    void process(const double* in, double* out);
+
+    int getPartitionSize(void) const;
+    int getNumPartitions(void) const;
+
+private:
+    void destroyBuffers(void);
+
+    FFT fft; //Transforms of twice the partition
+    int partition; //Samples per block
+    int bins; //Bins of each spectrum, partition + 1
+    int numPartitions; //Partitions of the impulse response
+
+    double* impulseRe; //numPartitions spectra of the impulse response, real parts
+    double* impulseIm; //Imaginary parts
+    double* historyRe; //Spectra of the last numPartitions input blocks, a ring
+    double* historyIm; //Imaginary parts
+    int newest; //Ring slot of the newest input spectrum
+
+    double* window; //The previous and the new block of input
+    double* sumRe; //Spectrum of the output block
+    double* sumIm; //Imaginary parts
+    double* result; //Inverse of sum, its second half is the output
+
+    //Not copyable, the buffers belong to one convolver
+    Convolver(const Convolver&);
+    Convolver& operator=(const Convolver&);
+};
+
+#endif
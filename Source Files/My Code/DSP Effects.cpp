@@ -13,11 +13,50 @@ To this point effects included are:
 
 The code of this file is the main() method
 that actually executes all the included code
+
+Run without arguments for the interactive menus.
+Run with a job manifest (see BatchRenderer.h) to
+render every job in it without any questions:
+
+    "DSP Effects" <manifest> [threads] [float32 | compare]
+
+float32 stores the reverbs' delay lines as float,
+compare renders every job both ways and reports the
+difference.
+
+Options for the output go before either, see
+AudioHandler::setOption():
+
+    api=alsa|jack|oss|core|asio|ds|dummy  device=<n>
+    buffer=<frames>  periods=<n>  priority=<1-99>
+    stats=<seconds>  speed=<x>  jitter=<0-1>
+    threads=<n>  minimize  share
+
+device= takes a number "devices" lists, give api=
+before it if it is not the default one. A device
+that refuses the stream falls back to the simulated
+output.
+
+stats= reports the callback's timing on clog every
+so many seconds while streaming, it is off by default.
+speed= and jitter= set the clock of the simulated
+output: simulated seconds per real second, 0 for back
+to back, and the largest shift of a callback as a
+fraction of the buffer period. threads= is how many
+threads render a feed-forward effect into a file, 0,
+the default, for one per processor.
+
+"DSP Effects" devices lists the APIs and output
+devices to pick from.
 */
 
 //Includes
 #include "AudioHandler.h"
+#include "BatchRenderer.h"
 #include <iostream>
+#include <cstdlib>
+#include <string>
+#include <vector>
 
 //End Includes
 
@@ -27,7 +66,66 @@ using std::endl;
 using std::cin;
 //End Using directives
 
-int main(){
+//Prints the command line, as the comment at the top describes it
+static void printUsage(){
+    cout << "Usage: \"DSP Effects\" [options] [<manifest> [threads] [float32 | compare]]" << endl;
+    cout << "       \"DSP Effects\" [api=<api>] devices" << endl;
+    cout << "Options: api=alsa|jack|oss|core|asio|ds|dummy device=<n> buffer=<frames>" << endl;
+    cout << "         periods=<n> priority=<1-99> stats=<seconds> speed=<x> jitter=<0-1>" << endl;
+    cout << "         threads=<n> minimize share" << endl;
+}
+
+int main(int argc, char* argv[]){
+    //Output options are taken out first, the audio API is picked when the AudioHandler is made
+    std::vector<std::string> arguments;
+    bool list = false;
+
+    for(int a = 1; a < argc; a++){
+        std::string option = argv[a];
+
+        if(option == "devices")
+            list = true;
+        else if(AudioHandler::setOption(option))
+            continue;
+        else if(option.find('=') != std::string::npos){
+            cout << "Invalid option " << option << "." << endl;
+            printUsage();
+            return 1;
+        }
+        else
+            arguments.push_back(option);
+    }
+
+    if(list){
+        AudioHandler::listDevices();
+        return 0;
+    }
+
+    //Batch mode, nothing is asked
+    if(!arguments.empty()){
+        BatchRenderer batch;
+        unsigned int threads = 0; //0 is one per processor
+
+        for(unsigned int a = 1; a < arguments.size(); a++){
+            if(arguments[a] == "float32")
+                batch.setPrecision(Processor::FLOAT32);
+            else if(arguments[a] == "compare")
+                batch.setCompare(true);
+            else if(arguments[a].find_first_not_of("0123456789") == std::string::npos)
+                threads = std::atoi(arguments[a].c_str());
+            else{
+                cout << "Unknown argument " << arguments[a] << "." << endl;
+                printUsage();
+                return 1;
+            }
+        }
+
+        if(!batch.loadManifest(arguments[0].c_str()))
+            return 1;
+
+        return batch.run(threads) ? 0 : 1;
+    }
+
     AudioHandler audio;
     
     bool finished = false;
@@ -42,8 +140,10 @@ int main(){
 
         audio.openOutput();
 
+        audio.tweakEffect();
+
         while(!AudioHandler::done){
-            Stk::sleep(3000);
+            Thread::sleep(3000);
         }
 
         audio.closeOutput();
@@ -7,22 +7,34 @@ FeedbackDelay
 Coded by Richard Marscher for use with the Synthesis ToolKit C++ Libraries
 */
 
-#include "AudioHandler.h"
 #include "Delays.h"
+#include "Interpolation.h"
+#include <iostream>
+
+using Interpolation::linInterp;
 
 using std::cout;
 using std::cin;
 using std::endl;
 
-//Global variable used
-const double fsPerMs = (AudioHandler::fs / 1000.0);
-
 //Define destructor of Delay
 Delay::~Delay(){}
 
+//Reads the delay buffer between two cells with linear interpolation,
+//used while a read head glides to a new delay time
+double Delay::readFraction(const double* delayBuffer, int bufferLength, double delayCell){
+    if(delayCell < 0)
+        delayCell += bufferLength;
+
+    int delayCellInt = static_cast<int>(delayCell);
+    int delayCellPlus = (delayCellInt + 1) % bufferLength;
+    double slope = delayBuffer[delayCellPlus] - delayBuffer[delayCellInt];
+
+    return linInterp(delayCell - delayCellInt, slope, delayBuffer[delayCellInt]);
+}
+
 //***** Single Delay Definitions ***********************
 int SingleDelay::MAX_MS_DELAY = 1000; //1000 ms
-int SingleDelay::MAX_BUFFER_LENGTH = static_cast<int>((SingleDelay::MAX_MS_DELAY / 1000.0) * AudioHandler::fs);
 
 SingleDelay::~SingleDelay(){
     destroyDelayBuffer();
@@ -32,89 +44,70 @@ SingleDelay::SingleDelay(){
     dry = 0.9;
     wet = 0.5;
     delay = 200;
-    bufferCell = 0;
-    bufferLength = 2 + (delay / 1000.0) * MAX_BUFFER_LENGTH; 
-
-    initializeDelayBuffer();
-}
-
-void SingleDelay::tick(void *output, void *input, int nBufferFrames){
-    register StkFloat *out = (StkFloat *) output;
-    FileWvIn *in = (FileWvIn *) input;
-    
-    StkFrames frames;
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
-
-    for(unsigned int i = 0; i<frames.size(); i++){
-        if(bufferCell >= bufferLength)
-            bufferCell %= bufferLength;
-
-        delayBuffer[bufferCell++] = frames[i];
-        //If delay milliseconds have passed since the delay buffer was initialized then add in delay
-        if(delayCell >= 0){
-            *out = (frames[i] * dry) + (delayBuffer[delayCell % bufferLength] * wet);  //Sum the current input and the correct delay buffer cell
-        }
-        else{
-            *out = (frames[i] * dry);
-        }
-
-        //limit signal
-        if(*out > 1.0)
-            *out = 0.999;
-        else if(frames[i] < -1.0)
-            *out = -0.999;
-
-        out++;
-        delayCell++;
-    }
-}
+    channels = 0;
+    numChannels = 0;
+    sampleRate = 0.0;
+    fsPerMs = 0.0;
+    maxBufferLength = 0;
+    bufferLength = 2;
+}
+
+void SingleDelay::process(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+    //Gains and delay time of this block, every channel walks the same ramps
+    double dryStep, wetStep, delayStep;
+    double dryStart = dryGain.begin(nFrames, dryStep);
+    double wetStart = wetGain.begin(nFrames, wetStep);
+    double delayStart = delayTime.begin(nFrames, delayStep);
+    bool gliding = delayTime.isRamping();
+
+    for(unsigned int c = 0; c < numChannels; c++){
+        Channel &ch = channels[c];
+        const StkFloat *input = in[c];
+        StkFloat *output = out[c];
+        double dryNow = dryStart;
+        double wetNow = wetStart;
+        double delayNow = delayStart;
+
+        for(int i = 0; i<nFrames; i++){
+            StkFloat sample = input[i];
+            if(ch.bufferCell >= bufferLength)
+                ch.bufferCell %= bufferLength;
+
+            int writeCell = ch.bufferCell;
+            ch.delayBuffer[ch.bufferCell++] = sample;
+            //The read head is gliding to a new delay time, read between the cells
+            if(gliding){
+                sample = (sample * dryNow) + (readFraction(ch.delayBuffer, bufferLength, writeCell - delayNow) * wetNow);
+            }
+            //If delay milliseconds have passed since the delay buffer was initialized then add in delay
+            else if(ch.delayCell >= 0){
+                sample = (sample * dryNow) + (ch.delayBuffer[ch.delayCell % bufferLength] * wetNow);  //Sum the current input and the correct delay buffer cell
+            }
+            else{
+                sample = (sample * dryNow);
+            }
 
-StkFrames& SingleDelay::tick(void *input, int nBufferFrames, StkFrames& frames){
-    FileWvIn *in = (FileWvIn *) input;
-    
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
+            if(sample > 1.0)
+                sample = 0.999;
+            else if(sample < -1.0)
+                sample = -0.999;
 
-    for(unsigned int i = 0; i<frames.size(); i++){
-        if(bufferCell >= bufferLength)
-            bufferCell %= bufferLength;
+            ch.delayCell++;
+            dryNow += dryStep;
+            wetNow += wetStep;
+            delayNow += delayStep;
 
-        delayBuffer[bufferCell++] = frames[i];
-        //If delay milliseconds have passed since the delay buffer was initialized then add in delay
-        if(delayCell >= 0){
-            frames[i] = (frames[i] * dry) + (delayBuffer[delayCell % bufferLength] * wet);  //Sum the current input and the correct delay buffer cell
-        }
-        else{
-            frames[i] = (frames[i] * dry);
+            output[i] = sample;
         }
-
-        if(frames[i] > 1.0)
-            frames[i] = 0.999;
-        else if(frames[i] < -1.0)
-            frames[i] = -0.999;
-
-        delayCell++;
     }
 
-    return frames;
-}
-
-int SingleDelay::callback(void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData){
-    FileWvIn *input = (FileWvIn *) userData;
-        
-    tick(outputBuffer, input, nBufferFrames); 
+    dryGain.end(nFrames);
+    wetGain.end(nFrames);
+    delayTime.end(nFrames);
 
-    if ( input->isFinished() ) {
-        AudioHandler::done = true;
-        return 1;
-    }
-    else
-        return 0;
+    //The glide is over, go back to reading whole cells
+    if(gliding && !delayTime.isRamping())
+        moveDelayCells();
 }
 
 void SingleDelay::setSingleDelay(double tDry, double tWet, unsigned int tDelay){
@@ -122,9 +115,6 @@ void SingleDelay::setSingleDelay(double tDry, double tWet, unsigned int tDelay){
         dry = tDry;
         wet = tWet;
         delay = tDelay;
-        bufferCell = 0;
-        delayCell = (int) (-1) * (fsPerMs * delay);
-        bufferLength = 2 + (delay / 1000.0) * MAX_BUFFER_LENGTH; 
 
         initializeDelayBuffer();
     }
@@ -136,9 +126,6 @@ void SingleDelay::setSingleDelay(){
     dry = 1.0;
     wet = 0.0;
     delay = 200;
-    bufferCell = 0;
-    delayCell = (int) (-1) * (fsPerMs * delay);
-    bufferLength = 2 + (delay / 1000.0) * MAX_BUFFER_LENGTH; 
 
     initializeDelayBuffer();
 }
@@ -150,31 +137,112 @@ void SingleDelay::setWet(double tWet){
     if(tWet >= 0.0 && tWet <= 1.0)
         wet = tWet;
 }
+//Glides to the new delay, the history in the buffer is kept
 void SingleDelay::setDelay(unsigned int tDelay){
-    if(tDelay >= 0 && tDelay <= 1000)
+    if(tDelay >= 0 && tDelay <= 1000){
         delay = tDelay;
+        delayTime.setTarget(static_cast<int>(fsPerMs * delay));
+    }
+}
+
+//allocates the delay buffers at their maximum length for the stream
+void SingleDelay::prepare(double tSampleRate, unsigned int /*maxBlockSize*/, unsigned int nChannels){
+    destroyDelayBuffer();
+
+    sampleRate = tSampleRate;
+    fsPerMs = sampleRate / 1000.0;
+    maxBufferLength = static_cast<int>((MAX_MS_DELAY / 1000.0) * sampleRate);
 
-    bufferLength = 2 + (delay / 1000.0) * MAX_BUFFER_LENGTH; 
+    numChannels = nChannels;
+    channels = new Channel[numChannels];
+
+    for(unsigned int c = 0; c < numChannels; c++)
+        channels[c].delayBuffer = new double[2 + maxBufferLength];
+
+    dryGain.prepare(sampleRate);
+    wetGain.prepare(sampleRate);
+    delayTime.prepare(sampleRate);
 
     initializeDelayBuffer();
 }
 
-//initializes the delayBuffer into an array of proper size
+//clears the buffers and sets the delay cells for the current delay
 void SingleDelay::initializeDelayBuffer(){
-    destroyDelayBuffer();
+    bufferLength = 2 + maxBufferLength;
+
+    //Nothing is playing yet, start without ramps
+    dryGain.setValue(dry);
+    wetGain.setValue(wet);
+    delayTime.setValue(static_cast<int>(fsPerMs * delay));
+
+    for(unsigned int c = 0; c < numChannels; c++){
+        for(int i = 0; i < bufferLength; i++)
+            channels[c].delayBuffer[i] = 0.0;
 
-    delayBuffer = new double[bufferLength];
+        channels[c].bufferCell = 0;
+        channels[c].delayCell = (int) (-1) * (fsPerMs * delay);
+    }
 }
 //destroys the current delay buffer
 void SingleDelay::destroyDelayBuffer(){
-    delete[ ] delayBuffer;
-    delayBuffer = 0; 
+    for(unsigned int c = 0; c < numChannels; c++)
+        delete[ ] channels[c].delayBuffer;
+
+    delete[ ] channels;
+    channels = 0; 
+    numChannels = 0;
+}
+
+//Moves the delay cells to the current delay, keeping what is in the buffers
+void SingleDelay::moveDelayCells(){
+    for(unsigned int c = 0; c < numChannels; c++){
+        int cell = channels[c].bufferCell - (int) (fsPerMs * delay);
+
+        //Read back into what the buffer already holds instead of restarting the delay
+        if(cell < 0)
+            cell += bufferLength;
+
+        channels[c].delayCell = cell;
+    }
+}
+
+//The longest delay, the output is the input mixed with delayed copies of it
+long SingleDelay::getMemoryFrames() const{
+    return static_cast<long>(fsPerMs * delay);
+}
+
+//Live parameter changes, applied between blocks
+const char* SingleDelay::PARAMETER_NAMES[] = {"Dry (0.0-1.0)", "Wet (0.0-1.0)", "Delay (ms)"};
+
+int SingleDelay::getNumParameters() const{
+    return NUM_PARAMETERS;
+}
+const char* SingleDelay::getParameterName(int parameter) const{
+    if(parameter < 0 || parameter >= NUM_PARAMETERS)
+        return "";
+
+    return PARAMETER_NAMES[parameter];
+}
+void SingleDelay::setParameter(int parameter, double value){
+    switch(parameter){
+        case DRY:
+            setDry(value);
+            dryGain.setTarget(dry);
+            break;
+        case WET:
+            setWet(value);
+            wetGain.setTarget(wet);
+            break;
+        case DELAY:
+            if(value >= 0 && value <= MAX_MS_DELAY)
+                setDelay(static_cast<unsigned int>(value));
+            break;
+    }
 }
 
 
 //*********** Double Delay Definitions ******************
 int DoubleDelay::MAX_MS_DELAY = 1000; //1000 ms
-int DoubleDelay::MAX_BUFFER_LENGTH = static_cast<int>((DoubleDelay::MAX_MS_DELAY / 1000.0) * AudioHandler::fs);
 
 DoubleDelay::~DoubleDelay(){
     destroyDelayBuffer();
@@ -186,124 +254,101 @@ DoubleDelay::DoubleDelay(){
     wet2 = 0.3;
     delay1 = 100;
     delay2 = 200;
-    bufferCell = 0;
-    bufferLength = 2 + (delay2 / 1000.0) * MAX_BUFFER_LENGTH; 
-
-    initializeDelayBuffer();
-}
-
-void DoubleDelay::tick(void *output, void *input, int nBufferFrames){
-    register StkFloat *out = (StkFloat *) output;
-    FileWvIn *in = (FileWvIn *) input;
-    
-    StkFrames frames;
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
-
-    for(unsigned int i = 0; i<frames.size(); i++){
-        if(bufferCell >= bufferLength)
-            bufferCell %= bufferLength;
-
-        delayBuffer[bufferCell++] = frames[i];
-        //If delay1 milliseconds have passed since the delay buffer was initialized then add in delay1
-        if(delayCell1 >= 0){
-            //If delay2 milliseconds have passed since the delay buffer was initialized then add in delay2
-            if(delayCell2 >= 0){
-                *out = (frames[i] * dry) + 
-                    (delayBuffer[delayCell1 % bufferLength] * wet1) +
-                    (delayBuffer[delayCell2 % bufferLength] * wet2);  //Sum the current input and the correct delay buffer cells
-
+    channels = 0;
+    numChannels = 0;
+    sampleRate = 0.0;
+    fsPerMs = 0.0;
+    maxBufferLength = 0;
+    bufferLength = 2;
+}
+
+void DoubleDelay::process(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+    //Gains and delay times of this block, every channel walks the same ramps
+    double dryStep, wet1Step, wet2Step, delay1Step, delay2Step;
+    double dryStart = dryGain.begin(nFrames, dryStep);
+    double wet1Start = wet1Gain.begin(nFrames, wet1Step);
+    double wet2Start = wet2Gain.begin(nFrames, wet2Step);
+    double delay1Start = delayTime1.begin(nFrames, delay1Step);
+    double delay2Start = delayTime2.begin(nFrames, delay2Step);
+    bool gliding = delayTime1.isRamping() || delayTime2.isRamping();
+
+    for(unsigned int c = 0; c < numChannels; c++){
+        Channel &ch = channels[c];
+        const StkFloat *input = in[c];
+        StkFloat *output = out[c];
+        double dryNow = dryStart;
+        double wet1Now = wet1Start;
+        double wet2Now = wet2Start;
+        double delay1Now = delay1Start;
+        double delay2Now = delay2Start;
+
+        for(int i = 0; i<nFrames; i++){
+            StkFloat sample = input[i];
+            if(ch.bufferCell >= bufferLength)
+                ch.bufferCell %= bufferLength;
+
+            int writeCell = ch.bufferCell;
+            ch.delayBuffer[ch.bufferCell++] = sample;
+            //A read head is gliding to a new delay time, read both between the cells
+            if(gliding){
+                sample = (sample * dryNow) +
+                    (readFraction(ch.delayBuffer, bufferLength, writeCell - delay1Now) * wet1Now) +
+                    (readFraction(ch.delayBuffer, bufferLength, writeCell - delay2Now) * wet2Now);
+            }
+            //If delay1 milliseconds have passed since the delay buffer was initialized then add in delay1
+            else if(ch.delayCell1 >= 0){
+                //If delay2 milliseconds have passed since the delay buffer was initialized then add in delay2
+                if(ch.delayCell2 >= 0){
+                    sample = (sample * dryNow) + 
+                        (ch.delayBuffer[ch.delayCell1 % bufferLength] * wet1Now) +
+                        (ch.delayBuffer[ch.delayCell2 % bufferLength] * wet2Now);  //Sum the current input and the correct delay buffer cells
+
+                }
+                //Delay2 is not ready yet
+                else{
+                    sample = (sample * dryNow) + (ch.delayBuffer[ch.delayCell1 % bufferLength] * wet1Now);
+                }
             }
-            //Delay2 is not ready yet
             else{
-                *out = (frames[i] * dry) + (delayBuffer[delayCell1 % bufferLength] * wet1);
+                sample = (sample * dryNow);
             }
-        }
-        else{
-            *out = (frames[i] * dry);
-        }
-
-        //limit signal
-        if(*out > 1.0)
-            *out = 0.999;
-        else if(frames[i] < -1.0)
-            *out = -0.999;
-
-        out++;
-        delayCell1++;
-        delayCell2++;
-    }
-}
-
-StkFrames& DoubleDelay::tick(void *input, int nBufferFrames, StkFrames& frames){
-    FileWvIn *in = (FileWvIn *) input;
-    
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
 
-    for(unsigned int i = 0; i<frames.size(); i++){
-        if(bufferCell >= bufferLength)
-            bufferCell %= bufferLength;
+            if(sample > 1.0)
+                sample = 0.999;
+            else if(sample < -1.0)
+                sample = -0.999;
 
-        delayBuffer[bufferCell++] = frames[i];
-        //If delay1 milliseconds have passed since the delay buffer was initialized then add in delay1
-        if(delayCell1 >= 0){
-            //If delay2 milliseconds have passed since the delay buffer was initialized then add in delay2
-            if(delayCell2 >= 0){
-                frames[i] = (frames[i] * dry) + 
-                    (delayBuffer[delayCell1 % bufferLength] * wet1) +
-                    (delayBuffer[delayCell2 % bufferLength] * wet2);  //Sum the current input and the correct delay buffer cells
+            ch.delayCell1++;
+            ch.delayCell2++;
+            dryNow += dryStep;
+            wet1Now += wet1Step;
+            wet2Now += wet2Step;
+            delay1Now += delay1Step;
+            delay2Now += delay2Step;
 
-            }
-            //Delay2 is not ready yet
-            else{
-                frames[i] = (frames[i] * dry) + (delayBuffer[delayCell1 % bufferLength] * wet1);
-            }
-        }
-        else{
-            frames[i] = (frames[i] * dry);
+            output[i] = sample;
         }
-
-        if(frames[i] > 1.0)
-            frames[i] = 0.999;
-        else if(frames[i] < -1.0)
-            frames[i] = -0.999;
-
-        delayCell1++;
-        delayCell2++;
     }
 
-    return frames;
-}
+    dryGain.end(nFrames);
+    wet1Gain.end(nFrames);
+    wet2Gain.end(nFrames);
+    delayTime1.end(nFrames);
+    delayTime2.end(nFrames);
 
-int DoubleDelay::callback(void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData){
-    FileWvIn *input = (FileWvIn *) userData;
-        
-    tick(outputBuffer, input, nBufferFrames); 
-
-    if ( input->isFinished() ) {
-        AudioHandler::done = true;
-        return 1;
-    }
-    else
-        return 0;
+    //Both glides are over, go back to reading whole cells
+    if(gliding && !delayTime1.isRamping() && !delayTime2.isRamping())
+        moveDelayCells();
 }
 
+
 void DoubleDelay::setDoubleDelay(){
     dry = 1.0;
     wet1 = 0.0;
     wet2 = 0.0;
     delay1 = 200;
     delay2 = 400;
-    bufferCell = 0;
-    delayCell1 = (int) (-1) * (fsPerMs * delay1);
-    delayCell2 = (int) (-1) * (fsPerMs * delay2);
 
-    bufferLength = 2 + (delay2 / 1000.0) * MAX_BUFFER_LENGTH; 
 
     initializeDelayBuffer();
 }
@@ -324,10 +369,6 @@ void DoubleDelay::setDoubleDelay(double tDry, double tWet1, double tWet2, unsign
             delay2 = tDelay2;
         }
         
-        bufferCell = 0;
-        delayCell1 = (int) (-1) * (fsPerMs * delay1);
-        delayCell2 = (int) (-1) * (fsPerMs * delay2);
-        bufferLength = 2 + (delay2 / 1000.0) * MAX_BUFFER_LENGTH; 
 
         initializeDelayBuffer();
     }
@@ -344,38 +385,143 @@ void DoubleDelay::setWet1(double tWet1){
     if(tWet1 >= 0.0 && tWet1 <= 1.0)
         wet1 = tWet1;
 }
+//Glides to the new delay, the history in the buffer is kept
 void DoubleDelay::setDelay1(unsigned int tDelay1){
-    if(tDelay1 >= 0 && tDelay1 <= 1000)
+    if(tDelay1 >= 0 && tDelay1 <= 1000){
         delay1 = tDelay1;
+        delayTime1.setTarget(static_cast<int>(fsPerMs * delay1));
+    }
 }
 void DoubleDelay::setWet2(double tWet2){
     if(tWet2 >= 0.0 && tWet2 <= 1.0)
         wet2 = tWet2;
 }
+//Glides to the new delay, the history in the buffer is kept
 void DoubleDelay::setDelay2(unsigned int tDelay2){
-    if(tDelay2 >= 0 && tDelay2 <= 1000)
+    if(tDelay2 >= 0 && tDelay2 <= 1000){
         delay2 = tDelay2;
+        delayTime2.setTarget(static_cast<int>(fsPerMs * delay2));
+    }
+}
+
+//allocates the delay buffers at their maximum length for the stream
+void DoubleDelay::prepare(double tSampleRate, unsigned int /*maxBlockSize*/, unsigned int nChannels){
+    destroyDelayBuffer();
+
+    sampleRate = tSampleRate;
+    fsPerMs = sampleRate / 1000.0;
+    maxBufferLength = static_cast<int>((MAX_MS_DELAY / 1000.0) * sampleRate);
 
-    bufferLength = 2 + (delay2 / 1000.0) * MAX_BUFFER_LENGTH; 
+    numChannels = nChannels;
+    channels = new Channel[numChannels];
+
+    for(unsigned int c = 0; c < numChannels; c++)
+        channels[c].delayBuffer = new double[2 + maxBufferLength];
+
+    dryGain.prepare(sampleRate);
+    wet1Gain.prepare(sampleRate);
+    wet2Gain.prepare(sampleRate);
+    delayTime1.prepare(sampleRate);
+    delayTime2.prepare(sampleRate);
 
     initializeDelayBuffer();
 }
 
-//initializes the delayBuffer into an array of proper size
+//clears the buffers and sets the delay cells for the current delays
 void DoubleDelay::initializeDelayBuffer(){
-    destroyDelayBuffer();
-
-    delayBuffer = new double[bufferLength];
+    bufferLength = 2 + maxBufferLength;
+
+    //Nothing is playing yet, start without ramps
+    dryGain.setValue(dry);
+    wet1Gain.setValue(wet1);
+    wet2Gain.setValue(wet2);
+    delayTime1.setValue(static_cast<int>(fsPerMs * delay1));
+    delayTime2.setValue(static_cast<int>(fsPerMs * delay2));
+
+    for(unsigned int c = 0; c < numChannels; c++){
+        for(int i = 0; i < bufferLength; i++)
+            channels[c].delayBuffer[i] = 0.0;
+
+        channels[c].bufferCell = 0;
+        channels[c].delayCell1 = (int) (-1) * (fsPerMs * delay1);
+        channels[c].delayCell2 = (int) (-1) * (fsPerMs * delay2);
+    }
 }
 //destroys the current delay buffer
 void DoubleDelay::destroyDelayBuffer(){
-    delete[ ] delayBuffer;
-    delayBuffer = 0; 
+    for(unsigned int c = 0; c < numChannels; c++)
+        delete[ ] channels[c].delayBuffer;
+
+    delete[ ] channels;
+    channels = 0; 
+    numChannels = 0;
+}
+
+//Moves the delay cells to the current delays, keeping what is in the buffers
+void DoubleDelay::moveDelayCells(){
+    for(unsigned int c = 0; c < numChannels; c++){
+        int cell1 = channels[c].bufferCell - (int) (fsPerMs * delay1);
+        int cell2 = channels[c].bufferCell - (int) (fsPerMs * delay2);
+
+        //Read back into what the buffer already holds instead of restarting the delays
+        if(cell1 < 0)
+            cell1 += bufferLength;
+        if(cell2 < 0)
+            cell2 += bufferLength;
+
+        channels[c].delayCell1 = cell1;
+        channels[c].delayCell2 = cell2;
+    }
+}
+
+//The longest delay, the output is the input mixed with delayed copies of it
+long DoubleDelay::getMemoryFrames() const{
+    unsigned int longest = (delay1 > delay2) ? delay1 : delay2;
+
+    return static_cast<long>(fsPerMs * longest);
+}
+
+//Live parameter changes, applied between blocks
+const char* DoubleDelay::PARAMETER_NAMES[] = {"Dry (0.0-1.0)", "Wet of the short delay (0.0-1.0)", "Short delay (ms)",
+    "Wet of the long delay (0.0-1.0)", "Long delay (ms)"};
+
+int DoubleDelay::getNumParameters() const{
+    return NUM_PARAMETERS;
+}
+const char* DoubleDelay::getParameterName(int parameter) const{
+    if(parameter < 0 || parameter >= NUM_PARAMETERS)
+        return "";
+
+    return PARAMETER_NAMES[parameter];
+}
+void DoubleDelay::setParameter(int parameter, double value){
+    switch(parameter){
+        case DRY:
+            setDry(value);
+            dryGain.setTarget(dry);
+            break;
+        case WET1:
+            setWet1(value);
+            wet1Gain.setTarget(wet1);
+            break;
+        case WET2:
+            setWet2(value);
+            wet2Gain.setTarget(wet2);
+            break;
+        //Both delays read the same full length buffer, so either one may be the longest
+        case DELAY1:
+            if(value >= 0 && value <= MAX_MS_DELAY)
+                setDelay1(static_cast<unsigned int>(value));
+            break;
+        case DELAY2:
+            if(value >= 0 && value <= MAX_MS_DELAY)
+                setDelay2(static_cast<unsigned int>(value));
+            break;
+    }
 }
 
 //************ Feedback Delay Definitions ******************
 int FeedbackDelay::MAX_MS_DELAY = 1000; //1000 ms
-int FeedbackDelay::MAX_BUFFER_LENGTH = static_cast<int>((FeedbackDelay::MAX_MS_DELAY / 1000.0) * AudioHandler::fs);
 
 FeedbackDelay::~FeedbackDelay(){
     destroyDelayBuffer();
@@ -384,115 +530,91 @@ FeedbackDelay::FeedbackDelay(){
     gain = 1.0;
     decay = 60;
     delay = 100;
-    bufferCell = 0;
-    bufferLength = 2 + (delay / 1000.0) * MAX_BUFFER_LENGTH; 
-
-    initializeDelayBuffer();
-}
-
-void FeedbackDelay::tick(void *output, void *input,int nBufferFrames){
-    register StkFloat *out = (StkFloat *) output;
-    FileWvIn *in = (FileWvIn *) input;
-    
-    StkFrames frames;
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
+    channels = 0;
+    numChannels = 0;
+    sampleRate = 0.0;
+    fsPerMs = 0.0;
+    maxBufferLength = 0;
+    bufferLength = 2;
+}
+
+void FeedbackDelay::process(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+    //Gains and delay time of this block, every channel walks the same ramps
+    double gainStep, feedbackStep, delayStep;
+    double gainStart = outputGain.begin(nFrames, gainStep);
+    double feedbackStart = feedbackGain.begin(nFrames, feedbackStep);
+    double delayStart = delayTime.begin(nFrames, delayStep);
+    bool gliding = delayTime.isRamping();
+
+    for(unsigned int c = 0; c < numChannels; c++){
+        Channel &ch = channels[c];
+        const StkFloat *input = in[c];
+        StkFloat *output = out[c];
+        double gainNow = gainStart;
+        double feedbackNow = feedbackStart;
+        double delayNow = delayStart;
+
+        for(int i = 0; i<nFrames; i++){
+            StkFloat sample = input[i];
+            //The read head is gliding to a new delay time, read between the cells
+            if(gliding){
+                if(ch.bufferCell >= bufferLength)
+                    ch.bufferCell %= bufferLength;
+
+                double delayed = readFraction(ch.delayBuffer, bufferLength, ch.bufferCell - delayNow);
+                double summedSignal = (sample + (delayed * feedbackNow)); //Compute the signal at the sum point
+                sample = (summedSignal * gainNow);
+
+                ch.delayBuffer[ch.bufferCell++] = summedSignal;
+            }
+            //If delay milliseconds have passed since the delay buffer was initialized then add in delay
+            else if(ch.delayCell >= 0){
+                double summedSignal = (sample + (ch.delayBuffer[ch.delayCell % bufferLength] * feedbackNow)); //Compute the signal at the sum point
+                sample = (summedSignal * gainNow);  //Sum the current input and the correct delay buffer cell
+               
+                if(ch.bufferCell >= bufferLength)
+                    ch.bufferCell %= bufferLength;
+                ch.delayBuffer[ch.bufferCell++] = summedSignal;
+            }
+            //Delay has not started yet. Sum is simplified to just *in.
+            else{
+                sample = (sample * gainNow);
+                 
+                if(ch.bufferCell >= bufferLength)
+                    ch.bufferCell %= bufferLength;
+                ch.delayBuffer[ch.bufferCell++] = sample;
+            }
 
-    for(unsigned int i = 0; i<frames.size(); i++){
+            if(sample > 1.0)
+                sample = 0.999;
+            else if(sample < -1.0)
+                sample = -0.999;
 
-        //If delay milliseconds have passed since the delay buffer was initialized then add in delay
-        if(delayCell >= 0){
-            double summedSignal = (frames[i] + (delayBuffer[delayCell % bufferLength] * (decay/100.0))); //Compute the signal at the sum point
-            *out = (summedSignal * gain);  //Sum the current input and the correct delay buffer cell
+            ch.delayCell++;
+            gainNow += gainStep;
+            feedbackNow += feedbackStep;
+            delayNow += delayStep;
 
-            if(bufferCell >= bufferLength)
-                bufferCell %= bufferLength;
-            delayBuffer[bufferCell++] = summedSignal;
+            output[i] = sample;
         }
-        //Delay has not started yet. Sum is simplified to just *in.
-        else{
-            *out = (frames[i] * gain);
-             
-            if(bufferCell >= bufferLength)
-                bufferCell %= bufferLength;
-            delayBuffer[bufferCell++] = frames[i];
-        }
-
-        //limit signal
-        if(*out > 1.0)
-            *out = 0.999;
-        else if(frames[i] < -1.0)
-            *out = -0.999;
-
-        out++;
-        delayCell++;
     }
-}
-
-StkFrames& FeedbackDelay::tick(void *input, int nBufferFrames, StkFrames& frames){
-    FileWvIn *in = (FileWvIn *) input;
-    
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
-
-    for(unsigned int i = 0; i<frames.size(); i++){
-
-        //If delay milliseconds have passed since the delay buffer was initialized then add in delay
-        if(delayCell >= 0){
-            double summedSignal = (frames[i] + (delayBuffer[delayCell % bufferLength] * (decay/100.0))); //Compute the signal at the sum point
-            frames[i] = (summedSignal * gain);  //Sum the current input and the correct delay buffer cell
-           
-            if(bufferCell >= bufferLength)
-                bufferCell %= bufferLength;
-            delayBuffer[bufferCell++] = summedSignal;
-        }
-        //Delay has not started yet. Sum is simplified to just *in.
-        else{
-            frames[i] = (frames[i] * gain);
-             
-            if(bufferCell >= bufferLength)
-                bufferCell %= bufferLength;
-            delayBuffer[bufferCell++] = frames[i];
-        }
 
-        if(frames[i] > 1.0)
-            frames[i] = 0.999;
-        else if(frames[i] < -1.0)
-            frames[i] = -0.999;
+    outputGain.end(nFrames);
+    feedbackGain.end(nFrames);
+    delayTime.end(nFrames);
 
-        delayCell++;
-    }
-
-    return frames;
+    //The glide is over, go back to reading whole cells
+    if(gliding && !delayTime.isRamping())
+        moveDelayCells();
 }
 
 
-int FeedbackDelay::callback(void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData){
-    FileWvIn *input = (FileWvIn *) userData;
-        
-    tick(outputBuffer, input, nBufferFrames); 
-
-    if ( input->isFinished() ) {
-        AudioHandler::done = true;
-        return 1;
-    }
-    else
-        return 0;
-}
-
 //Set functions
 void FeedbackDelay::setFeedbackDelay(){
     gain = 1.0;
     decay = 10;
     delay = 200;
-    bufferCell = 0;
-    delayCell = (int) (-1) * (fsPerMs * delay);
 
-    bufferLength = 2 + (delay / 1000.0) * MAX_BUFFER_LENGTH; 
 
     initializeDelayBuffer();
 }
@@ -502,9 +624,6 @@ void FeedbackDelay::setFeedbackDelay(double tGain, double tDecay, unsigned int t
         gain = tGain;
         decay = tDecay;
         delay = tDelay;
-        bufferCell = 0;
-        delayCell = (int) (-1) * (fsPerMs * delay);
-        bufferLength = 2 + (delay / 1000.0) * MAX_BUFFER_LENGTH; 
 
         initializeDelayBuffer();
     }
@@ -521,23 +640,107 @@ void FeedbackDelay::setDecay(double tDecay){
     if(tDecay >= 0 && tDecay < 100)
         decay = tDecay;
 }
+//Glides to the new delay, the history in the buffer is kept
 void FeedbackDelay::setDelay(unsigned int tDelay){
-    if(tDelay >= 0 && tDelay <= 1000)
+    if(tDelay >= 0 && tDelay <= 1000){
         delay = tDelay;
+        delayTime.setTarget(getTapFrames());
+    }
+}
+
+//allocates the delay buffers at their maximum length for the stream
+void FeedbackDelay::prepare(double tSampleRate, unsigned int /*maxBlockSize*/, unsigned int nChannels){
+    destroyDelayBuffer();
+
+    sampleRate = tSampleRate;
+    fsPerMs = sampleRate / 1000.0;
+    maxBufferLength = static_cast<int>((MAX_MS_DELAY / 1000.0) * sampleRate);
 
-    bufferLength = 2 + (delay / 1000.0) * MAX_BUFFER_LENGTH; 
+    numChannels = nChannels;
+    channels = new Channel[numChannels];
+
+    for(unsigned int c = 0; c < numChannels; c++)
+        channels[c].delayBuffer = new double[2 + maxBufferLength];
+
+    outputGain.prepare(sampleRate);
+    feedbackGain.prepare(sampleRate);
+    delayTime.prepare(sampleRate);
 
     initializeDelayBuffer();
 }
 
-
+//clears the buffers and sets the delay cells for the current delay
 void FeedbackDelay::initializeDelayBuffer(){
-    destroyDelayBuffer();
+    bufferLength = 2 + maxBufferLength;
+
+    //Nothing is playing yet, start without ramps
+    outputGain.setValue(gain);
+    feedbackGain.setValue(decay / 100.0);
+    delayTime.setValue(getTapFrames());
 
-    delayBuffer = new double[bufferLength];
+    for(unsigned int c = 0; c < numChannels; c++){
+        for(int i = 0; i < bufferLength; i++)
+            channels[c].delayBuffer[i] = 0.0;
+
+        channels[c].bufferCell = 0;
+        channels[c].delayCell = -getTapFrames();
+    }
 }
 //destroys the current delay buffer
 void FeedbackDelay::destroyDelayBuffer(){
-    delete[ ] delayBuffer;
-    delayBuffer = 0; 
-}
\ No newline at end of file
+    for(unsigned int c = 0; c < numChannels; c++)
+        delete[ ] channels[c].delayBuffer;
+
+    delete[ ] channels;
+    channels = 0; 
+    numChannels = 0;
+}
+
+//Moves the delay cells to the current delay, keeping what is in the buffers
+void FeedbackDelay::moveDelayCells(){
+    for(unsigned int c = 0; c < numChannels; c++){
+        int cell = channels[c].bufferCell - getTapFrames();
+
+        //Read back into what the buffer already holds instead of restarting the delay
+        if(cell < 0)
+            cell += bufferLength;
+
+        channels[c].delayCell = cell;
+    }
+}
+
+//A 0 ms delay feeds back the previous sample, the cell at 0 is the one about to be written
+int FeedbackDelay::getTapFrames() const{
+    int frames = static_cast<int>(fsPerMs * delay);
+
+    return (frames < 1) ? 1 : frames;
+}
+
+//Live parameter changes, applied between blocks
+const char* FeedbackDelay::PARAMETER_NAMES[] = {"Gain (0.0-2.0)", "Decay (0-99)", "Delay (ms)"};
+
+int FeedbackDelay::getNumParameters() const{
+    return NUM_PARAMETERS;
+}
+const char* FeedbackDelay::getParameterName(int parameter) const{
+    if(parameter < 0 || parameter >= NUM_PARAMETERS)
+        return "";
+
+    return PARAMETER_NAMES[parameter];
+}
+void FeedbackDelay::setParameter(int parameter, double value){
+    switch(parameter){
+        case GAIN:
+            setGain(value);
+            outputGain.setTarget(gain);
+            break;
+        case DECAY:
+            setDecay(value);
+            feedbackGain.setTarget(decay / 100.0);
+            break;
+        case DELAY:
+            if(value >= 0 && value <= MAX_MS_DELAY)
+                setDelay(static_cast<unsigned int>(value));
+            break;
+    }
+}
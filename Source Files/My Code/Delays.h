@@ -1,28 +1,31 @@
 #ifndef __DELAYS_H__
 #define __DELAYS_H__
 
-#include "RtAudio.h"
-#include "FileWvOut.h"
+#include "Processor.h"
+#include "Smoother.h"
 
 //Generic Base class for Delay
-class Delay{
+class Delay : public Processor{
 public:
         //Destructor
         virtual ~Delay();
 
-        //callback function
-        virtual int callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData ) = 0;
-
         virtual void initializeDelayBuffer(void) = 0 ;
 
         virtual void destroyDelayBuffer(void) = 0;
+
+protected:
+        //Reads the delay buffer between two cells with linear interpolation,
+        //used while a read head glides to a new delay time
+        static double readFraction(const double* delayBuffer, int bufferLength, double delayCell);
 };
 
 //***************SINGLE DELAY *********************************************************************
 class SingleDelay : public Delay{
 public:
-    static int MAX_BUFFER_LENGTH; //Static variable for maximum buffer length
     static int MAX_MS_DELAY; //Maximum length of the delay (chorus unit delays are short)
+    //Live parameters, see Processor::setParameter()
+    enum Parameter {DRY, WET, DELAY, NUM_PARAMETERS};
 
     //Destructor
     ~SingleDelay(void);
@@ -30,12 +33,6 @@ public:
     //Default Constructor
     SingleDelay(void);
 
-    //Tick functions
-    void tick(void *output, void *input, int nBufferFrames);
-    StkFrames& tick(void *input, int nBufferFrames, StkFrames& frames);
-    //STK Wrapper fo Real-Time Audio
-    int callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData );
-
     //Set functions
     void setSingleDelay(double tDry, double tWet, unsigned int tDelay);
     void setSingleDelay(void);
@@ -44,27 +41,59 @@ public:
     void setWet(double tWet);
     void setDelay(unsigned int tDelay);
     
-    //initializes the delayBuffer into an array of proper size
+    //allocates the delay buffers at their maximum length for the stream
+    void prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels);
+
+    //Processes one block, one channel at a time
+    void process(const StkFloat* const* in, StkFloat* const* out, int nFrames);
+
+    //The longest delay, the output is the input mixed with delayed copies of it
+    long getMemoryFrames(void) const;
+
+    //Live parameter changes, applied between blocks
+    int getNumParameters(void) const;
+    const char* getParameterName(int parameter) const;
+    void setParameter(int parameter, double value);
+
+    //clears the buffers and sets the delay cells for the current delay
     void initializeDelayBuffer(void);
 
     //destroys the current delay buffer
     void destroyDelayBuffer(void);
 
 private:
+    static const char* PARAMETER_NAMES[]; //Menu names of the live parameters
+
+    //Moves the delay cells to the current delay, keeping what is in the buffers
+    void moveDelayCells(void);
+
+    //Delay line state of a single channel
+    struct Channel{
+        int delayCell; //Index in the delayBuffer of the delay to add
+        double *delayBuffer; //Delay buffer is 1 second long at sample rate SAMPLE_RATE
+        unsigned int bufferCell; //Pointer to the current delay buffer cell
+    };
+
     double dry; //% of dry signal
     double wet; //% of wet signal
     unsigned int delay; //Delay in milliseconds
-    int delayCell; //Index in the delayBuffer of the delay to add
-    double *delayBuffer; //Delay buffer is 1 second long at sample rate SAMPLE_RATE
-    unsigned int bufferCell; //Pointer to the current delay buffer cell
-    int bufferLength; //Actual buffer length
+    Smoother dryGain; //dry, ramped when it changes live
+    Smoother wetGain; //wet, ramped when it changes live
+    Smoother delayTime; //delay in samples, the read head glides along it
+    int bufferLength; //Actual buffer length, always the maximum so the delay can change live
+    int maxBufferLength; //Buffer length of MAX_MS_DELAY at sampleRate
+    double sampleRate; //Sample rate the buffers were prepared for
+    double fsPerMs; //Samples per millisecond at sampleRate
+    Channel *channels; //One delay line per channel
+    unsigned int numChannels; //Number of delay lines in channels
 };
 
 //*******************DOUBLE DELAY ********************************************************************
 class DoubleDelay : public Delay{
 public:
-    static int MAX_BUFFER_LENGTH; //Static variable for maximum buffer length
     static int MAX_MS_DELAY; //Maximum length of the delay (chorus unit delays are short)
+    //Live parameters, see Processor::setParameter()
+    enum Parameter {DRY, WET1, DELAY1, WET2, DELAY2, NUM_PARAMETERS};
 
     //Destructor
     ~DoubleDelay(void);
@@ -72,12 +101,6 @@ public:
     //Default Constructor
     DoubleDelay(void);
 
-    //Tick functions
-    void tick(void *output, void *input, int nBufferFrames);
-    StkFrames& tick(void *input, int nBufferFrames, StkFrames& frames);
-    //STK Wrapper fo Real-Time Audio
-    int callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData );
-
     //Set functions
     void setDoubleDelay(void);
     void setDoubleDelay(double tDry, double tWet1, double tWet2, unsigned int tDelay1, unsigned int tDelay2);
@@ -87,30 +110,64 @@ public:
     void setWet2(double tWet2);   
     void setDelay2(unsigned int tDelay2);
 
-    //initializes the delayBuffer into an array of proper size
+    //allocates the delay buffers at their maximum length for the stream
+    void prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels);
+
+    //Processes one block, one channel at a time
+    void process(const StkFloat* const* in, StkFloat* const* out, int nFrames);
+
+    //The longest delay, the output is the input mixed with delayed copies of it
+    long getMemoryFrames(void) const;
+
+    //Live parameter changes, applied between blocks
+    int getNumParameters(void) const;
+    const char* getParameterName(int parameter) const;
+    void setParameter(int parameter, double value);
+
+    //clears the buffers and sets the delay cells for the current delay
     void initializeDelayBuffer(void);
 
     //destroys the current delay buffer
     void destroyDelayBuffer(void);
 
 private:
+    static const char* PARAMETER_NAMES[]; //Menu names of the live parameters
+
+    //Moves the delay cells to the current delay, keeping what is in the buffers
+    void moveDelayCells(void);
+
+    //Delay line state of a single channel
+    struct Channel{
+        int delayCell1; //Index in the delayBuffer of the delay1 to add
+        int delayCell2; //Index in the delayBuffer of the delay2 to add
+        unsigned int bufferCell; //Pointer to the current delay buffer cell
+        double *delayBuffer; //Delay buffer is 1 second long at sample rate SAMPLE_RATE
+    };
+
     double dry; //% of dry signal
     double wet1; //% of wet signal of first delay
     double wet2; //% of wet signal of second delay
     unsigned int delay1; //millisecond delay time of first delay
     unsigned int delay2; //millisecond delay time of second delay
-    int delayCell1; //Index in the delayBuffer of the delay1 to add
-    int delayCell2; //Index in the delayBuffer of the delay2 to add
-    unsigned int bufferCell; //Pointer to the current delay buffer cell
-    double *delayBuffer; //Delay buffer is 1 second long at sample rate SAMPLE_RATE
-    int bufferLength; //Actual buffer length
+    Smoother dryGain; //dry, ramped when it changes live
+    Smoother wet1Gain; //wet1, ramped when it changes live
+    Smoother wet2Gain; //wet2, ramped when it changes live
+    Smoother delayTime1; //delay1 in samples, the first read head glides along it
+    Smoother delayTime2; //delay2 in samples, the second read head glides along it
+    int bufferLength; //Actual buffer length, always the maximum so the delay can change live
+    int maxBufferLength; //Buffer length of MAX_MS_DELAY at sampleRate
+    double sampleRate; //Sample rate the buffers were prepared for
+    double fsPerMs; //Samples per millisecond at sampleRate
+    Channel *channels; //One delay line per channel
+    unsigned int numChannels; //Number of delay lines in channels
 };
 
 //*******************FEEDBACK DELAY ********************************************************
 class FeedbackDelay : public Delay{
 public:
-    static int MAX_BUFFER_LENGTH; //Static variable for maximum buffer length
     static int MAX_MS_DELAY; //Maximum length of the delay (chorus unit delays are short)
+    //Live parameters, see Processor::setParameter()
+    enum Parameter {GAIN, DECAY, DELAY, NUM_PARAMETERS};
 
     //Destructor
     ~FeedbackDelay(void);
@@ -118,12 +175,6 @@ public:
     //Default Constructor
     FeedbackDelay(void);
 
-    //Tick functions
-    void tick(void *output, void *input, int nBufferFrames);
-    StkFrames& tick(void *input, int nBufferFrames, StkFrames& frames);
-    //STK Wrapper fo Real-Time Audio
-    int callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData );
-
     //Set and Get functions
     void setFeedbackDelay(void);
     void setFeedbackDelay(double tGain, double tDecay, unsigned int tDelay);
@@ -131,20 +182,51 @@ public:
     void setDecay(double tDecay);
     void setDelay(unsigned int tDelay);
 
-    //initializes the delayBuffer into an array of proper size
+    //allocates the delay buffers at their maximum length for the stream
+    void prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels);
+
+    //Processes one block, one channel at a time
+    void process(const StkFloat* const* in, StkFloat* const* out, int nFrames);
+
+    //Live parameter changes, applied between blocks
+    int getNumParameters(void) const;
+    const char* getParameterName(int parameter) const;
+    void setParameter(int parameter, double value);
+
+    //clears the buffers and sets the delay cells for the current delay
     void initializeDelayBuffer(void);
 
     //destroys the current delay buffer
     void destroyDelayBuffer(void);
 
 private:
+    static const char* PARAMETER_NAMES[]; //Menu names of the live parameters
+
+    //Moves the delay cells to the current delay, keeping what is in the buffers
+    void moveDelayCells(void);
+
+    //Age in samples of the feedback tap, at least 1 since the tap is read before the current cell is written
+    int getTapFrames(void) const;
+
+    //Delay line state of a single channel
+    struct Channel{
+        int delayCell; //Index in the delayBuffer of the delay to add
+        unsigned int bufferCell; //Pointer to the current delay buffer cell
+        double *delayBuffer; //Delay buffer is 1 second long at sample rate SAMPLE_RATE   
+    };
+
     double gain; //% boost to signal from 0%-200%
     int decay; //attenuation of the feedback from 0% - 99%
     unsigned int delay; //Delay in milliseconds
-    int delayCell; //Index in the delayBuffer of the delay to add
-    unsigned int bufferCell; //Pointer to the current delay buffer cell
-    double *delayBuffer; //Delay buffer is 1 second long at sample rate SAMPLE_RATE   
-    int bufferLength; //Actual buffer length
+    Smoother outputGain; //gain, ramped when it changes live
+    Smoother feedbackGain; //decay as a gain (decay / 100), ramped when it changes live
+    Smoother delayTime; //delay in samples, the read head glides along it
+    int bufferLength; //Actual buffer length, always the maximum so the delay can change live
+    int maxBufferLength; //Buffer length of MAX_MS_DELAY at sampleRate
+    double sampleRate; //Sample rate the buffers were prepared for
+    double fsPerMs; //Samples per millisecond at sampleRate
+    Channel *channels; //One delay line per channel
+    unsigned int numChannels; //Number of delay lines in channels
 };
 
 #endif
\ No newline at end of file
@@ -9,452 +9,746 @@ AudioHandler class
 
 #include "Effect.h"
 #include <iostream>
+#include <streambuf>
 
 using std::cout;
 using std::cin;
 using std::endl;
 
+//Reads the characters of another stream buffer and keeps a copy of every one
+//taken. Nothing is read ahead, so the source is left just past the last answer
+class AnswerRecorder : public std::streambuf{
+public:
+    AnswerRecorder(std::streambuf* tSource) : source(tSource) {}
+
+    const std::string& getRecorded(void) const { return recorded; }
+
+protected:
+    //A look at the next character, it stays in the source
+    int_type underflow(){
+        return source->sgetc();
+    }
+
+    //Takes the next character
+    int_type uflow(){
+        int_type next = source->sbumpc();
+        if(next != traits_type::eof())
+            recorded += traits_type::to_char_type(next);
+
+        return next;
+    }
+
+private:
+    std::streambuf* source; //Where the answers come from
+    std::string recorded; //Every character taken so far
+};
+
 //Destructor
 Effect::~Effect(){
-    sdelay.~SingleDelay();
-    ddelay.~DoubleDelay();
-    fdelay.~FeedbackDelay();
-    chorus.~MultiChorus();
-    flanger.~FeedbackChorus();
-    verb1.~Reverb1();
-    verb2.~Reverb2();
-    verb3.~Reverb3();
+    clearProcessors();
 }
 
 Effect::Effect(){
-effectType = SINGLE_DELAY;
+    sampleRate = 44100.0;
+    maxBlockSize = 256;
+    numChannels = 2;
+    tail = EffectGraph::INPUT;
+    input = &cin;
+    prompts = &cout;
 }
 
-//Main callback wrapper for all effects
-int Effect::callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData ){
-    if (effectType == SINGLE_DELAY)
-        return sdelay.callback(outputBuffer, notUsed, nBufferFrames, streamTime, status, userData);
-    else if (effectType == DOUBLE_DELAY)
-        return ddelay.callback(outputBuffer, notUsed, nBufferFrames, streamTime, status, userData);
-    else if (effectType == FEEDBACK_DELAY)
-        return fdelay.callback(outputBuffer, notUsed, nBufferFrames, streamTime, status, userData);
-    else if (effectType == CHORUS)
-        return chorus.callback(outputBuffer, notUsed, nBufferFrames, streamTime, status, userData);
-    else if (effectType == FLANGER)
-        return flanger.callback(outputBuffer, notUsed, nBufferFrames, streamTime, status, userData);
-    else if(effectType == REVERB1)
-        return verb1.callback(outputBuffer, notUsed, nBufferFrames, streamTime, status, userData);
-    else if(effectType == REVERB2)
-        return verb2.callback(outputBuffer, notUsed, nBufferFrames, streamTime, status, userData);
-    else if(effectType == REVERB3)
-        return verb3.callback(outputBuffer, notUsed, nBufferFrames, streamTime, status, userData);
-    else
-        return sdelay.callback(outputBuffer, notUsed, nBufferFrames, streamTime, status, userData);
+//Stores the stream format and prepares the graph for it
+void Effect::prepare(double tSampleRate, unsigned int tMaxBlockSize, unsigned int tNumChannels){
+    sampleRate = tSampleRate;
+    maxBlockSize = tMaxBlockSize;
+    numChannels = tNumChannels;
+
+    //Every stage's delay lines follow the chain's precision
+    for(unsigned int s = 0; s < stages.size(); s++)
+        stages[s]->setPrecision(precision);
+
+    graph.prepare(sampleRate, maxBlockSize, numChannels);
 }
 
-//Wrapper for Wave File Output tick calls
-StkFrames& Effect::tick(void* input, int nBufferFrames, StkFrames& frames){
-    if (effectType == SINGLE_DELAY)
-        return sdelay.tick(input, nBufferFrames, frames);
-    else if (effectType == DOUBLE_DELAY)
-        return ddelay.tick(input, nBufferFrames, frames);
-    else if (effectType == FEEDBACK_DELAY)
-        return fdelay.tick(input, nBufferFrames, frames);
-    else if (effectType == CHORUS)
-        return chorus.tick(input, nBufferFrames, frames);
-    else if (effectType == FLANGER)
-        return flanger.tick(input, nBufferFrames, frames);
-    else if(effectType == REVERB1)
-        return verb1.tick(input, nBufferFrames, frames);
-    else if(effectType == REVERB2)
-        return verb2.tick(input, nBufferFrames, frames);
-    else if(effectType == REVERB3)
-        return verb3.tick(input, nBufferFrames, frames);
-    else
-        return sdelay.tick(input, nBufferFrames, frames);
+//Applies the queued parameter changes, then runs one block through the graph
+void Effect::process(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+    //Block boundary, nothing is reading the effects' state right now
+    parameters.applyAll();
+
+    graph.process(in, out, nFrames);
+}
+
+void Effect::addProcessor(Processor* processor, double wet){
+    processor->setPrecision(precision);
+    int node = graph.addProcessor(processor, tail);
+
+    if(node < 0){
+        *prompts << "That effect is already in the chain, skipping it.\n";
+        return;
+    }
+
+    //A partly wet stage is a dry bus in parallel with the effect
+    if(wet < 1.0)
+        node = graph.addMix(tail, 1.0 - wet, node, wet);
+
+    tail = node;
+    graph.setOutput(tail);
+    stages.push_back(processor);
+
+    //Recompile so the new stage has its buffers before anything streams
+    graph.prepare(sampleRate, maxBlockSize, numChannels);
 }
 
-void Effect::chooseEffect(){
-    cout << "Choose the effect you wish to apply to the input stream:\n";
-    cout << "   1) Single Delay\n";
-    cout << "   2) Double Delay\n";
-    cout << "   3) Feedback Delay \n";
-    cout << "   4) Chorus\n";
-    cout << "   5) Flanger\n";
-    cout << "   6) Reverb 1 (5 Seq. Allpass Filters)\n";
-    cout << "   7) Reverb 2 (4 Par. Comb Filters -> 2 Seq. Allpass Filters)\n";
-    cout << "   8) Reverb 3 (6 Par. Low-Pass Comb Filters -> Allpass Filter)\n";
-    cout << "<<<Enter Choice>>>:";
+void Effect::addParallel(Processor* first, Processor* second, double gain, double wet){
+    if(first == second || isStage(first) || isStage(second)){
+        *prompts << "That effect is already in the chain, skipping it.\n";
+        return;
+    }
+
+    first->setPrecision(precision);
+    second->setPrecision(precision);
+
+    //Both branches read the same node, a bus sums them back into one
+    int node1 = graph.addProcessor(first, tail);
+    int node2 = graph.addProcessor(second, tail);
+    int node = graph.addMix(node1, gain, node2, 1.0 - gain);
+
+    //A partly wet split is a dry bus in parallel with the pair
+    if(wet < 1.0)
+        node = graph.addMix(tail, 1.0 - wet, node, wet);
+
+    tail = node;
+    graph.setOutput(tail);
+    stages.push_back(first);
+    stages.push_back(second);
+
+    //Recompile so the new stages have their buffers before anything streams
+    graph.prepare(sampleRate, maxBlockSize, numChannels);
+}
+
+void Effect::clearProcessors(){
+    //Nothing streams, so changes still queued for the old stages are dropped here
+    ParameterQueue::Change change;
+    while(parameters.pop(change))
+        ;
+
+    graph.clear();
+    stages.clear();
+    tail = EffectGraph::INPUT;
+
+    for(unsigned int p = 0; p < owned.size(); p++)
+        delete owned[p];
+    owned.clear();
+    convolutions.clear();
+}
+
+void Effect::setConsole(std::istream& tInput, std::ostream& tPrompts){
+    input = &tInput;
+    prompts = &tPrompts;
+}
+
+bool Effect::chooseEffect(){
+    error.clear();
+
+    //Keep the answers as they are read, they set up the same chain again
+    AnswerRecorder recorder(input->rdbuf());
+    std::istream recorded(&recorder);
+    recorded.tie(prompts); //questions show before the answers are waited on
+    std::istream* console = input;
+    input = &recorded;
+
+    *prompts << "Choose the effect you wish to apply to the input stream:\n";
+    printEffects();
+    *prompts << "   11) Chain of effects (in series, each with its own wet/dry mix)\n";
+    *prompts << "   12) Two effects in parallel (both on the input, mixed)\n";
+    *prompts << "<<<Enter Choice>>>:";
  
     int choice = 0;
-    cin >> choice;
+    *input >> choice;
+
+    //The chosen effect replaces whatever ran before
+    clearProcessors();
+
+    if(choice == CHAIN){
+        int nStages = 0;
+        *prompts << "Enter the number of effects in the chain (1-" << MAX_STAGES << "):";
+        *input >> nStages;
+
+        for(int s = 1; s <= nStages && s <= MAX_STAGES; s++){
+            int wet = 100;
+
+            *prompts << "Choose effect " << s << " of the chain:\n";
+            printEffects();
+            *prompts << "   " << PARALLEL << ") Two effects in parallel (both on the chain so far, mixed)\n";
+            *prompts << "<<<Enter Choice>>>:";
+            *input >> choice;
+            *prompts << "Enter the % of this stage that is wet, the rest passes dry (0 - 100):";
+            *input >> wet;
+
+            if(wet < 0 || wet > 100)
+                wet = 100;
+
+            //Every stage gets its own processor, an effect can come up more than once
+            if(choice == PARALLEL)
+                setParallel(wet / 100.0);
+            else
+                addProcessor(setEffect(choice), wet / 100.0);
+        }
+    }
+    else if(choice == PARALLEL)
+        setParallel(1.0);
+    else
+        addProcessor(setEffect(choice));
+
+    //A short answer fails the console too
+    input = console;
+    input->setstate(recorded.rdstate());
+    answers = recorder.getRecorded();
+
+    return error.empty();
+}
+
+const std::string& Effect::getAnswers() const{
+    return answers;
+}
+
+const std::string& Effect::getError() const{
+    return error;
+}
+
+//The sum of the stages' memories, or -1 if any stage feeds back
+long Effect::getMemoryFrames() const{
+    long memory = 0;
+
+    for(unsigned int s = 0; s < stages.size(); s++){
+        long stage = stages[s]->getMemoryFrames();
+        if(stage < 0)
+            return -1;
+
+        memory += stage;
+    }
+
+    return memory;
+}
+
+unsigned long Effect::getLateTails() const{
+    unsigned long late = 0;
+
+    for(unsigned int c = 0; c < convolutions.size(); c++)
+        late += convolutions[c]->getLateTails();
+
+    return late;
+}
+
+//Asks for one live parameter change and queues it for the audio thread.
+//The effects themselves are only changed by process(), between blocks
+bool Effect::tweakEffect(){
+    int count = 0;
+
+    *prompts << "\nChange a parameter while the stream plays:\n";
+    for(unsigned int s = 0; s < stages.size(); s++){
+        for(int p = 0; p < stages[s]->getNumParameters(); p++)
+            *prompts << "   " << ++count << ") Effect " << s + 1 << ": " << stages[s]->getParameterName(p) << "\n";
+    }
+    *prompts << "   0) Done, let the stream finish\n";
+    *prompts << "<<<Enter Choice>>>:";
+
+    int choice = 0;
+    *input >> choice;
+
+    if(!*input || choice <= 0 || choice > count)
+        return false;
+
+    //Find the stage and parameter behind the menu number
+    for(unsigned int s = 0; s < stages.size(); s++){
+        int numParameters = stages[s]->getNumParameters();
+
+        if(choice <= numParameters){
+            double value = 0.0;
+            *prompts << "Enter the new value:";
+            *input >> value;
+
+            if(!parameters.push(stages[s], choice - 1, value))
+                *prompts << "Too many changes are waiting, try again.\n";
+            break;
+        }
+        choice -= numParameters;
+    }
+
+    return true;
+}
+
+//Lists the single effects
+void Effect::printEffects(){
+    *prompts << "   1) Single Delay\n";
+    *prompts << "   2) Double Delay\n";
+    *prompts << "   3) Feedback Delay \n";
+    *prompts << "   4) Chorus\n";
+    *prompts << "   5) Flanger\n";
+    *prompts << "   6) Reverb 1 (5 Seq. Allpass Filters)\n";
+    *prompts << "   7) Reverb 2 (4 Par. Comb Filters -> 2 Seq. Allpass Filters)\n";
+    *prompts << "   8) Reverb 3 (6 Par. Low-Pass Comb Filters -> Allpass Filter)\n";
+    *prompts << "   9) FDN Reverb (4-16 Damped Delay Lines Through a Feedback Matrix)\n";
+    *prompts << "   10) Convolution Reverb (Impulse Response From a .wav File)\n";
+}
+
+//Makes a processor for a menu choice, Single Delay for anything unknown, and asks
+//for its parameters. Called between streams, never from the callback
+Processor* Effect::setEffect(int choice){
+    Processor* effect = 0;
 
     switch(choice){
-        case SINGLE_DELAY:
-            setSingleDelay();
+        case DOUBLE_DELAY:{
+            DoubleDelay* ddelay = new DoubleDelay;
+            setDoubleDelay(*ddelay);
+            effect = ddelay;
             break;
-        case DOUBLE_DELAY:
-            setDoubleDelay();
+        }
+        case FEEDBACK_DELAY:{
+            FeedbackDelay* fdelay = new FeedbackDelay;
+            setFeedbackDelay(*fdelay);
+            effect = fdelay;
             break;
-        case FEEDBACK_DELAY:
-            setFeedbackDelay();
+        }
+        case CHORUS:{
+            MultiChorus* chorus = new MultiChorus;
+            setChorus(*chorus);
+            effect = chorus;
             break;
-        case CHORUS:
-            setChorus();
+        }
+        case FLANGER:{
+            FeedbackChorus* flanger = new FeedbackChorus;
+            setFlanger(*flanger);
+            effect = flanger;
             break;
-        case FLANGER:
-            setFlanger();
+        }
+        case REVERB1:{
+            Reverb1* verb1 = new Reverb1;
+            setReverb1(*verb1);
+            effect = verb1;
             break;
-        case REVERB1:
-            setReverb1();
+        }
+        case REVERB2:{
+            Reverb2* verb2 = new Reverb2;
+            setReverb2(*verb2);
+            effect = verb2;
             break;
-        case REVERB2:
-            setReverb2();
+        }
+        case REVERB3:{
+            Reverb3* verb3 = new Reverb3;
+            setReverb3(*verb3);
+            effect = verb3;
             break;
-        case REVERB3:
-            setReverb3();
+        }
+        case FDN_REVERB:{
+            FDNReverb* fdn = new FDNReverb;
+            setFDNReverb(*fdn);
+            effect = fdn;
             break;
-        default:
-            setSingleDelay();
+        }
+        case CONVOLUTION_REVERB:{
+            ConvolutionReverb* convolution = new ConvolutionReverb;
+            setConvolutionReverb(*convolution);
+            convolutions.push_back(convolution);
+            effect = convolution;
+            break;
+        }
+        default:{
+            SingleDelay* sdelay = new SingleDelay;
+            setSingleDelay(*sdelay);
+            effect = sdelay;
+        }
     }
+
+    owned.push_back(effect);
+    return effect;
+}
+
+//Asks for two effects and their mix and appends them side by side
+void Effect::setParallel(double wet){
+    int choice = 0, mix = 50;
+
+    *prompts << "Choose the first of the two parallel effects:\n";
+    printEffects();
+    *prompts << "<<<Enter Choice>>>:";
+    *input >> choice;
+    Processor* first = setEffect(choice);
+
+    *prompts << "Choose the second of the two parallel effects:\n";
+    printEffects();
+    *prompts << "<<<Enter Choice>>>:";
+    *input >> choice;
+    Processor* second = setEffect(choice);
+
+    *prompts << "Enter the % of the output from the first effect, the rest is the second (0 - 100):";
+    *input >> mix;
+
+    if(mix < 0 || mix > 100)
+        mix = 50;
+
+    addParallel(first, second, mix / 100.0, wet);
 }
 
-void Effect::setEffect(){
-//Nothing useful for this
+//True if processor is one of the stages
+bool Effect::isStage(const Processor* processor) const{
+    for(unsigned int s = 0; s < stages.size(); s++){
+        if(stages[s] == processor)
+            return true;
+    }
+
+    return false;
 }
 
-void Effect::setSingleDelay(){
+void Effect::setSingleDelay(SingleDelay& sdelay){
     int tDelay; 
     double tWet, tDry;
 
-    effectType = SINGLE_DELAY;
-
-    cout << "The parameters for the Single Delay unit must now be decided.";
-    cout << endl;
-    cout << "Enter the delay length (0-" << SingleDelay::MAX_MS_DELAY << "ms):";
-    cin >> tDelay;
-    cout << "Enter the % of the dry signal (0.0-1.0):";
-    cin >> tDry;
-    cout << "Enter the % of the wet signal (0.0-1.0):";
-    cin >> tWet;
+    *prompts << "The parameters for the Single Delay unit must now be decided.";
+    *prompts << endl;
+    *prompts << "Enter the delay length (0-" << SingleDelay::MAX_MS_DELAY << "ms):";
+    *input >> tDelay;
+    *prompts << "Enter the % of the dry signal (0.0-1.0):";
+    *input >> tDry;
+    *prompts << "Enter the % of the wet signal (0.0-1.0):";
+    *input >> tWet;
 
     sdelay.setSingleDelay(tDry, tWet, tDelay);
 }
-void Effect::setDoubleDelay(){
+void Effect::setDoubleDelay(DoubleDelay& ddelay){
     int tDelay1, tDelay2; 
     double tWet1, tWet2, tDry;
 
-    effectType = DOUBLE_DELAY;
-
-    cout << "The parameters for the Double Delay unit must now be decided.";
-    cout << endl;
-    cout << "Enter the longest delay length (0-" << SingleDelay::MAX_MS_DELAY << "ms):";
-    cin >> tDelay2;
-    cout << "Enter the shortest delay length (0-" << SingleDelay::MAX_MS_DELAY << "ms):";
-    cin >> tDelay1;
-    cout << "Enter the % of the dry signal (0.0-1.0):";
-    cin >> tDry;
-    cout << "Enter the % of the wet signal of the longest delay (0.0-1.0):";
-    cin >> tWet2;
-    cout << "Enter the % of the wet signal of the shortest delay (0.0-1.0):";
-    cin >> tWet1;
+    *prompts << "The parameters for the Double Delay unit must now be decided.";
+    *prompts << endl;
+    *prompts << "Enter the longest delay length (0-" << SingleDelay::MAX_MS_DELAY << "ms):";
+    *input >> tDelay2;
+    *prompts << "Enter the shortest delay length (0-" << SingleDelay::MAX_MS_DELAY << "ms):";
+    *input >> tDelay1;
+    *prompts << "Enter the % of the dry signal (0.0-1.0):";
+    *input >> tDry;
+    *prompts << "Enter the % of the wet signal of the longest delay (0.0-1.0):";
+    *input >> tWet2;
+    *prompts << "Enter the % of the wet signal of the shortest delay (0.0-1.0):";
+    *input >> tWet1;
 
     ddelay.setDoubleDelay(tDry, tWet1, tWet2, tDelay1, tDelay2);
 }
-void Effect::setFeedbackDelay(){
+void Effect::setFeedbackDelay(FeedbackDelay& fdelay){
     int tDecay, tDelay; 
     double tGain;
 
-    effectType = FEEDBACK_DELAY;
-
-    cout << "The parameters for the Feedback Delay unit must now be decided.";
-    cout << endl;
-    cout << "Enter the delay length (0-" << FeedbackDelay::MAX_MS_DELAY << "ms):";
-    cin >> tDelay;
-    cout << "WARNING: A DECAY OF 100 CAN OVERLOAD OUTPUT AND DAMAGE SPEAKERS\n";
-    cout << "Enter the decay rate for the feedback signal (0 - 100):";
-    cin >> tDecay;
-    cout << "Enter the gain for the output signal (0.0-2.0):";
-    cin >> tGain;
+    *prompts << "The parameters for the Feedback Delay unit must now be decided.";
+    *prompts << endl;
+    *prompts << "Enter the delay length (0-" << FeedbackDelay::MAX_MS_DELAY << "ms):";
+    *input >> tDelay;
+    *prompts << "WARNING: A DECAY OF 100 CAN OVERLOAD OUTPUT AND DAMAGE SPEAKERS\n";
+    *prompts << "Enter the decay rate for the feedback signal (0 - 100):";
+    *input >> tDecay;
+    *prompts << "Enter the gain for the output signal (0.0-2.0):";
+    *input >> tGain;
 
     fdelay.setFeedbackDelay(tGain, tDecay, tDelay);
 }
-void Effect::setChorus(){
+void Effect::setChorus(MultiChorus& chorus){
     int tDry, tWet, tDelay1 = 0, tDelay2 = 0, tDelay3 = 0,
     tNumDelays, tNumModulators;
     bool bandlimited;
 
-    //Set enumerator
-    effectType = CHORUS;
-
-    cout << "The parameters for the multi-staged chorus unit must now be decided.";
-    cout << endl;
-    cout << "Choose the % dry signal (0 - 100):";
-    cin >> tDry;
-    cout << "Choose the % wet signal (0 - 100):";
-    cin >> tWet;
-    cout << "Choose the number of stages/delays (1-3):";
-    cin >> tNumDelays;
-    cout << "\nPlease enter delays in order from longest to shortest.\n";
+    *prompts << "The parameters for the multi-staged chorus unit must now be decided.";
+    *prompts << endl;
+    *prompts << "Choose the % dry signal (0 - 100):";
+    *input >> tDry;
+    *prompts << "Choose the % wet signal (0 - 100):";
+    *input >> tWet;
+    *prompts << "Choose the number of stages/delays (1-3):";
+    *input >> tNumDelays;
+    *prompts << "\nPlease enter delays in order from longest to shortest.\n";
 
     switch(tNumDelays){
         case 3:
-            cout << "Choose the third delay length (0-" << MultiChorus::MAX_MS_DELAY << "ms):";
-            cin >> tDelay3;
+            *prompts << "Choose the third delay length (0-" << MultiChorus::MAX_MS_DELAY << "ms):";
+            *input >> tDelay3;
         case 2:
-            cout << "Choose the second delay length (0-" << MultiChorus::MAX_MS_DELAY << "ms):";
-            cin >> tDelay2;
+            *prompts << "Choose the second delay length (0-" << MultiChorus::MAX_MS_DELAY << "ms):";
+            *input >> tDelay2;
         case 1:
-            cout << "Choose the first delay length (0-" << MultiChorus::MAX_MS_DELAY << "ms):";
-            cin >> tDelay1;
+            *prompts << "Choose the first delay length (0-" << MultiChorus::MAX_MS_DELAY << "ms):";
+            *input >> tDelay1;
             break;
         default:
-            cout << "You entered and invalid number of stages, assuming 1.\n";
-            cout << "Choose the delay length (0-" << MultiChorus::MAX_MS_DELAY << "ms):";
-            cin >> tDelay1;
+            *prompts << "You entered and invalid number of stages, assuming 1.\n";
+            *prompts << "Choose the delay length (0-" << MultiChorus::MAX_MS_DELAY << "ms):";
+            *input >> tDelay1;
     }
 
-    cout << "Select the number of seperate modulators. At most 1 per stage (1-3):";
-    cin >> tNumModulators;
+    *prompts << "Select the number of seperate modulators. At most 1 per stage (1-3):";
+    *input >> tNumModulators;
 
     if (tNumModulators > tNumDelays){
-        cout << "You entered an invalid number of modulators. Defaulting to 1...\n";
+        *prompts << "You entered an invalid number of modulators. Defaulting to 1...\n";
         tNumModulators = 1;
     }
 
     int temp = 0;
-    cout << "Select the type of interpolation: (0) Linear (1) Bandlimited:";
-    cin >> temp;
+    *prompts << "Select the type of interpolation: (0) Linear (1) Bandlimited:";
+    *input >> temp;
     bandlimited = static_cast<bool>(temp);
 
     //call constructor
-    chorus.setMultiChorus(tDry, tWet, tDelay1, tDelay2, tDelay3, tNumDelays, tNumModulators, bandlimited);
+    chorus.setMultiChorus(tDry, tWet, tDelay1, tDelay2, tDelay3, tNumDelays, tNumModulators, bandlimited, *input, *prompts);
 }
 
-void Effect::setFlanger(){
+void Effect::setFlanger(FeedbackChorus& flanger){
     int tDecay, tDelay;
     bool bandlimited;
 
-    //Set enumerator
-    effectType = FLANGER;
-
-    cout << "The parameters for the Flanger unit must now be decided.";
-    cout << endl;
-    cout << "Enter the delay length (0-" << FeedbackChorus::MAX_MS_DELAY << "ms):";
-    cin >> tDelay;
-    cout << "WARNING: A DECAY OF 100 CAN OVERLOAD OUTPUT AND DAMAGE SPEAKERS\n";
-    cout << "Enter the decay rate for the feedback signal (0 - 100%):";
-    cin >> tDecay;
+    *prompts << "The parameters for the Flanger unit must now be decided.";
+    *prompts << endl;
+    *prompts << "Enter the delay length (0-" << FeedbackChorus::MAX_MS_DELAY << "ms):";
+    *input >> tDelay;
+    *prompts << "WARNING: A DECAY OF 100 CAN OVERLOAD OUTPUT AND DAMAGE SPEAKERS\n";
+    *prompts << "Enter the decay rate for the feedback signal (0 - 100%):";
+    *input >> tDecay;
     
     int temp = 0;
-    cout << "Select the type of interpolation: (0) Linear (1) Bandlimited:";
-    cin >> temp;
+    *prompts << "Select the type of interpolation: (0) Linear (1) Bandlimited:";
+    *input >> temp;
     bandlimited = static_cast<bool>(temp);
 
     //call constructor
-    flanger.setFeedbackChorus(tDecay, tDelay, bandlimited);
+    flanger.setFeedbackChorus(tDecay, tDelay, bandlimited, *input, *prompts);
 }
 
-void Effect::setReverb1(){
+void Effect::setReverb1(Reverb1& verb1){
     int tDelay, tDecay, mix;
 
-    effectType = REVERB1;
-
-    cout << "The parameters for the Reverb 1 unit must now be decided:";
-    cout << endl;
-    cout << "Enter the mix ratio of wet to dry signal (0%-100%):";
-    cin >> mix;
+    *prompts << "The parameters for the Reverb 1 unit must now be decided:";
+    *prompts << endl;
+    *prompts << "Enter the mix ratio of wet to dry signal (0%-100%):";
+    *input >> mix;
     verb1.setMix(mix);
-    cout << "Enter the decay (0%-99%) for all filters:";
-    cin >> tDecay;
-    cout << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 1:";
-    cin >> tDelay;
+    *prompts << "Enter the decay (0%-99%) for all filters:";
+    *input >> tDecay;
+    *prompts << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 1:";
+    *input >> tDelay;
     verb1.setAP(1, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 2:";
-    cin >> tDelay;
+    *prompts << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 2:";
+    *input >> tDelay;
     verb1.setAP(2, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 3:";
-    cin >> tDelay;
+    *prompts << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 3:";
+    *input >> tDelay;
     verb1.setAP(3, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 4:";
-    cin >> tDelay;
+    *prompts << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 4:";
+    *input >> tDelay;
     verb1.setAP(4, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 5:";
-    cin >> tDelay;
+    *prompts << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 5:";
+    *input >> tDelay;
     verb1.setAP(5, tDelay, tDecay);
     /*
-    cout << "Enter the decay (0%-99%) for Allpass 1:";
-    cin >> tDecay;
+    *prompts << "Enter the decay (0%-99%) for Allpass 1:";
+    *input >> tDecay;
     verb1.setAP(1, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 2:";
-    cin >> tDelay;
-    cout << "Enter the decay (0%-99%) for Allpass 2:";
-    cin >> tDecay;
+    *prompts << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 2:";
+    *input >> tDelay;
+    *prompts << "Enter the decay (0%-99%) for Allpass 2:";
+    *input >> tDecay;
     verb1.setAP(2, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 3:";
-    cin >> tDelay;
-    cout << "Enter the decay (0%-99%) for Allpass 3:";
-    cin >> tDecay;
+    *prompts << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 3:";
+    *input >> tDelay;
+    *prompts << "Enter the decay (0%-99%) for Allpass 3:";
+    *input >> tDecay;
     verb1.setAP(3, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 4:";
-    cin >> tDelay;
-    cout << "Enter the decay (0%-99%) for Allpass 4:";
-    cin >> tDecay;
+    *prompts << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 4:";
+    *input >> tDelay;
+    *prompts << "Enter the decay (0%-99%) for Allpass 4:";
+    *input >> tDecay;
     verb1.setAP(4, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 5:";
-    cin >> tDelay;
-    cout << "Enter the decay (0%-99%) for Allpass 5:";
-    cin >> tDecay; 
+    *prompts << "Enter the delay length (0-" << Reverb1::MAX_MS_DELAY << "ms) for Allpass 5:";
+    *input >> tDelay;
+    *prompts << "Enter the decay (0%-99%) for Allpass 5:";
+    *input >> tDecay; 
     verb1.setAP(5, tDelay, tDecay); */
 }
-void Effect::setReverb2(){
+void Effect::setReverb2(Reverb2& verb2){
     int tDelay, tDecay, mix;
 
-    effectType = REVERB2;
-
-    cout << "The parameters for the Reverb 2 unit must now be decided:";
-    cout << endl;
-    cout << "Enter the mix ratio of wet to dry signal (0%-100%):";
-    cin >> mix;
+    *prompts << "The parameters for the Reverb 2 unit must now be decided:";
+    *prompts << endl;
+    *prompts << "Enter the mix ratio of wet to dry signal (0%-100%):";
+    *input >> mix;
     verb2.setMix(mix);
-    cout << "Enter the decay (0%-99%) for all filters:";
-    cin >> tDecay;
-    cout << "Enter the delay length (0-" << Reverb2::C_MAX_MS_DELAY << "ms) for Comb 1:";
-    cin >> tDelay;
+    *prompts << "Enter the decay (0%-99%) for all filters:";
+    *input >> tDecay;
+    *prompts << "Enter the delay length (0-" << Reverb2::C_MAX_MS_DELAY << "ms) for Comb 1:";
+    *input >> tDelay;
     verb2.setComb(1, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb2::C_MAX_MS_DELAY << "ms) for Comb 2:";
-    cin >> tDelay;
+    *prompts << "Enter the delay length (0-" << Reverb2::C_MAX_MS_DELAY << "ms) for Comb 2:";
+    *input >> tDelay;
     verb2.setComb(2, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb2::C_MAX_MS_DELAY << "ms) for Comb 3:";
-    cin >> tDelay;
+    *prompts << "Enter the delay length (0-" << Reverb2::C_MAX_MS_DELAY << "ms) for Comb 3:";
+    *input >> tDelay;
     verb2.setComb(3, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb2::C_MAX_MS_DELAY << "ms) for Comb 4:";
-    cin >> tDelay;
+    *prompts << "Enter the delay length (0-" << Reverb2::C_MAX_MS_DELAY << "ms) for Comb 4:";
+    *input >> tDelay;
     verb2.setComb(4, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb2::A_MAX_MS_DELAY << "ms) for Allpass 1:";
-    cin >> tDelay;
+    *prompts << "Enter the delay length (0-" << Reverb2::A_MAX_MS_DELAY << "ms) for Allpass 1:";
+    *input >> tDelay;
     verb2.setAP(1, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb2::A_MAX_MS_DELAY << "ms) for Allpass 2:";
-    cin >> tDelay;
+    *prompts << "Enter the delay length (0-" << Reverb2::A_MAX_MS_DELAY << "ms) for Allpass 2:";
+    *input >> tDelay;
     verb2.setAP(2, tDelay, tDecay);
 
     /*
-    cout << "Enter the delay length (0-" << Reverb2::C_MAX_MS_DELAY << "ms) for Comb 2:";
-    cin >> tDelay;
-    cout << "Enter the decay (0%-99%) for Comb 2:";
-    cin >> tDecay;
+    *prompts << "Enter the delay length (0-" << Reverb2::C_MAX_MS_DELAY << "ms) for Comb 2:";
+    *input >> tDelay;
+    *prompts << "Enter the decay (0%-99%) for Comb 2:";
+    *input >> tDecay;
     verb2.setComb(2, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb2::C_MAX_MS_DELAY << "ms) for Comb 3:";
-    cin >> tDelay;
-    cout << "Enter the decay (0%-99%) for Comb 3:";
-    cin >> tDecay;
+    *prompts << "Enter the delay length (0-" << Reverb2::C_MAX_MS_DELAY << "ms) for Comb 3:";
+    *input >> tDelay;
+    *prompts << "Enter the decay (0%-99%) for Comb 3:";
+    *input >> tDecay;
     verb2.setComb(3, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb2::C_MAX_MS_DELAY << "ms) for Comb 4:";
-    cin >> tDelay;
-    cout << "Enter the decay (0%-99%) for Comb 4:";
-    cin >> tDecay;
+    *prompts << "Enter the delay length (0-" << Reverb2::C_MAX_MS_DELAY << "ms) for Comb 4:";
+    *input >> tDelay;
+    *prompts << "Enter the decay (0%-99%) for Comb 4:";
+    *input >> tDecay;
     verb2.setComb(4, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb2::A_MAX_MS_DELAY << "ms) for Allpass 1:";
-    cin >> tDelay;
-    cout << "Enter the decay (0%-99%) for Allpass 1:";
-    cin >> tDecay;
+    *prompts << "Enter the delay length (0-" << Reverb2::A_MAX_MS_DELAY << "ms) for Allpass 1:";
+    *input >> tDelay;
+    *prompts << "Enter the decay (0%-99%) for Allpass 1:";
+    *input >> tDecay;
     verb2.setAP(1, tDelay, tDecay);
-    cout << "Enter the delay length (0-" << Reverb2::A_MAX_MS_DELAY << "ms) for Allpass 2:";
-    cin >> tDelay;
-    cout << "Enter the decay (0%-99%) for Allpass 2:";
-    cin >> tDecay;
+    *prompts << "Enter the delay length (0-" << Reverb2::A_MAX_MS_DELAY << "ms) for Allpass 2:";
+    *input >> tDelay;
+    *prompts << "Enter the decay (0%-99%) for Allpass 2:";
+    *input >> tDecay;
     verb2.setAP(2, tDelay, tDecay);
     */
 }
-void Effect::setReverb3(){
+void Effect::setReverb3(Reverb3& verb3){
     int tDelay, tDecay, tDecay2, mix;
 
-    effectType = REVERB3;
-
-    cout << "The parameters for the Reverb 3 unit must now be decided:";
-    cout << endl;
-    cout << "Enter the mix ratio of wet to dry signal (0%-100%):";
-    cin >> mix;
+    *prompts << "The parameters for the Reverb 3 unit must now be decided:";
+    *prompts << endl;
+    *prompts << "Enter the mix ratio of wet to dry signal (0%-100%):";
+    *input >> mix;
     verb3.setMix(mix);
-    cout << "Enter the first decay (0%-99%) for Low-Pass Combs:";
-    cin >> tDecay;
-    cout << "Enter the second decay (0%-99%) for Low-Pass Combs:";
-    cin >> tDecay2;
-    cout << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 1:";
-    cin >> tDelay;
+    *prompts << "Enter the first decay (0%-99%) for Low-Pass Combs:";
+    *input >> tDecay;
+    *prompts << "Enter the second decay (0%-99%) for Low-Pass Combs:";
+    *input >> tDecay2;
+    *prompts << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 1:";
+    *input >> tDelay;
     verb3.setLPComb(1, tDelay, tDecay, tDecay2);
-    cout << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 2:";
-    cin >> tDelay;
+    *prompts << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 2:";
+    *input >> tDelay;
     verb3.setLPComb(2, tDelay, tDecay, tDecay2);
-    cout << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 3:";
-    cin >> tDelay;
+    *prompts << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 3:";
+    *input >> tDelay;
     verb3.setLPComb(3, tDelay, tDecay, tDecay2);
-    cout << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 4:";
-    cin >> tDelay;
+    *prompts << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 4:";
+    *input >> tDelay;
     verb3.setLPComb(4, tDelay, tDecay, tDecay2);
-    cout << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 5:";
-    cin >> tDelay;
+    *prompts << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 5:";
+    *input >> tDelay;
     verb3.setLPComb(5, tDelay, tDecay, tDecay2);
-    cout << "Enter the first delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 6:";
-    cin >> tDelay;
+    *prompts << "Enter the first delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 6:";
+    *input >> tDelay;
     verb3.setLPComb(6, tDelay, tDecay, tDecay2);
-    cout << "Enter the delay length (0-" << Reverb3::A_MAX_MS_DELAY << "ms) for Allpass:";
-    cin >> tDelay;
-    cout << "Enter the decay (0%-99%) for Allpass:";
-    cin >> tDecay;
+    *prompts << "Enter the delay length (0-" << Reverb3::A_MAX_MS_DELAY << "ms) for Allpass:";
+    *input >> tDelay;
+    *prompts << "Enter the decay (0%-99%) for Allpass:";
+    *input >> tDecay;
     verb3.setAP(tDelay, tDecay);
 
     /*
-    cout << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 2:";
-    cin >> tDelay;
-    cout << "Enter the first decay (0%-99%) for Low-Pass Comb 2:";
-    cin >> tDecay;
-    cout << "Enter the second decay (0%-99%) for Low-Pass Comb 2:";
-    cin >> tDecay2;
+    *prompts << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 2:";
+    *input >> tDelay;
+    *prompts << "Enter the first decay (0%-99%) for Low-Pass Comb 2:";
+    *input >> tDecay;
+    *prompts << "Enter the second decay (0%-99%) for Low-Pass Comb 2:";
+    *input >> tDecay2;
     verb3.setLPComb(2, tDelay, tDecay, tDecay2);
-    cout << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 3:";
-    cin >> tDelay;
-    cout << "Enter the first decay (0%-99%) for Low-Pass Comb 3:";
-    cin >> tDecay;
-    cout << "Enter the second decay (0%-99%) for Low-Pass Comb 3:";
-    cin >> tDecay2;
+    *prompts << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 3:";
+    *input >> tDelay;
+    *prompts << "Enter the first decay (0%-99%) for Low-Pass Comb 3:";
+    *input >> tDecay;
+    *prompts << "Enter the second decay (0%-99%) for Low-Pass Comb 3:";
+    *input >> tDecay2;
     verb3.setLPComb(3, tDelay, tDecay, tDecay2);
-    cout << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 4:";
-    cin >> tDelay;
-    cout << "Enter the first decay (0%-99%) for Low-Pass Comb 4:";
-    cin >> tDecay;
-    cout << "Enter the second decay (0%-99%) for Low-Pass Comb 4:";
-    cin >> tDecay2;
+    *prompts << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 4:";
+    *input >> tDelay;
+    *prompts << "Enter the first decay (0%-99%) for Low-Pass Comb 4:";
+    *input >> tDecay;
+    *prompts << "Enter the second decay (0%-99%) for Low-Pass Comb 4:";
+    *input >> tDecay2;
     verb3.setLPComb(4, tDelay, tDecay, tDecay2);
-    cout << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 5:";
-    cin >> tDelay;
-    cout << "Enter the first decay (0%-99%) for Low-Pass Comb 5:";
-    cin >> tDecay;
-    cout << "Enter the second decay (0%-99%) for Low-Pass Comb 5:";
-    cin >> tDecay2;
+    *prompts << "Enter the delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 5:";
+    *input >> tDelay;
+    *prompts << "Enter the first decay (0%-99%) for Low-Pass Comb 5:";
+    *input >> tDecay;
+    *prompts << "Enter the second decay (0%-99%) for Low-Pass Comb 5:";
+    *input >> tDecay2;
     verb3.setLPComb(5, tDelay, tDecay, tDecay2);
-    cout << "Enter the first delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 6:";
-    cin >> tDelay;
-    cout << "Enter the first decay (0%-99%) for Low-Pass Comb 6:";
-    cin >> tDecay;
-    cout << "Enter the second decay (0%-99%) for Low-Pass Comb 6:";
-    cin >> tDecay2;
+    *prompts << "Enter the first delay length (0-" << Reverb3::C_MAX_MS_DELAY << "ms) for Low-Pass Comb 6:";
+    *input >> tDelay;
+    *prompts << "Enter the first decay (0%-99%) for Low-Pass Comb 6:";
+    *input >> tDecay;
+    *prompts << "Enter the second decay (0%-99%) for Low-Pass Comb 6:";
+    *input >> tDecay2;
     verb3.setLPComb(6, tDelay, tDecay, tDecay2);
-    cout << "Enter the delay length (0-" << Reverb3::A_MAX_MS_DELAY << "ms) for Allpass:";
-    cin >> tDelay;
-    cout << "Enter the decay (0%-99%) for Allpass:";
-    cin >> tDecay;
+    *prompts << "Enter the delay length (0-" << Reverb3::A_MAX_MS_DELAY << "ms) for Allpass:";
+    *input >> tDelay;
+    *prompts << "Enter the decay (0%-99%) for Allpass:";
+    *input >> tDecay;
     verb3.setAP(tDelay, tDecay);
     */
 }
+void Effect::setFDNReverb(FDNReverb& fdn){
+    int mix, tLines, tMatrix, tSize, tReverbTime, tDamping;
+
+    *prompts << "The parameters for the FDN Reverb unit must now be decided:";
+    *prompts << endl;
+    *prompts << "Enter the mix ratio of wet to dry signal (0%-100%):";
+    *input >> mix;
+    fdn.setMix(mix);
+    *prompts << "Enter the number of delay lines (4, 8 or 16):";
+    *input >> tLines;
+    *prompts << "Select the feedback matrix: (0) Householder (1) Hadamard:";
+    *input >> tMatrix;
+    *prompts << "Enter the length of the longest delay line (10-" << FDNReverb::MAX_MS_DELAY << "ms):";
+    *input >> tSize;
+    fdn.setNetwork(tLines, tMatrix ? FDNReverb::HADAMARD : FDNReverb::HOUSEHOLDER, tSize);
+    *prompts << "Enter the reverb time, for the tail to fall 60dB (100-20000ms):";
+    *input >> tReverbTime;
+    fdn.setReverbTime(tReverbTime);
+    *prompts << "Enter the damping of the high frequencies (0%-99%):";
+    *input >> tDamping;
+    fdn.setDamping(tDamping);
+}
+void Effect::setConvolutionReverb(ConvolutionReverb& convolution){
+    int mix;
+    std::string fileName;
+
+    *prompts << "The parameters for the Convolution Reverb unit must now be decided:";
+    *prompts << endl;
+    *prompts << "Enter the mix ratio of wet to dry signal (0%-100%):";
+    *input >> mix;
+    convolution.setMix(mix);
+    *prompts << "Enter the impulse response .wav file, in double quotes if it has spaces:";
+    *input >> std::ws;
+
+    //One answer like any other, so the answers after it stay theirs
+    if(input->peek() == '"'){
+        input->get();
+        std::getline(*input, fileName, '"');
+    }
+    else
+        *input >> fileName;
 
-//Static Variables
-enum Effect::EFFECT_TYPE Effect::effectType;
-MultiChorus Effect::chorus;
-FeedbackChorus Effect::flanger;
-SingleDelay Effect::sdelay;
-DoubleDelay Effect::ddelay;
-FeedbackDelay Effect::fdelay;
-Reverb1 Effect::verb1;
-Reverb2 Effect::verb2;
-Reverb3 Effect::verb3;
\ No newline at end of file
+    if(!convolution.loadImpulse(fileName)){
+        error = "the impulse response " + fileName + " did not open";
+        *prompts << "The impulse response did not open, the reverb will be silent.\n";
+    }
+}
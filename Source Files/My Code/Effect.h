@@ -1,46 +1,118 @@
 #ifndef __EFFECT_H__
 #define __EFFECT_H__
 
+#include "Processor.h"
+#include "EffectGraph.h"
+#include "ParameterQueue.h"
 #include "Chorus.h"
 #include "Delays.h"
 #include "Reverb.h"
+#include "FDNReverb.h"
+#include "ConvolutionReverb.h"
+#include <iostream>
+#include <string>
 
-class Effect{
+//Container for a chain of Processors. The host feeds it blocks
+//and it runs them through the effect graph
+class Effect : public Processor{
 public:
     //Destructor
     ~Effect(void);
     //default Constructor
     Effect(void);
 
-    static int callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData );
+    //Stores the stream format and prepares the graph for it, every stage at the
+    //chain's precision. Must be called before any effect is chosen or streamed
+    void prepare(double tSampleRate, unsigned int tMaxBlockSize, unsigned int tNumChannels);
 
-    //Wrapper for Wave File Output tick calls
-    static StkFrames& tick(void* input, int nBufferFrames, StkFrames& frames);
+    //Applies the queued parameter changes, then runs one block through the graph.
+    //An empty chain passes the input through
+    void process(const StkFloat* const* in, StkFloat* const* out, int nFrames);
 
-    void setEffect(void);
-    
-    void chooseEffect(void);
+    //Appends a processor to the end of the chain, wet parts effect and (1 - wet) parts
+    //what ran before it, and prepares the graph for the stored stream format.
+    //The chain does not own the processors handed in, only the ones chooseEffect() makes
+    void addProcessor(Processor* processor, double wet = 1.0);
+
+    //Appends two processors side by side, both fed by the end of the chain, mixes
+    //them gain parts first and (1 - gain) parts second, and that wet parts against
+    //(1 - wet) parts what ran before. Skipped if either is in the chain
+    void addParallel(Processor* first, Processor* second, double gain, double wet = 1.0);
+
+    //Empties the chain and frees the processors chooseEffect() made.
+    //Not while streaming
+    void clearProcessors(void);
+
+    //Menus read their answers from input and show their questions on prompts.
+    //cin and cout by default, a batch job hands in its own streams
+    void setConsole(std::istream& tInput, std::ostream& tPrompts);
+
+    //Asks for the effect and its parameters and makes a processor for every stage,
+    //so the same effect can run at several places in the chain. The answers are
+    //kept, see getAnswers(). Returns false if a stage could not be set up, see getError()
+    bool chooseEffect(void);
+
+    //Why the last chooseEffect() failed, empty if it did not
+    const std::string& getError(void) const;
+
+    //Every answer the last chooseEffect() read, as typed. Handing them to
+    //another Effect's chooseEffect() sets up the same chain
+    const std::string& getAnswers(void) const;
+
+    //The sum of the stages' memories, or -1 if any stage feeds back
+    long getMemoryFrames(void) const;
+
+    //Blocks the convolution reverbs put out without their tails, see ConvolutionReverb::getLateTails()
+    unsigned long getLateTails(void) const;
+
+    //Asks for one live parameter change and queues it for the audio thread.
+    //Safe while streaming. Returns false once the user is done changing parameters
+    bool tweakEffect(void);
 
 private:
-    static enum EFFECT_TYPE {SINGLE_DELAY = 1, DOUBLE_DELAY, FEEDBACK_DELAY, CHORUS, FLANGER, REVERB1, REVERB2, REVERB3} effectType; //flag for multi-stage chorus
-
-    static SingleDelay sdelay;
-    static DoubleDelay ddelay;
-    static FeedbackDelay fdelay;
-    static MultiChorus chorus;
-    static FeedbackChorus flanger;
-    static Reverb1 verb1;
-    static Reverb2 verb2;
-    static Reverb3 verb3;
-
-    void setSingleDelay(void);
-    void setDoubleDelay(void);
-    void setFeedbackDelay(void);
-    void setChorus(void);
-    void setFlanger(void);
-    void setReverb1(void);
-    void setReverb2(void);
-    void setReverb3(void);
+    enum EFFECT_TYPE {SINGLE_DELAY = 1, DOUBLE_DELAY, FEEDBACK_DELAY, CHORUS, FLANGER, REVERB1, REVERB2, REVERB3, FDN_REVERB, CONVOLUTION_REVERB, CHAIN, PARALLEL}; //menu choices
+
+    static const int MAX_STAGES = 16; //Longest chain the menu sets up
+
+    EffectGraph graph; //the chain, compiled into a flat plan
+    int tail; //graph node at the end of the chain
+    std::vector<Processor*> stages; //processors of the chain, in order
+    std::vector<Processor*> owned; //processors chooseEffect() made, freed by clearProcessors()
+    std::vector<ConvolutionReverb*> convolutions; //the owned convolution reverbs, for getLateTails()
+    ParameterQueue parameters; //live changes from the control thread, applied between blocks
+
+    std::istream* input; //Answers to the menus
+    std::string answers; //What the last chooseEffect() read from input
+    std::string error; //Why the last chooseEffect() could not set up a stage, or empty
+    std::ostream* prompts; //Menu questions and warnings
+
+    double sampleRate; //Sample rate of the stream
+    unsigned int maxBlockSize; //Largest block the stream will ask for
+    unsigned int numChannels; //Channels in the stream
+
+    //Lists the single effects
+    void printEffects(void);
+
+    //Makes a processor for a menu choice, Single Delay for anything unknown, and asks
+    //for its parameters. It is owned until clearProcessors()
+    Processor* setEffect(int choice);
+
+    //Asks for two effects and their mix and appends them side by side, wet against the chain
+    void setParallel(double wet);
+
+    //True if processor is one of the stages
+    bool isStage(const Processor* processor) const;
+
+    void setSingleDelay(SingleDelay& sdelay);
+    void setDoubleDelay(DoubleDelay& ddelay);
+    void setFeedbackDelay(FeedbackDelay& fdelay);
+    void setChorus(MultiChorus& chorus);
+    void setFlanger(FeedbackChorus& flanger);
+    void setReverb1(Reverb1& verb1);
+    void setReverb2(Reverb2& verb2);
+    void setReverb3(Reverb3& verb3);
+    void setFDNReverb(FDNReverb& fdn);
+    void setConvolutionReverb(ConvolutionReverb& convolution);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,216 @@
+/*
+EffectGraph.cpp
+
+Definitions of the EffectGraph class. Serial and parallel
+Processor chains compiled into a flat plan of steps over a
+small pool of reused buffers.
+*/
+
+#include "EffectGraph.h"
+
+//static variables
+const int EffectGraph::INPUT;
+const int EffectGraph::INPUT_BUFFER;
+
+EffectGraph::~EffectGraph(){
+    destroyBuffers();
+}
+
+EffectGraph::EffectGraph(){
+    output = INPUT;
+    outputBuffer = INPUT_BUFFER;
+    numBuffers = 0;
+    numChannels = 0;
+    bufferPool = 0;
+    bufferChannels = 0;
+
+    clear();
+}
+
+int EffectGraph::addProcessor(Processor* processor, int source){
+    if(processor == 0 || source < 0 || source >= static_cast<int>(nodes.size()))
+        return -1;
+
+    //A processor keeps one state, it can't run at two places in the graph
+    for(unsigned int n = 0; n < nodes.size(); n++){
+        if(nodes[n].processor == processor)
+            return -1;
+    }
+
+    Node node;
+    node.processor = processor;
+    node.source1 = source;
+    node.source2 = -1;
+    node.gain1 = 1.0;
+    node.gain2 = 0.0;
+    nodes.push_back(node);
+
+    return static_cast<int>(nodes.size()) - 1;
+}
+
+int EffectGraph::addMix(int source1, double gain1, int source2, double gain2){
+    int size = static_cast<int>(nodes.size());
+    if(source1 < 0 || source1 >= size || source2 < 0 || source2 >= size)
+        return -1;
+
+    Node node;
+    node.processor = 0;
+    node.source1 = source1;
+    node.source2 = source2;
+    node.gain1 = gain1;
+    node.gain2 = gain2;
+    nodes.push_back(node);
+
+    return size;
+}
+
+void EffectGraph::setOutput(int node){
+    if(node >= 0 && node < static_cast<int>(nodes.size()))
+        output = node;
+}
+
+void EffectGraph::clear(){
+    nodes.clear();
+    plan.clear();
+
+    //Node 0, the graph input
+    Node input;
+    input.processor = 0;
+    input.source1 = -1;
+    input.source2 = -1;
+    input.gain1 = 1.0;
+    input.gain2 = 0.0;
+    nodes.push_back(input);
+
+    output = INPUT;
+    outputBuffer = INPUT_BUFFER;
+}
+
+//Builds the step list and the buffer assignment from the nodes
+void EffectGraph::compile(){
+    int size = static_cast<int>(nodes.size());
+    plan.clear();
+    numBuffers = 0;
+
+    //Last node reading each node. The output is read after every step
+    std::vector<int> lastUse(size, -1);
+    for(int n = 1; n < size; n++){
+        lastUse[nodes[n].source1] = n;
+        if(nodes[n].source2 >= 0)
+            lastUse[nodes[n].source2] = n;
+    }
+    lastUse[output] = size;
+
+    std::vector<int> bufferOf(size, INPUT_BUFFER);
+    std::vector<int> freeBuffers;
+
+    for(int n = 1; n < size; n++){
+        const Node& node = nodes[n];
+
+        //Nodes nobody reads are dead, skip them
+        if(lastUse[n] < 0)
+            continue;
+
+        Step step;
+        step.processor = node.processor;
+        step.source1 = bufferOf[node.source1];
+        step.source2 = (node.source2 >= 0) ? bufferOf[node.source2] : INPUT_BUFFER;
+        step.gain1 = node.gain1;
+        step.gain2 = node.gain2;
+        step.target = INPUT_BUFFER;
+
+        //Work in place on a source that dies here. The caller's input is never written
+        if(step.source1 != INPUT_BUFFER && lastUse[node.source1] == n)
+            step.target = step.source1;
+        else if(node.source2 >= 0 && step.source2 != INPUT_BUFFER && lastUse[node.source2] == n)
+            step.target = step.source2;
+        else if(!freeBuffers.empty()){
+            step.target = freeBuffers.back();
+            freeBuffers.pop_back();
+        }
+        else
+            step.target = numBuffers++;
+
+        //Hand back the buffers of sources read for the last time
+        if(step.source1 != INPUT_BUFFER && lastUse[node.source1] == n && step.source1 != step.target)
+            freeBuffers.push_back(step.source1);
+        if(node.source2 >= 0 && node.source2 != node.source1 && step.source2 != INPUT_BUFFER
+            && lastUse[node.source2] == n && step.source2 != step.target)
+            freeBuffers.push_back(step.source2);
+
+        bufferOf[n] = step.target;
+        plan.push_back(step);
+    }
+
+    outputBuffer = bufferOf[output];
+}
+
+//Compiles the plan, prepares every processor and allocates the intermediate buffers
+void EffectGraph::prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels){
+    destroyBuffers();
+
+    compile();
+
+    for(unsigned int s = 0; s < plan.size(); s++){
+        if(plan[s].processor != 0)
+            plan[s].processor->prepare(tSampleRate, maxBlockSize, nChannels);
+    }
+
+    numChannels = nChannels;
+    bufferPool = new StkFloat[numBuffers * numChannels * maxBlockSize];
+    bufferChannels = new StkFloat*[numBuffers * numChannels];
+
+    for(int b = 0; b < numBuffers; b++){
+        for(unsigned int c = 0; c < numChannels; c++)
+            bufferChannels[b * numChannels + c] = bufferPool + (b * numChannels + c) * maxBlockSize;
+    }
+}
+
+//Runs the compiled plan on one block
+void EffectGraph::process(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+    for(unsigned int s = 0; s < plan.size(); s++){
+        const Step& step = plan[s];
+        StkFloat* const* target = bufferChannels + step.target * numChannels;
+
+        if(step.processor != 0){
+            step.processor->process(channelsOf(step.source1, in), target, nFrames);
+        }
+        //Bus: weighted sum of two buffers, possibly in place on one of them
+        else{
+            const StkFloat* const* source1 = channelsOf(step.source1, in);
+            const StkFloat* const* source2 = channelsOf(step.source2, in);
+
+            for(unsigned int c = 0; c < numChannels; c++){
+                for(int i = 0; i < nFrames; i++)
+                    target[c][i] = (source1[c][i] * step.gain1) + (source2[c][i] * step.gain2);
+            }
+        }
+    }
+
+    //Copy the result out. An empty graph passes the input through
+    const StkFloat* const* result = channelsOf(outputBuffer, in);
+    for(unsigned int c = 0; c < numChannels; c++){
+        if(result[c] != out[c]){
+            for(int i = 0; i < nFrames; i++)
+                out[c][i] = result[c][i];
+        }
+    }
+}
+
+int EffectGraph::getNumBuffers() const{
+    return numBuffers;
+}
+
+const StkFloat* const* EffectGraph::channelsOf(int buffer, const StkFloat* const* in) const{
+    if(buffer == INPUT_BUFFER)
+        return in;
+
+    return bufferChannels + buffer * numChannels;
+}
+
+void EffectGraph::destroyBuffers(){
+    delete[ ] bufferPool;
+    bufferPool = 0;
+    delete[ ] bufferChannels;
+    bufferChannels = 0;
+}
@@ -0,0 +1,88 @@
+#ifndef __EFFECTGRAPH_H__
+#define __EFFECTGRAPH_H__
+
+#include "Processor.h"
+#include <vector>
+
+/*  Graph of Processors wired in series and in parallel.
+    Nodes are added in order and every node may only read nodes
+    added before it, so the insertion order is already a valid
+    execution order. Node 0 is the graph input.
+
+    prepare() compiles the graph into a flat list of steps and
+    assigns each step an intermediate buffer. A buffer is handed
+    back to the pool after the last step that reads it, so a
+    series chain runs in place in a single buffer no matter how
+    long it is. process() then only walks the steps.
+*/
+class EffectGraph : public Processor{
+public:
+    static const int INPUT = 0; //Node id of the graph input
+
+    ~EffectGraph(void);
+    EffectGraph(void);
+
+    //Adds a node running processor on the output of source. Returns the new node,
+    //or -1 if source does not exist or processor is already in the graph
+    int addProcessor(Processor* processor, int source);
+
+    //Adds a bus node summing gain1 * source1 + gain2 * source2 (wet/dry mixing).
+    //Returns the new node, or -1 if a source does not exist
+    int addMix(int source1, double gain1, int source2, double gain2);
+
+    //Selects the node that feeds the graph output
+    void setOutput(int node);
+
+    //Removes every node but the input
+    void clear(void);
+
+    //Compiles the plan, prepares every processor and allocates the intermediate buffers
+    void prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels);
+
+    //Runs the compiled plan on one block
+    void process(const StkFloat* const* in, StkFloat* const* out, int nFrames);
+
+    //Number of intermediate buffers the compiled plan needs
+    int getNumBuffers(void) const;
+
+private:
+    //A processor or bus in the graph
+    struct Node{
+        Processor* processor; //0 for the input and for mix nodes
+        int source1; //Node feeding the processor, or first node of a mix
+        int source2; //Second node of a mix, -1 for processors
+        double gain1; //Gain of source1 in a mix
+        double gain2; //Gain of source2 in a mix
+    };
+
+    //One entry of the compiled plan
+    struct Step{
+        Processor* processor; //0 for a mix step
+        int source1; //Buffer read, INPUT_BUFFER for the graph input
+        int source2; //Second buffer read by a mix step
+        double gain1;
+        double gain2;
+        int target; //Buffer written
+    };
+
+    static const int INPUT_BUFFER = -1; //Buffer id standing for the caller's input block
+
+    //Builds the step list and the buffer assignment from the nodes
+    void compile(void);
+
+    //Channel pointers of a buffer, or of the caller's input for INPUT_BUFFER
+    const StkFloat* const* channelsOf(int buffer, const StkFloat* const* in) const;
+
+    void destroyBuffers(void);
+
+    std::vector<Node> nodes; //Nodes in insertion (execution) order
+    std::vector<Step> plan; //Compiled steps
+    int output; //Node feeding the output
+    int outputBuffer; //Buffer holding the output after the plan ran
+    int numBuffers; //Intermediate buffers used by the plan
+    unsigned int numChannels; //Channels per buffer
+    StkFloat* bufferPool; //numBuffers * numChannels blocks of maxBlockSize samples
+    StkFloat** bufferChannels; //Start of every channel of every buffer
+};
+
+#endif
@@ -0,0 +1,368 @@
+/*
+FDNReverb.cpp
+
+Definitions of the FDNReverb class. A Feedback Delay
+Network of 4, 8 or 16 damped delay lines mixed through a
+Householder or Hadamard matrix, the lines in lockstep.
+*/
+
+#include "FDNReverb.h"
+#include <cmath>
+
+//static variables
+int FDNReverb::MAX_MS_DELAY = 100; //100ms
+
+//Smallest prime that is at least n
+static int nextPrime(int n){
+    if(n <= 2)
+        return 2;
+    if(n % 2 == 0)
+        n++;
+
+    for(;; n += 2){
+        bool prime = true;
+        for(int d = 3; d * d <= n && prime; d += 2)
+            prime = (n % d != 0);
+
+        if(prime)
+            return n;
+    }
+}
+
+FDNReverb::~FDNReverb(){
+    delete[ ] lowPass;
+    delete[ ] wetBlock;
+}
+FDNReverb::FDNReverb(){
+    lines = 8;
+    numLines = 0;
+    matrix = HADAMARD;
+    feedbackMatrix = matrix;
+    size = 50;
+    reverbTime = 2000;
+    damping = 30;
+    sampleRate = 44100.0;
+
+    for(int k = 0; k < MAX_LINES; k++){
+        length[k] = 1;
+        readOffset[k] = 0;
+        lineGain[k] = 0.0;
+        inputGain[k] = 0.0;
+        outputGain[k] = 0.0;
+    }
+
+    rows = 1;
+    numChannels = 0;
+    lowPass = 0;
+    wetBlock = 0;
+
+    setMix(50);
+}
+
+//Sizes the delay lines for the stream
+void FDNReverb::prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels){
+    sampleRate = tSampleRate;
+    numLines = lines;
+    feedbackMatrix = matrix;
+    dryMix.prepare(tSampleRate);
+    wetMix.prepare(tSampleRate);
+
+    //Primes from half the size up to the size, evenly spread on a log scale.
+    //Each line is longer than the one before, so no two lines are the same
+    int longest = static_cast<int>((tSampleRate / 1000.0) * size);
+    rows = 1;
+
+    for(int k = 0; k < numLines; k++){
+        int target = static_cast<int>(0.5 * longest * pow(2.0, k / (1.0 * numLines)));
+        if(k > 0 && target <= length[k - 1])
+            target = length[k - 1] + 1;
+
+        length[k] = nextPrime(target);
+        if(length[k] > rows)
+            rows = length[k];
+    }
+
+    double outputScale = 1.0 / sqrt(1.0 * numLines);
+
+    for(int k = 0; k < numLines; k++){
+        //A line's tap is length rows behind the write row
+        readOffset[k] = (rows - length[k]) * numLines + k;
+
+        inputGain[k] = (k & 1) ? -1.0 : 1.0;
+        outputGain[k] = (k & 2) ? -outputScale : outputScale;
+    }
+
+    setLineGains();
+
+    numChannels = nChannels;
+    rings.allocate(numChannels, rows, numLines, precision);
+
+    delete[ ] lowPass;
+    lowPass = new double[numChannels * MAX_LINES];
+    for(unsigned int i = 0; i < numChannels * MAX_LINES; i++)
+        lowPass[i] = 0.0;
+
+    delete[ ] wetBlock;
+    wetBlock = new double[maxBlockSize];
+}
+
+void FDNReverb::process(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+    //Mix gains of this block, every channel walks the same ramps
+    double dryStep, wetStep;
+    double dryStart = dryMix.begin(nFrames, dryStep);
+    double wetStart = wetMix.begin(nFrames, wetStep);
+
+    //Every channel has its own network, so run the channels one after another
+    for(unsigned int c = 0; c < numChannels; c++){
+        const StkFloat *input = in[c];
+        StkFloat *output = out[c];
+        double dryNow = dryStart;
+        double wetNow = wetStart;
+
+        MirroredRings::Channel& ch = rings[c];
+        if(ch.ring32)
+            processLines(ch, ch.ring32, lowPass + c * MAX_LINES, input, wetBlock, nFrames);
+        else
+            processLines(ch, ch.ring, lowPass + c * MAX_LINES, input, wetBlock, nFrames);
+
+        for(int i = 0; i<nFrames; i++){
+            StkFloat sample = input[i];
+            computeSample(sample, wetBlock[i], dryNow, wetNow); //sample is passed by reference
+            output[i] = sample;
+
+            dryNow += dryStep;
+            wetNow += wetStep;
+        }
+    }
+
+    dryMix.end(nFrames);
+    wetMix.end(nFrames);
+}
+
+double FDNReverb::computeSample(double& in, double wetComponent, double dryGain, double wetGain){
+    //Compute input component
+    double inComponent = in * dryGain;
+
+    //Adjust wet signal by mix
+    wetComponent *= wetGain;
+
+    in = inComponent + wetComponent;
+
+    //limit output
+    if(in >= 1.0)
+        in = 0.9999;
+    else if(in <= -1.0)
+        in = -0.9999;
+
+    return in;
+}
+
+//Runs the network over nFrames of one channel and writes its output
+template <class Sample>
+void FDNReverb::processLines(MirroredRings::Channel& ch, Sample* ring, double* lowPass, const StkFloat* in, StkFloat* out, int nFrames){
+    int mirror = rings.getMirror();
+    double feedback = damping / 100.0; //of each low-pass
+    double feedforward = 1.0 - feedback;
+
+#if defined(__SIMD_SSE2__)
+    int pairs = numLines / 2;
+
+    const __m128d dampIn = _mm_set1_pd(feedforward);
+    const __m128d dampBack = _mm_set1_pd(feedback);
+    const __m128d hadamardScale = _mm_set1_pd(1.0 / sqrt(1.0 * numLines));
+    const __m128d householderScale = _mm_set1_pd(2.0 / numLines);
+
+    __m128d state[MAX_LINES / 2], gain[MAX_LINES / 2], inGain[MAX_LINES / 2], outGain[MAX_LINES / 2];
+    for(int j = 0; j < pairs; j++){
+        state[j] = _mm_loadu_pd(lowPass + 2 * j);
+        gain[j] = _mm_loadu_pd(lineGain + 2 * j);
+        inGain[j] = _mm_loadu_pd(inputGain + 2 * j);
+        outGain[j] = _mm_loadu_pd(outputGain + 2 * j);
+    }
+
+    for(int i = 0; i < nFrames; i++){
+        Sample* row = ring + ch.writeRow * numLines;
+        __m128d y[MAX_LINES / 2];
+        __m128d sum = _mm_setzero_pd();
+
+        //Each line reads its own tap, then runs it through its low-pass and gain
+        for(int j = 0; j < pairs; j++){
+            __m128d tap = _mm_set_pd(row[readOffset[2 * j + 1]], row[readOffset[2 * j]]);
+
+            state[j] = _mm_add_pd(_mm_mul_pd(tap, dampIn), _mm_mul_pd(state[j], dampBack));
+            y[j] = _mm_mul_pd(state[j], gain[j]);
+            sum = _mm_add_pd(sum, _mm_mul_pd(y[j], outGain[j]));
+        }
+        out[i] = _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+
+        if(feedbackMatrix == HADAMARD){
+            //Butterflies between the two lines of a register first...
+            for(int j = 0; j < pairs; j++){
+                __m128d swapped = _mm_shuffle_pd(y[j], y[j], 1);
+                y[j] = _mm_unpacklo_pd(_mm_add_pd(y[j], swapped), _mm_sub_pd(y[j], swapped));
+            }
+            //...then between registers, h registers apart
+            for(int h = 1; h < pairs; h *= 2){
+                for(int first = 0; first < pairs; first += 2 * h){
+                    for(int j = first; j < first + h; j++){
+                        __m128d a = y[j];
+                        __m128d b = y[j + h];
+                        y[j] = _mm_add_pd(a, b);
+                        y[j + h] = _mm_sub_pd(a, b);
+                    }
+                }
+            }
+            for(int j = 0; j < pairs; j++)
+                y[j] = _mm_mul_pd(y[j], hadamardScale);
+        }
+        else{
+            //Every line gives up 2/N of the sum of all lines
+            __m128d total = y[0];
+            for(int j = 1; j < pairs; j++)
+                total = _mm_add_pd(total, y[j]);
+            total = _mm_add_pd(total, _mm_shuffle_pd(total, total, 1));
+            total = _mm_mul_pd(total, householderScale);
+
+            for(int j = 0; j < pairs; j++)
+                y[j] = _mm_sub_pd(y[j], total);
+        }
+
+        //Every line writes the same row
+        __m128d input = _mm_set1_pd(in[i]);
+        for(int j = 0; j < pairs; j++){
+            __m128d next = _mm_add_pd(_mm_mul_pd(input, inGain[j]), y[j]);
+            storePair(row + 2 * j, next);
+            storePair(row + mirror + 2 * j, next);
+        }
+
+        if(++ch.writeRow == rows)
+            ch.writeRow = 0;
+    }
+
+    for(int j = 0; j < pairs; j++)
+        _mm_storeu_pd(lowPass + 2 * j, state[j]);
+#else
+    double hadamardScale = 1.0 / sqrt(1.0 * numLines);
+    double householderScale = 2.0 / numLines;
+    double y[MAX_LINES];
+
+    for(int i = 0; i < nFrames; i++){
+        Sample* row = ring + ch.writeRow * numLines;
+        double sum = 0.0;
+
+        for(int k = 0; k < numLines; k++){
+            lowPass[k] = row[readOffset[k]] * feedforward + lowPass[k] * feedback;
+            y[k] = lowPass[k] * lineGain[k];
+            sum += y[k] * outputGain[k];
+        }
+        out[i] = sum;
+
+        if(feedbackMatrix == HADAMARD){
+            for(int h = 1; h < numLines; h *= 2){
+                for(int first = 0; first < numLines; first += 2 * h){
+                    for(int k = first; k < first + h; k++){
+                        double a = y[k];
+                        double b = y[k + h];
+                        y[k] = a + b;
+                        y[k + h] = a - b;
+                    }
+                }
+            }
+            for(int k = 0; k < numLines; k++)
+                y[k] *= hadamardScale;
+        }
+        else{
+            double total = 0.0;
+            for(int k = 0; k < numLines; k++)
+                total += y[k];
+            total *= householderScale;
+
+            for(int k = 0; k < numLines; k++)
+                y[k] -= total;
+        }
+
+        for(int k = 0; k < numLines; k++){
+            double next = in[i] * inputGain[k] + y[k];
+            row[k] = static_cast<Sample>(next);
+            row[mirror + k] = static_cast<Sample>(next);
+        }
+
+        if(++ch.writeRow == rows)
+            ch.writeRow = 0;
+    }
+#endif
+}
+
+void FDNReverb::setMix(int tMix){
+    mix = tMix;
+
+    if(mix > 100 || mix < 0)
+        mix = 50;
+
+    //Ramps while streaming, prepare() settles it before
+    dryMix.setTarget((100 - mix) / 100.0);
+    wetMix.setTarget(mix / 100.0);
+}
+
+void FDNReverb::setNetwork(int tLines, Matrix tMatrix, int tSize){
+    lines = tLines;
+    matrix = tMatrix;
+    size = tSize;
+
+    if(lines != 4 && lines != 8 && lines != 16)
+        lines = 8;
+    if(matrix != HOUSEHOLDER && matrix != HADAMARD)
+        matrix = HADAMARD;
+    if(size > MAX_MS_DELAY || size < 10)
+        size = MAX_MS_DELAY / 2;
+}
+
+void FDNReverb::setReverbTime(int tReverbTime){
+    if(tReverbTime <= 20000 && tReverbTime >= 100){
+        reverbTime = tReverbTime;
+        setLineGains();
+    }
+}
+
+void FDNReverb::setDamping(int tDamping){
+    if(tDamping < 100 && tDamping >= 0)
+        damping = tDamping;
+}
+
+//Each trip round a line of length samples takes length / sampleRate seconds,
+//so its gain is the share of the 60dB a trip that long should lose
+void FDNReverb::setLineGains(){
+    double samples = (reverbTime / 1000.0) * sampleRate;
+
+    for(int k = 0; k < numLines; k++)
+        lineGain[k] = pow(10.0, -3.0 * length[k] / samples);
+}
+
+//Live parameter changes, applied between blocks
+const char* FDNReverb::PARAMETER_NAMES[] = {"Mix (0-100)", "Reverb time (100-20000ms)", "Damping (0-99)"};
+
+int FDNReverb::getNumParameters() const{
+    return NUM_PARAMETERS;
+}
+const char* FDNReverb::getParameterName(int parameter) const{
+    if(parameter < 0 || parameter >= NUM_PARAMETERS)
+        return "";
+
+    return PARAMETER_NAMES[parameter];
+}
+void FDNReverb::setParameter(int parameter, double value){
+    int amount = static_cast<int>(value);
+
+    switch(parameter){
+        case MIX:
+            if(amount >= 0 && amount <= 100)
+                setMix(amount);
+            break;
+        case REVERB_TIME:
+            setReverbTime(amount);
+            break;
+        case DAMPING:
+            setDamping(amount);
+            break;
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef __FDNREVERB_H__
+#define __FDNREVERB_H__
+
+#include "Processor.h"
+#include "Smoother.h"
+#include "MirroredRings.h"
+#include "Simd.h"
+
+/*  Feedback Delay Network reverb. 4, 8 or 16 delay lines feed
+    each other through an orthogonal matrix, so every echo is
+    spread over every line on its next trip and the tail thickens
+    much faster than a bank of separate combs of the same cost.
+
+    Each line has the low-pass of an LPComb in its loop, as a
+    one-pole so the loop gain stays below 1, then a gain worked
+    out from its length so all lines fall 60dB in the reverb time.
+    The matrix is a Householder reflection, I - 2/N, in O(N), or a
+    normalized Hadamard matrix as a fast Walsh-Hadamard transform
+    in O(N log N).
+
+    The lines run in lockstep over MirroredRings, like CombBank:
+    a row holds one sample of every line, each line reads its own
+    row, and the math across lines runs two lines per SSE2
+    register. The line lengths are primes between half
+    the size and the size, so the echoes do not pile up.
+*/
+class FDNReverb : public Processor{
+public:
+    static int MAX_MS_DELAY; //Maximum length of the longest line
+    static const int MAX_LINES = 16; //Lines a network has room for
+
+    enum Matrix {HOUSEHOLDER, HADAMARD}; //Feedback matrices
+
+    //Live parameters, see Processor::setParameter()
+    enum Parameter {MIX, REVERB_TIME, DAMPING, NUM_PARAMETERS};
+
+    ~FDNReverb(void);
+    FDNReverb(void);
+
+    //Sizes the delay lines for the stream. Call once before streaming starts
+    void prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels);
+
+    //Processes one block, one channel at a time. The network runs over the
+    //whole block first, then it is mixed with the dry signal
+    void process(const StkFloat* const* in, StkFloat* const* out, int nFrames);
+
+    //wetComponent is the network's output at this sample, dryGain and wetGain are the mix
+    double computeSample(double& in, double wetComponent, double dryGain, double wetGain);
+
+    void setMix(int tMix);
+
+    //4, 8 or 16 lines, the longest tSize ms long. Heard from the next prepare()
+    void setNetwork(int tLines, Matrix tMatrix, int tSize);
+
+    //Time for the tail to fall 60dB, in ms
+    void setReverbTime(int tReverbTime);
+
+    //Low-pass in the loop, 0% leaves the tail bright
+    void setDamping(int tDamping);
+
+    //Live parameter changes, applied between blocks
+    int getNumParameters(void) const;
+    const char* getParameterName(int parameter) const;
+    void setParameter(int parameter, double value);
+
+private:
+    static const char* PARAMETER_NAMES[]; //Menu names of the live parameters
+
+    //Runs the network over nFrames of one channel and writes its output. ring is the channel's
+    //ring of Sample, lowPass the channel's MAX_LINES low-pass states
+    template <class Sample>
+    void processLines(MirroredRings::Channel& ch, Sample* ring, double* lowPass, const StkFloat* in, StkFloat* out, int nFrames);
+
+    //Works out each line's gain for the reverb time
+    void setLineGains(void);
+
+    int mix; //ratio of Wet / Dry signals
+    Smoother dryMix; //(100 - mix) / 100, ramped when the mix changes live
+    Smoother wetMix; //mix / 100, ramped when the mix changes live
+
+    int lines; //4, 8 or 16
+    int numLines; //Lines the rings were sized for, lines takes over in prepare()
+    Matrix matrix; //Feedback matrix
+    Matrix feedbackMatrix; //Matrix the running network mixes through, matrix takes over in prepare()
+    int size; //Length of the longest line, 10-100ms
+    int reverbTime; //100-20000ms
+    int damping; //0%-99%
+    double sampleRate; //Sample rate the lines were sized for
+
+    int length[MAX_LINES]; //Length of each line in samples
+    int readOffset[MAX_LINES]; //Offset from the write row's first line to the line's tap
+    double lineGain[MAX_LINES]; //Loop gain of each line for the reverb time
+    double inputGain[MAX_LINES]; //+-1, alternating so the lines start out different
+    double outputGain[MAX_LINES]; //+-1/sqrt(lines), a different pattern from the input
+
+    int rows; //Rows in one copy of the ring
+    MirroredRings rings; //One ring per channel
+    unsigned int numChannels; //Number of rings
+    double* lowPass; //Last output of each line's low-pass, MAX_LINES per channel
+    double* wetBlock; //The network's output for one block of one channel
+
+    //Not copyable, the rings belong to one reverb
+    FDNReverb(const FDNReverb&);
+    FDNReverb& operator=(const FDNReverb&);
+};
+
+#endif
@@ -0,0 +1,370 @@
+/*
+FFT.cpp
+
+Definitions of the FFT class. An iterative radix-4 complex
+FFT of half the size, with a radix-2 pass when the size
+needs one and the real-input split and merge around it.
+Plans are cached by size.
+*/
+
+#include "FFT.h"
+#include "Thread.h"
+#include <cmath>
+
+//Tables of one size, shared by every FFT of that size
+struct FFT::Plan{
+    int size; //Real samples per transform
+    int bits; //log2 of half the size
+    int* bitReverse; //Bit-reversed index of each of the half points
+    double* cosine; //cos(2 pi k / size) for k < half, for the split and merge
+    double* sine; //sin(2 pi k / size) for k < half
+    double* twiddles; //Every radix-4 pass in order, six rows of a quarter span: w, w^2, w^3, real then imaginary
+    Plan* next; //Next cached plan
+};
+
+//static variables
+FFT::Plan* FFT::plans = 0;
+static Mutex planLock; //Effects are prepared on several threads at once in batch mode
+
+FFT::~FFT(){
+    delete[ ] workRe;
+    delete[ ] workIm;
+}
+
+FFT::FFT(){
+    plan = 0;
+    size = 0;
+    half = 0;
+    workRe = 0;
+    workIm = 0;
+}
+
+//Sizes the FFT for transforms of tSize real samples
+void FFT::setSize(int tSize){
+    plan = findPlan(tSize);
+    size = tSize;
+    half = size / 2;
+
+    delete[ ] workRe;
+    delete[ ] workIm;
+    workRe = new double[half];
+    workIm = new double[half];
+}
+
+int FFT::getSize() const{
+    return size;
+}
+
+//Plan for tSize, built and cached the first time
+const FFT::Plan* FFT::findPlan(int tSize){
+    planLock.lock();
+
+    Plan* found = plans;
+    while(found && found->size != tSize)
+        found = found->next;
+
+    if(!found){
+        int tHalf = tSize / 2;
+        double twoPi = 8.0 * atan(1.0); //to full precision, STK's PI is rounded
+
+        found = new Plan;
+        found->size = tSize;
+        found->bitReverse = new int[tHalf];
+        found->cosine = new double[tHalf];
+        found->sine = new double[tHalf];
+
+        int bits = 0;
+        while((1 << bits) < tHalf)
+            bits++;
+        found->bits = bits;
+
+        for(int k = 0; k < tHalf; k++){
+            int reversed = 0;
+            for(int b = 0; b < bits; b++){
+                if(k & (1 << b))
+                    reversed |= 1 << (bits - 1 - b);
+            }
+            found->bitReverse[k] = reversed;
+
+            double angle = twoPi * k / tSize;
+            found->cosine[k] = cos(angle);
+            found->sine[k] = sin(angle);
+        }
+
+        //Radix-4 passes over spans of 4 or 8 points and up, a quarter span of twiddles each
+        int rows = 0;
+        for(int span = (bits & 1) ? 8 : 4; span <= tHalf; span *= 4)
+            rows += 6 * (span / 4);
+
+        found->twiddles = new double[rows > 0 ? rows : 1];
+
+        double* row = found->twiddles;
+        for(int span = (bits & 1) ? 8 : 4; span <= tHalf; span *= 4){
+            int quarter = span / 4;
+            for(int m = 1; m <= 3; m++){
+                for(int j = 0; j < quarter; j++){
+                    double angle = twoPi * m * j / span;
+                    row[(2 * m - 2) * quarter + j] = cos(angle);
+                    row[(2 * m - 1) * quarter + j] = -sin(angle); //forward, e^(-i angle)
+                }
+            }
+            row += 6 * quarter;
+        }
+
+        found->next = plans;
+        plans = found;
+    }
+
+    planLock.unlock();
+    return found;
+}
+
+//size real samples in, size/2 + 1 bins out
+void FFT::forward(const double* in, double* re, double* im){
+    load(in);
+    transform();
+
+    re[0] = workRe[0] + workIm[0];
+    im[0] = 0.0;
+    re[half] = workRe[0] - workIm[0];
+    im[half] = 0.0;
+
+    split(re, im, 1);
+}
+
+//size/2 + 1 bins in, size real samples out
+void FFT::inverse(const double* re, const double* im, double* out){
+    merge(re, im, 1, re[0], re[half]);
+    transform();
+    unload(out);
+}
+
+//In place, the spectrum packed into the samples
+void FFT::forward(double* data){
+    load(data); //data is free from here on
+    transform();
+
+    split(data, data + 1, 2);
+    data[0] = workRe[0] + workIm[0];
+    data[1] = workRe[0] - workIm[0];
+}
+
+//In place, a packed spectrum back to the samples
+void FFT::inverse(double* data){
+    merge(data, data + 1, 2, data[0], data[1]);
+    transform();
+    unload(data);
+}
+
+//Even samples of in to workRe, odd samples to workIm
+void FFT::load(const double* in){
+    for(int k = 0; k < half; k++){
+        workRe[k] = in[2 * k];
+        workIm[k] = in[2 * k + 1];
+    }
+}
+
+//Bin k of the even samples is (Z[k] + conj(Z[half - k])) / 2,
+//of the odd samples (Z[k] - conj(Z[half - k])) / 2i
+void FFT::split(double* re, double* im, int stride) const{
+    for(int k = 1; k < half; k++){
+        double zr = workRe[k];
+        double zi = workIm[k];
+        double cr = workRe[half - k];
+        double ci = -workIm[half - k];
+
+        double evenRe = 0.5 * (zr + cr);
+        double evenIm = 0.5 * (zi + ci);
+        double oddRe = 0.5 * (zi - ci);
+        double oddIm = 0.5 * (cr - zr);
+
+        //The odd samples are one sample late, turn them back by e^(-2 pi i k / size)
+        double turnedRe = oddRe * plan->cosine[k] + oddIm * plan->sine[k];
+        double turnedIm = oddIm * plan->cosine[k] - oddRe * plan->sine[k];
+
+        re[k * stride] = evenRe + turnedRe;
+        im[k * stride] = evenIm + turnedIm;
+    }
+}
+
+//The split run backwards. The inverse FFT is the forward FFT of the
+//conjugate, conjugated again, so the spectrum goes in conjugated
+void FFT::merge(const double* re, const double* im, int stride, double dc, double nyquist){
+    for(int k = 0; k < half; k++){
+        double xr, xi, cr, ci;
+        if(k == 0){
+            xr = dc;
+            xi = 0.0;
+            cr = nyquist;
+            ci = 0.0;
+        }
+        else{
+            xr = re[k * stride];
+            xi = im[k * stride];
+            cr = re[(half - k) * stride];
+            ci = -im[(half - k) * stride];
+        }
+
+        double evenRe = 0.5 * (xr + cr);
+        double evenIm = 0.5 * (xi + ci);
+        double diffRe = 0.5 * (xr - cr);
+        double diffIm = 0.5 * (xi - ci);
+
+        double oddRe = diffRe * plan->cosine[k] - diffIm * plan->sine[k];
+        double oddIm = diffRe * plan->sine[k] + diffIm * plan->cosine[k];
+
+        workRe[k] = evenRe - oddIm;
+        workIm[k] = -(evenIm + oddRe);
+    }
+}
+
+//Scaled inverse of the conjugated spectrum to out
+void FFT::unload(double* out) const{
+    double scale = 1.0 / half;
+    for(int k = 0; k < half; k++){
+        out[2 * k] = workRe[k] * scale;
+        out[2 * k + 1] = -workIm[k] * scale;
+    }
+}
+
+//In-place forward complex FFT of half the size on workRe/workIm
+void FFT::transform(){
+    double* xr = workRe;
+    double* xi = workIm;
+
+    for(int k = 0; k < half; k++){
+        int reversed = plan->bitReverse[k];
+        if(k < reversed){
+            double swap = xr[k];
+            xr[k] = xr[reversed];
+            xr[reversed] = swap;
+
+            swap = xi[k];
+            xi[k] = xi[reversed];
+            xi[reversed] = swap;
+        }
+    }
+
+    int bits = plan->bits;
+
+    //An odd number of radix-2 passes leaves one over, done first on pairs
+    if(bits & 1){
+        for(int a = 0; a < half; a += 2){
+            double tr = xr[a + 1];
+            double ti = xi[a + 1];
+            xr[a + 1] = xr[a] - tr;
+            xi[a + 1] = xi[a] - ti;
+            xr[a] += tr;
+            xi[a] += ti;
+        }
+    }
+
+    //After bit reversal, the four quarters of a span hold the FFTs of the
+    //samples 0, 2, 1 and 3 mod 4, so X[j + m quarter] is
+    //a0 + w^2j a1 (-1)^m + w^j a2 (-i)^m + w^3j a3 (i)^m
+    const double* row = plan->twiddles;
+    for(int span = (bits & 1) ? 8 : 4; span <= half; span *= 4){
+        int quarter = span / 4;
+
+        if(quarter == 1){
+            //No twiddles in the first pass
+            for(int a = 0; a < half; a += 4){
+                double t0r = xr[a] + xr[a + 1], t0i = xi[a] + xi[a + 1];
+                double t1r = xr[a] - xr[a + 1], t1i = xi[a] - xi[a + 1];
+                double sr = xr[a + 2] + xr[a + 3], si = xi[a + 2] + xi[a + 3];
+                double dr = xr[a + 2] - xr[a + 3], di = xi[a + 2] - xi[a + 3];
+
+                xr[a] = t0r + sr;
+                xi[a] = t0i + si;
+                xr[a + 1] = t1r + di;
+                xi[a + 1] = t1i - dr;
+                xr[a + 2] = t0r - sr;
+                xi[a + 2] = t0i - si;
+                xr[a + 3] = t1r - di;
+                xi[a + 3] = t1i + dr;
+            }
+        }
+        else{
+            const double* w1r = row;
+            const double* w1i = row + quarter;
+            const double* w2r = row + 2 * quarter;
+            const double* w2i = row + 3 * quarter;
+            const double* w3r = row + 4 * quarter;
+            const double* w3i = row + 5 * quarter;
+
+            for(int start = 0; start < half; start += span){
+                double* r0 = xr + start;
+                double* i0 = xi + start;
+                double* r1 = r0 + quarter;
+                double* i1 = i0 + quarter;
+                double* r2 = r1 + quarter;
+                double* i2 = i1 + quarter;
+                double* r3 = r2 + quarter;
+                double* i3 = i2 + quarter;
+
+#if defined(__SIMD_SSE2__)
+                //Two butterflies per register, the quarter is always even here
+                for(int j = 0; j < quarter; j += 2){
+                    __m128d ar = _mm_loadu_pd(r0 + j), ai = _mm_loadu_pd(i0 + j);
+                    __m128d br = _mm_loadu_pd(r1 + j), bi = _mm_loadu_pd(i1 + j);
+                    __m128d cr = _mm_loadu_pd(r2 + j), ci = _mm_loadu_pd(i2 + j);
+                    __m128d er = _mm_loadu_pd(r3 + j), ei = _mm_loadu_pd(i3 + j);
+
+                    __m128d wr = _mm_loadu_pd(w2r + j), wi = _mm_loadu_pd(w2i + j);
+                    __m128d c1r = _mm_sub_pd(_mm_mul_pd(wr, br), _mm_mul_pd(wi, bi));
+                    __m128d c1i = _mm_add_pd(_mm_mul_pd(wr, bi), _mm_mul_pd(wi, br));
+
+                    wr = _mm_loadu_pd(w1r + j);
+                    wi = _mm_loadu_pd(w1i + j);
+                    __m128d c2r = _mm_sub_pd(_mm_mul_pd(wr, cr), _mm_mul_pd(wi, ci));
+                    __m128d c2i = _mm_add_pd(_mm_mul_pd(wr, ci), _mm_mul_pd(wi, cr));
+
+                    wr = _mm_loadu_pd(w3r + j);
+                    wi = _mm_loadu_pd(w3i + j);
+                    __m128d c3r = _mm_sub_pd(_mm_mul_pd(wr, er), _mm_mul_pd(wi, ei));
+                    __m128d c3i = _mm_add_pd(_mm_mul_pd(wr, ei), _mm_mul_pd(wi, er));
+
+                    __m128d t0r = _mm_add_pd(ar, c1r), t0i = _mm_add_pd(ai, c1i);
+                    __m128d t1r = _mm_sub_pd(ar, c1r), t1i = _mm_sub_pd(ai, c1i);
+                    __m128d sr = _mm_add_pd(c2r, c3r), si = _mm_add_pd(c2i, c3i);
+                    __m128d dr = _mm_sub_pd(c2r, c3r), di = _mm_sub_pd(c2i, c3i);
+
+                    _mm_storeu_pd(r0 + j, _mm_add_pd(t0r, sr));
+                    _mm_storeu_pd(i0 + j, _mm_add_pd(t0i, si));
+                    _mm_storeu_pd(r1 + j, _mm_add_pd(t1r, di));
+                    _mm_storeu_pd(i1 + j, _mm_sub_pd(t1i, dr));
+                    _mm_storeu_pd(r2 + j, _mm_sub_pd(t0r, sr));
+                    _mm_storeu_pd(i2 + j, _mm_sub_pd(t0i, si));
+                    _mm_storeu_pd(r3 + j, _mm_sub_pd(t1r, di));
+                    _mm_storeu_pd(i3 + j, _mm_add_pd(t1i, dr));
+                }
+#else
+                for(int j = 0; j < quarter; j++){
+                    double c1r = w2r[j] * r1[j] - w2i[j] * i1[j];
+                    double c1i = w2r[j] * i1[j] + w2i[j] * r1[j];
+                    double c2r = w1r[j] * r2[j] - w1i[j] * i2[j];
+                    double c2i = w1r[j] * i2[j] + w1i[j] * r2[j];
+                    double c3r = w3r[j] * r3[j] - w3i[j] * i3[j];
+                    double c3i = w3r[j] * i3[j] + w3i[j] * r3[j];
+
+                    double t0r = r0[j] + c1r, t0i = i0[j] + c1i;
+                    double t1r = r0[j] - c1r, t1i = i0[j] - c1i;
+                    double sr = c2r + c3r, si = c2i + c3i;
+                    double dr = c2r - c3r, di = c2i - c3i;
+
+                    r0[j] = t0r + sr;
+                    i0[j] = t0i + si;
+                    r1[j] = t1r + di;
+                    i1[j] = t1i - dr;
+                    r2[j] = t0r - sr;
+                    i2[j] = t0i - si;
+                    r3[j] = t1r - di;
+                    i3[j] = t1i + dr;
+                }
+#endif
+            }
+        }
+
+        row += 6 * quarter;
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef __FFT_H__
+#define __FFT_H__
+
+#include "Simd.h"
+
+/*  Real-input FFT of a power-of-two size. The real signal is
+    packed into a complex FFT of half the size, even samples as
+    the real parts and odd samples as the imaginary parts, and the
+    two halves of the spectrum are pulled apart afterwards.
+
+    The complex FFT is iterative and decimated in time: radix-4
+    passes, each doing the work of two radix-2 passes with three
+    complex multiplies instead of four, and one radix-2 pass first
+    when the size needs it. The real and imaginary parts are kept
+    in separate arrays so the butterflies run two at a time per
+    SSE2 register.
+
+    The tables of a size, bit reversal and twiddles, are a plan.
+    Plans are built once per size and shared by every FFT of that
+    size for the life of the program, so the channels of a reverb
+    and the partitions of a convolver pay for them once.
+
+    Spectra are split into real and imaginary arrays of size/2 + 1
+    bins, DC to Nyquist, or packed in place into the size samples.
+    Every table and work buffer is allocated by setSize(), so
+    forward() and inverse() are safe on the audio thread.
+*/
+class FFT{
+public:
+    ~FFT(void);
+    FFT(void);
+
+    //Sizes the FFT for transforms of tSize real samples, a power of two of at least 4.
+    //Builds the plan the first time a size is asked for
+    void setSize(int tSize);
+
+    int getSize(void) const;
+
+    //size real samples in, size/2 + 1 bins out
+    void forward(const double* in, double* re, double* im);
+
+    //size/2 + 1 bins in, size real samples out. Scaled so that
+    //forward() then inverse() gives back the input
+    void inverse(const double* re, const double* im, double* out);
+
+    //In place: size real samples in, the spectrum packed into them out.
+    //data[0] is DC, data[1] Nyquist, then the real and imaginary parts of bins 1 to size/2 - 1
+    void forward(double* data);
+
+    //In place: a packed spectrum in, size real samples out
+    void inverse(double* data);
+
+private:
+    struct Plan; //Tables of one size, shared
+    static Plan* plans; //Every plan built so far
+
+    //Plan for tSize, built and cached the first time
+    static const Plan* findPlan(int tSize);
+
+    //Even samples of in to workRe, odd samples to workIm
+    void load(const double* in);
+
+    //Bins 1 to half - 1 of the real spectrum from the complex one in workRe/workIm,
+    //bin k written to re[k * stride], im[k * stride]
+    void split(double* re, double* im, int stride) const;
+
+    //The complex spectrum, conjugated, back into workRe/workIm from bins
+    //re[k * stride], im[k * stride] and the DC and Nyquist bins
+    void merge(const double* re, const double* im, int stride, double dc, double nyquist);
+
+    //Scaled inverse of the conjugated spectrum in workRe/workIm to out
+    void unload(double* out) const;
+
+    //In-place forward complex FFT of half the size on workRe/workIm
+    void transform(void);
+
+    const Plan* plan; //Tables of the size
+    int size; //Real samples per transform
+    int half; //Points of the complex FFT, size / 2
+    double* workRe; //Complex work buffer, real parts
+    double* workIm; //Complex work buffer, imaginary parts
+
+    //Not copyable, the work buffers belong to one FFT
+    FFT(const FFT&);
+    FFT& operator=(const FFT&);
+};
+
+#endif
@@ -8,16 +8,105 @@ Low-Passed Comb filter
 */
 
 #include "Filters.h"
-#include "AudioHandler.h"
 
+//How many samples back a tap reads: it trails the write pointer by
+//delaySamples, modulo the buffer. A tap on the write cell reads it
+//before the write, a whole buffer back
+static int tapAgeOf(int delaySamples, int length){
+    return (delaySamples + length - 1) % length + 1;
+}
+
+//Limiting, as selects so the block loops have no branches
+static inline double limit(double in){
+    in = (in >= 1.0) ? 0.9999 : in;
+    return (in <= -1.0) ? -0.9999 : in;
+}
 
+//Block kernels. Each runs n samples over one stretch of a delay line
+//that does not wrap and does not read back a cell it writes, so the
+//loops carry no dependence and vectorize. in and out may be the same.
+//Sample is the type the line is stored in, the math is always double
+template <class Sample>
+static void allpassStretch(const double* in, double* out, Sample* write, const Sample* read, int n, double feedback){
+    for(int i = 0; i < n; i++){
+        double delayComponent = read[i];
+        double firstSumComponent = in[i] + delayComponent * feedback;
+        write[i] = static_cast<Sample>(firstSumComponent);
+        out[i] = limit(firstSumComponent * (-feedback) + delayComponent);
+    }
+}
+
+template <class Sample>
+static void combStretch(const double* in, double* out, Sample* write, const Sample* read, int n, double feedback){
+    for(int i = 0; i < n; i++){
+        double sumComponent = in[i] + read[i] * feedback;
+        write[i] = static_cast<Sample>(sumComponent);
+        out[i] = limit(sumComponent * (-feedback));
+    }
+}
+
+template <class Sample>
+static void lowPassCombStretch(const double* in, double* out, Sample* write, const Sample* read, const Sample* readN1,
+                               int n, double feedback1, double feedback2){
+    for(int i = 0; i < n; i++){
+        double sumComponent = in[i] + (readN1[i] * feedback2 + read[i]) * feedback1;
+        write[i] = static_cast<Sample>(sumComponent);
+        out[i] = limit(sumComponent * (-feedback1));
+    }
+}
+
+//Single cells of whichever buffer a channel has, for computeSample()
+template <class Line>
+static inline double readCell(const Line& ch, int cell){
+    return ch.delayBuffer32 ? ch.delayBuffer32[cell] : ch.delayBuffer[cell];
+}
+
+template <class Line>
+static inline void writeCell(Line& ch, int cell, double value){
+    if(ch.delayBuffer32)
+        ch.delayBuffer32[cell] = static_cast<float>(value);
+    else
+        ch.delayBuffer[cell] = value;
+}
+
+//Allocates the channels' buffers, only the one the precision asks for
+template <class Line>
+static void allocateLines(Line* channels, unsigned int numChannels, int length, Processor::Precision precision){
+    for(unsigned int c = 0; c < numChannels; c++){
+        channels[c].delayBuffer = 0;
+        channels[c].delayBuffer32 = 0;
+
+        if(precision == Processor::FLOAT32)
+            channels[c].delayBuffer32 = new float[length];
+        else
+            channels[c].delayBuffer = new double[length];
+    }
+}
+
+//Zeroes the first length cells of the channels' buffers
+template <class Line>
+static void clearLines(Line* channels, unsigned int numChannels, int length){
+    for(unsigned int c = 0; c < numChannels; c++){
+        for(int i = 0; i < length; i++)
+            writeCell(channels[c], i, 0.0);
+
+        channels[c].writePtr = 0;
+    }
+}
+
+//Frees the channels' buffers and the channels
+template <class Line>
+static void destroyLines(Line* channels, unsigned int numChannels){
+    for(unsigned int c = 0; c < numChannels; c++){
+        delete[ ] channels[c].delayBuffer;
+        delete[ ] channels[c].delayBuffer32;
+    }
 
-//Global variable used
-const double fsPerMs = (AudioHandler::fs / 1000.0);
+    delete[ ] channels;
+}
 
 //***************** Allpass Filter ***********************************************
 int Allpass::MAX_MS_DELAY = 5000; //5 seconds
-int Allpass::MAX_BUFFER_LENGTH = static_cast<int>((Allpass::MAX_MS_DELAY / 1000.0) * AudioHandler::fs);
 
 Allpass::~Allpass(){
     destroyDelayBuffer();
@@ -25,109 +114,111 @@ Allpass::~Allpass(){
 Allpass::Allpass(){
     delay = 3995;
     decay = 50;
-    writePtr = 0;
-    delayPtr = (int) (-1) * (fsPerMs * delay);
-    bufferLength = 2 + ((delay / (1.0 * MAX_MS_DELAY)) * MAX_BUFFER_LENGTH);
+    feedback = decay / 100.0;
+
+    bufferLength = 2;
+    tapAge = bufferLength;
+    maxBufferLength = 0;
+    fsPerMs = 0.0;
+
+    channels = 0;
+    numChannels = 0;
+}
+
+//allocates the delay buffers at their maximum length for the stream
+void Allpass::prepare(double tSampleRate, unsigned int /*maxBlockSize*/, unsigned int nChannels){
+    destroyDelayBuffer();
+
+    fsPerMs = tSampleRate / 1000.0;
+    maxBufferLength = static_cast<int>((MAX_MS_DELAY / 1000.0) * tSampleRate);
+
+    numChannels = nChannels;
+    channels = new Channel[numChannels];
+
+    allocateLines(channels, numChannels, 2 + maxBufferLength, precision);
 
     initializeDelayBuffer();
 }
 
-//initializes the delayBuffer into an array of proper size
+//sets the delay buffer length for the current delay and clears the buffers
 void Allpass::initializeDelayBuffer(){
-    destroyDelayBuffer();
+    bufferLength = 2 + ((delay / (1.0 * MAX_MS_DELAY)) * maxBufferLength);
+    tapAge = tapAgeOf(static_cast<int>(fsPerMs * delay), bufferLength);
 
-    delayBuffer = new double[bufferLength];
+    clearLines(channels, numChannels, bufferLength);
 }
 
 //destroys the current delay buffer
 void Allpass::destroyDelayBuffer(){
-    delete[ ] delayBuffer;
-    delayBuffer = 0; //null cast
+    destroyLines(channels, numChannels);
+    channels = 0; //null cast
+    numChannels = 0;
 }
 
-//Computation functions
-int Allpass::callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData ){
-    FileWvIn *input = (FileWvIn *) userData;
-        
-    tick(outputBuffer, input, nBufferFrames); 
+void Allpass::process(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+    for(unsigned int c = 0; c < numChannels; c++)
+        processChannel(in[c], out[c], nFrames, c);
+}
 
-    if ( input->isFinished() ) {
-        AudioHandler::done = true;
-        return 1;
-    }
-    else
-        return 0;
-}
-
-void Allpass::tick(void *outputBuffer, void *input,int nBufferFrames){
-    register StkFloat *out = (StkFloat *) outputBuffer;
-    FileWvIn *in = (FileWvIn *) input;
-    
-    StkFrames frames;
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
-
-    for(unsigned int i = 0; i<frames.size(); i++){
-        *out = computeSample(frames[i]); //assign output sample
-        out++; //move to next output sample
+//Runs the block in stretches up to the next wrap of either pointer, and
+//no longer than the delay, so a stretch never reads what it wrote
+void Allpass::processChannel(const StkFloat* in, StkFloat* out, int nFrames, unsigned int channel){
+    Channel& ch = channels[channel];
+    int done = 0;
+
+    while(done < nFrames){
+        int delayPtr = ch.writePtr - tapAge;
+        if(delayPtr < 0)
+            delayPtr += bufferLength;
+
+        int n = nFrames - done;
+        if(n > bufferLength - ch.writePtr)
+            n = bufferLength - ch.writePtr;
+        if(n > bufferLength - delayPtr)
+            n = bufferLength - delayPtr;
+        if(n > tapAge)
+            n = tapAge;
+
+        if(ch.delayBuffer32)
+            allpassStretch(in + done, out + done, ch.delayBuffer32 + ch.writePtr, ch.delayBuffer32 + delayPtr, n, feedback);
+        else
+            allpassStretch(in + done, out + done, ch.delayBuffer + ch.writePtr, ch.delayBuffer + delayPtr, n, feedback);
+
+        ch.writePtr += n;
+        if(ch.writePtr == bufferLength)
+            ch.writePtr = 0;
+        done += n;
     }
 }
 
-StkFrames& Allpass::tick(void *input, int nBufferFrames, StkFrames& frames){
-    FileWvIn *in = (FileWvIn *) input;
-    
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
+double Allpass::computeSample(double& in, unsigned int channel){
+    Channel& ch = channels[channel];
 
-    for(unsigned int i = 0; i<frames.size(); i++){
-        computeSample(frames[i]); //Frames[i] is passed by reference
-    }
+    //The delay cell trails the write pointer. Before the first echo it is still silence
+    int delayPtr = ch.writePtr - tapAge;
+    if(delayPtr < 0)
+        delayPtr += bufferLength;
 
-    return frames;
-}
+    //Compute outputs
+    double delayComponent = readCell(ch, delayPtr);
+    double feedbackComponent = delayComponent * feedback;
+    double firstSumComponent = in;
+    firstSumComponent += feedbackComponent;
 
-double Allpass::computeSample(double& in){   
-    if(delayPtr >= bufferLength)
-            delayPtr %= bufferLength;
-    if(writePtr >= bufferLength)
-            writePtr %= bufferLength;
-    
-    double inputSample = in;
+    //Feed firstSumComponent into the delay buffer
+    writeCell(ch, ch.writePtr, firstSumComponent);
+    //scale sum to pass to second sum component
+    firstSumComponent *= (-feedback);
+
+    //Compute output sample
+    in = firstSumComponent + delayComponent;
 
-    //Compute outputs
-    if(delayPtr >= 0){
-        double delayComponent = delayBuffer[delayPtr];
-        double feedbackComponent = delayComponent * (decay / 100.0);
-        double firstSumComponent = in;
-        firstSumComponent += feedbackComponent;
-        
-        //Feed firstSumComponent into the delay buffer
-        delayBuffer[writePtr] = firstSumComponent;
-        //scale sum to pass to second sum component
-        firstSumComponent *= (-decay / 100.0);
-
-        //Compute output sample
-        in = firstSumComponent + delayComponent;
-    }
-    else{
-        //fill initial delay buffer values
-        delayBuffer[writePtr] = in;
-        //compute output
-        in *= (-decay / 100.0);
-    }
     //Limiting
-    if(in >= 1.0)
-        in = 0.9999;
-    else if(in <= -1.0)
-        in = -0.9999;
+    in = limit(in);
 
-    //Update pointers
-    writePtr++;
-    delayPtr++;
+    //Update pointer
+    if(++ch.writePtr == bufferLength)
+        ch.writePtr = 0;
 
     return in;
 }
@@ -140,17 +231,20 @@ void Allpass::setAllpass(int tDelay, int tDecay){
         delay = MAX_MS_DELAY / 2;
     if(decay >= 100 || decay < 0)
         decay = 50;
-
-    writePtr = 0;
-    delayPtr = (int) (-1) * (fsPerMs * delay);
-    bufferLength = 2 + ((delay / (1.0 * MAX_MS_DELAY)) * MAX_BUFFER_LENGTH);
+    feedback = decay / 100.0;
 
     initializeDelayBuffer();
 }
 
+void Allpass::setDecay(int tDecay){
+    if(tDecay < 100 && tDecay >= 0){
+        decay = tDecay;
+        feedback = decay / 100.0;
+    }
+}
+
 //******************* Comb Filter ************************************************
 int Comb::MAX_MS_DELAY = 50; //50 ms
-int Comb::MAX_BUFFER_LENGTH = static_cast<int>((Comb::MAX_MS_DELAY / 1000.0) * AudioHandler::fs);
 
 Comb::~Comb(){
     destroyDelayBuffer();
@@ -158,108 +252,109 @@ Comb::~Comb(){
 Comb::Comb(){
     decay = 50;
     delay = 35;
+    feedback = decay / 100.0;
+
+    bufferLength = 2;
+    tapAge = bufferLength;
+    maxBufferLength = 0;
+    fsPerMs = 0.0;
 
-    writePtr = 0;
-    delayPtr = (int) (-1) * (fsPerMs * delay);
-    bufferLength = 2 +  ((delay / (1.0 * MAX_MS_DELAY)) * MAX_BUFFER_LENGTH);
+    channels = 0;
+    numChannels = 0;
+}
+
+//allocates the delay buffers at their maximum length for the stream
+void Comb::prepare(double tSampleRate, unsigned int /*maxBlockSize*/, unsigned int nChannels){
+    destroyDelayBuffer();
+
+    fsPerMs = tSampleRate / 1000.0;
+    maxBufferLength = static_cast<int>((MAX_MS_DELAY / 1000.0) * tSampleRate);
+
+    numChannels = nChannels;
+    channels = new Channel[numChannels];
+
+    allocateLines(channels, numChannels, 2 + maxBufferLength, precision);
 
     initializeDelayBuffer();
 }
 
-//initializes the delayBuffer into an array of proper size
+//sets the delay buffer length for the current delay and clears the buffers
 void Comb::initializeDelayBuffer(){
-    destroyDelayBuffer();
+    bufferLength = 2 + ((delay / (1.0 * MAX_MS_DELAY)) * maxBufferLength);
+    tapAge = tapAgeOf(static_cast<int>(fsPerMs * delay), bufferLength);
 
-    delayBuffer = new double[bufferLength];
+    clearLines(channels, numChannels, bufferLength);
 }
 
 //destroys the current delay buffer
 void Comb::destroyDelayBuffer(){
-    delete[ ] delayBuffer;
-    delayBuffer = 0; //null cast
+    destroyLines(channels, numChannels);
+    channels = 0; //null cast
+    numChannels = 0;
 }
 
-//Computation functions
-int Comb::callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData ){
-    FileWvIn *input = (FileWvIn *) userData;
-        
-    tick(outputBuffer, input, nBufferFrames); 
+void Comb::process(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+    for(unsigned int c = 0; c < numChannels; c++)
+        processChannel(in[c], out[c], nFrames, c);
+}
 
-    if ( input->isFinished() ) {
-        AudioHandler::done = true;
-        return 1;
-    }
-    else
-        return 0;
-}
-
-void Comb::tick(void *outputBuffer, void *input,int nBufferFrames){
-    register StkFloat *out = (StkFloat *) outputBuffer;
-    FileWvIn *in = (FileWvIn *) input;
-    
-    StkFrames frames;
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
-
-    for(unsigned int i = 0; i<frames.size(); i++){
-        *out = computeSample(frames[i]);
-        out++; //Move to next sample
+//Runs the block in stretches up to the next wrap of either pointer, and
+//no longer than the delay, so a stretch never reads what it wrote
+void Comb::processChannel(const StkFloat* in, StkFloat* out, int nFrames, unsigned int channel){
+    Channel& ch = channels[channel];
+    int done = 0;
+
+    while(done < nFrames){
+        int delayPtr = ch.writePtr - tapAge;
+        if(delayPtr < 0)
+            delayPtr += bufferLength;
+
+        int n = nFrames - done;
+        if(n > bufferLength - ch.writePtr)
+            n = bufferLength - ch.writePtr;
+        if(n > bufferLength - delayPtr)
+            n = bufferLength - delayPtr;
+        if(n > tapAge)
+            n = tapAge;
+
+        if(ch.delayBuffer32)
+            combStretch(in + done, out + done, ch.delayBuffer32 + ch.writePtr, ch.delayBuffer32 + delayPtr, n, feedback);
+        else
+            combStretch(in + done, out + done, ch.delayBuffer + ch.writePtr, ch.delayBuffer + delayPtr, n, feedback);
+
+        ch.writePtr += n;
+        if(ch.writePtr == bufferLength)
+            ch.writePtr = 0;
+        done += n;
     }
 }
 
-StkFrames& Comb::tick(void *input, int nBufferFrames, StkFrames& frames){
-    FileWvIn *in = (FileWvIn *) input;
-    
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
+double Comb::computeSample(double& in, unsigned int channel){
+    Channel& ch = channels[channel];
 
-    for(unsigned int i = 0; i<frames.size(); i++){
-        computeSample(frames[i]); //Passed by reference
-    }
+    //The delay cell trails the write pointer. Before the first echo it is still silence
+    int delayPtr = ch.writePtr - tapAge;
+    if(delayPtr < 0)
+        delayPtr += bufferLength;
 
-    return frames;
-}
+    //build sum point
+    double sumComponent = in;
+    double delayComponent = readCell(ch, delayPtr);
+    delayComponent *= feedback;
+    sumComponent += delayComponent;
 
-double Comb::computeSample(double& in){
-    if(delayPtr >= bufferLength)
-            delayPtr %= bufferLength;
-    if(writePtr >= bufferLength)
-            writePtr %= bufferLength;
+    //Pass in new value to delay
+    writeCell(ch, ch.writePtr, sumComponent);
 
-    //Compute outputs
-    if(delayPtr >= 0){
-        //build sum point
-        double sumComponent = in;
-        double delayComponent = delayBuffer[delayPtr];
-        delayComponent *= (decay / 100.0);
-        sumComponent += delayComponent;
-
-        //Pass in new value to delay
-        delayBuffer[writePtr] = sumComponent;
-
-        //compute output
-        in = sumComponent * (-decay / 100.0); 
-    }
-    else{
-        //fill delay
-        delayBuffer[writePtr] = in;
-        //delay unit has nothing to ouput
-        in *= (-decay / 100.0);
-    }
+    //compute output
+    in = sumComponent * (-feedback);
 
     //Limiting
-    if(in >= 1.0)
-        in = 0.9999;
-    else if(in <= -1.0)
-        in = -0.9999;
+    in = limit(in);
 
-    //Update pointers
-    writePtr++;
-    delayPtr++;
+    //Update pointer
+    if(++ch.writePtr == bufferLength)
+        ch.writePtr = 0;
 
     return in;
 }
@@ -273,17 +368,32 @@ void Comb::setComb(int tDelay, int tDecay){
         delay = MAX_MS_DELAY / 2;
     if(decay >= 100 || decay < 0)
         decay = 50;
-
-    writePtr = 0;
-    delayPtr = (int) (-1) * (fsPerMs * delay);
-    bufferLength = 2 +  ((delay / (1.0 * MAX_MS_DELAY)) * MAX_BUFFER_LENGTH);
+    feedback = decay / 100.0;
 
     initializeDelayBuffer();
 }
 
+void Comb::setDecay(int tDecay){
+    if(tDecay < 100 && tDecay >= 0){
+        decay = tDecay;
+        feedback = decay / 100.0;
+    }
+}
+
+//Same arithmetic as prepare() and initializeDelayBuffer()
+void Comb::getDelayLine(double tSampleRate, int& lag, int& length) const{
+    int maxLength = static_cast<int>((MAX_MS_DELAY / 1000.0) * tSampleRate);
+
+    length = static_cast<int>(2 + ((delay / (1.0 * MAX_MS_DELAY)) * maxLength));
+    lag = static_cast<int>((tSampleRate / 1000.0) * delay);
+}
+
+double Comb::getFeedback() const{
+    return feedback;
+}
+
 //************Low Pass Comb Filter ************************************************
 int LPComb::MAX_MS_DELAY = 50; //50 ms
-int LPComb::MAX_BUFFER_LENGTH = static_cast<int>((LPComb::MAX_MS_DELAY / 1000.0) * AudioHandler::fs);
 
 LPComb::~LPComb(){
     destroyDelayBuffer();
@@ -291,134 +401,128 @@ LPComb::~LPComb(){
 LPComb::LPComb(){
     decay1 = 45;
     decay2 = 55;
+    feedback1 = decay1 / 100.0;
+    feedback2 = decay2 / 100.0;
     delay = 35;
 
-    writePtr = 0;
-    delayPtr = (int) (-1) * (fsPerMs * delay);
-    delayPtrN1 = delayPtr - 1; //one sample back
-    bufferLength = 3 + ((delay / (1.0 * MAX_MS_DELAY)) * MAX_BUFFER_LENGTH);
+    bufferLength = 3;
+    tapAge = bufferLength;
+    tapAgeN1 = 1;
+    maxBufferLength = 0;
+    fsPerMs = 0.0;
+
+    channels = 0;
+    numChannels = 0;
+}
+
+//allocates the delay buffers at their maximum length for the stream
+void LPComb::prepare(double tSampleRate, unsigned int /*maxBlockSize*/, unsigned int nChannels){
+    destroyDelayBuffer();
+
+    fsPerMs = tSampleRate / 1000.0;
+    maxBufferLength = static_cast<int>((MAX_MS_DELAY / 1000.0) * tSampleRate);
+
+    numChannels = nChannels;
+    channels = new Channel[numChannels];
+
+    allocateLines(channels, numChannels, 3 + maxBufferLength, precision);
 
     initializeDelayBuffer();
 }
 
-//initializes the delayBuffer into an array of proper size
+//sets the delay buffer length for the current delay and clears the buffers
 void LPComb::initializeDelayBuffer(){
-    destroyDelayBuffer();
+    bufferLength = 3 + ((delay / (1.0 * MAX_MS_DELAY)) * maxBufferLength);
+    tapAge = tapAgeOf(static_cast<int>(fsPerMs * delay), bufferLength);
+    tapAgeN1 = tapAgeOf(static_cast<int>(fsPerMs * delay) + 1, bufferLength); //one sample back
 
-    delayBuffer = new double[bufferLength];
+    clearLines(channels, numChannels, bufferLength);
 }
 
 //destroys the current delay buffer
 void LPComb::destroyDelayBuffer(){
-    delete[ ] delayBuffer;
-    delayBuffer = 0; //null cast
+    destroyLines(channels, numChannels);
+    channels = 0; //null cast
+    numChannels = 0;
 }
 
-//Computation functions
-int LPComb::callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData ){
-    FileWvIn *input = (FileWvIn *) userData;
-        
-    tick(outputBuffer, input, nBufferFrames); 
+void LPComb::process(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+    for(unsigned int c = 0; c < numChannels; c++)
+        processChannel(in[c], out[c], nFrames, c);
+}
 
-    if ( input->isFinished() ) {
-        AudioHandler::done = true;
-        return 1;
-    }
-    else
-        return 0;
-}
-
-void LPComb::tick(void *outputBuffer, void *input,int nBufferFrames){
-    register StkFloat *out = (StkFloat *) outputBuffer;
-    FileWvIn *in = (FileWvIn *) input;
-    
-    StkFrames frames;
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
-
-    for(unsigned int i = 0; i<frames.size(); i++){
-        *out = computeSample(frames[i]);
-        out++; //move to next sample
+//Runs the block in stretches up to the next wrap of either pointer, and
+//no longer than the delay, so a stretch never reads what it wrote
+void LPComb::processChannel(const StkFloat* in, StkFloat* out, int nFrames, unsigned int channel){
+    Channel& ch = channels[channel];
+    int done = 0;
+
+    while(done < nFrames){
+        int delayPtr = ch.writePtr - tapAge;
+        if(delayPtr < 0)
+            delayPtr += bufferLength;
+        int delayPtrN1 = ch.writePtr - tapAgeN1;
+        if(delayPtrN1 < 0)
+            delayPtrN1 += bufferLength;
+
+        int n = nFrames - done;
+        if(n > bufferLength - ch.writePtr)
+            n = bufferLength - ch.writePtr;
+        if(n > bufferLength - delayPtr)
+            n = bufferLength - delayPtr;
+        if(n > bufferLength - delayPtrN1)
+            n = bufferLength - delayPtrN1;
+        if(n > tapAge)
+            n = tapAge;
+        if(n > tapAgeN1)
+            n = tapAgeN1;
+
+        if(ch.delayBuffer32)
+            lowPassCombStretch(in + done, out + done, ch.delayBuffer32 + ch.writePtr, ch.delayBuffer32 + delayPtr,
+                               ch.delayBuffer32 + delayPtrN1, n, feedback1, feedback2);
+        else
+            lowPassCombStretch(in + done, out + done, ch.delayBuffer + ch.writePtr, ch.delayBuffer + delayPtr,
+                               ch.delayBuffer + delayPtrN1, n, feedback1, feedback2);
+
+        ch.writePtr += n;
+        if(ch.writePtr == bufferLength)
+            ch.writePtr = 0;
+        done += n;
     }
 }
 
-StkFrames& LPComb::tick(void *input, int nBufferFrames, StkFrames& frames){
-    FileWvIn *in = (FileWvIn *) input;
-    
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
+double LPComb::computeSample(double& in, unsigned int channel){
+    Channel& ch = channels[channel];
 
-    for(unsigned int i = 0; i<frames.size(); i++){
-        computeSample(frames[i]); //passed by reference
-    }
+    //Both cells trail the write pointer. Before the first echo they are still
+    //silence, and the older one stays silent for one sample more
+    int delayPtr = ch.writePtr - tapAge;
+    if(delayPtr < 0)
+        delayPtr += bufferLength;
+    int delayPtrN1 = ch.writePtr - tapAgeN1;
+    if(delayPtrN1 < 0)
+        delayPtrN1 += bufferLength;
 
-    return frames;
-}
+    //add input to sum
+    double sumComponent = in;
+    //compute delay feedback into sum
+    double delayComponent = readCell(ch, delayPtrN1) * feedback2;
+    delayComponent += readCell(ch, delayPtr);
+    delayComponent *= feedback1;
+    sumComponent += delayComponent;
 
-double LPComb::computeSample(double& in){
-    if(delayPtr >= bufferLength)
-            delayPtr %= bufferLength;
-    if(delayPtrN1 >= bufferLength)
-            delayPtrN1 %= bufferLength;
-    if(writePtr >= bufferLength)
-            writePtr %= bufferLength;
+    //update delay buffer
+    writeCell(ch, ch.writePtr, sumComponent);
 
-    //Compute outputs
-    if(delayPtr >= 0){
-        double sumComponent;
-        
-        //off-by-one when delayPtr = 0 and delayPtrN1 = -1
-        if(delayPtrN1 >=0){
-            //add input to sum
-            sumComponent = in;
-            //compute delay feedback into sum
-            double delayComponent = delayBuffer[delayPtrN1] * (decay2 / 100.0);
-            delayComponent += delayBuffer[delayPtr];
-            delayComponent *= (decay1 / 100.0);
-            sumComponent += delayComponent;
-
-            //update delay buffer
-            delayBuffer[writePtr] = sumComponent;
-
-            //compute output
-            in = sumComponent * (-decay1 / 100.0);
-        }
-        else{
-            //add input to sum
-            sumComponent = in;
-            //compute delay feedback into sum
-            double delayComponent = delayBuffer[delayPtr];
-            delayComponent *= (decay1 / 100.0);
-            sumComponent += delayComponent;
-
-            //update delay buffer
-            delayBuffer[writePtr] = sumComponent;
-
-            //compute output
-            in = sumComponent * (-decay1 / 100.0);
-        }
-    }
-    else{
-        //fill delay
-        delayBuffer[writePtr] = in;
-        //delay unit has nothing to ouput
-        in *= (-decay1 / 100.0);
-    }
+    //compute output
+    in = sumComponent * (-feedback1);
 
     //Limiting
-    if(in >= 1.0)
-        in = 0.9999;
-    else if(in <= -1.0)
-        in = -0.9999;
+    in = limit(in);
 
-    //Update pointers
-    writePtr++;
-    delayPtr++;
-    delayPtrN1++;
+    //Update pointer
+    if(++ch.writePtr == bufferLength)
+        ch.writePtr = 0;
 
     return in;
 }
@@ -434,11 +538,33 @@ void LPComb::setLPComb(int tDelay, int tDecay1, int tDecay2){ //implicitly defin
         decay1 = 50;
     if(decay2 >= 100 || decay2 < 0)
         decay2 = 50;
-
-    writePtr = 0;
-    delayPtr = (int) (-1) * (fsPerMs * delay );
-    delayPtrN1 = delayPtr - 1; //one sample back
-    bufferLength = 3 + ((delay / (1.0 * MAX_MS_DELAY)) * MAX_BUFFER_LENGTH);
+    feedback1 = decay1 / 100.0;
+    feedback2 = decay2 / 100.0;
 
     initializeDelayBuffer();
+}
+
+void LPComb::setDecays(int tDecay1, int tDecay2){
+    if(tDecay1 < 100 && tDecay1 >= 0)
+        decay1 = tDecay1;
+    if(tDecay2 < 100 && tDecay2 >= 0)
+        decay2 = tDecay2;
+
+    feedback1 = decay1 / 100.0;
+    feedback2 = decay2 / 100.0;
+}
+
+//Same arithmetic as prepare() and initializeDelayBuffer()
+void LPComb::getDelayLine(double tSampleRate, int& lag, int& length) const{
+    int maxLength = static_cast<int>((MAX_MS_DELAY / 1000.0) * tSampleRate);
+
+    length = static_cast<int>(3 + ((delay / (1.0 * MAX_MS_DELAY)) * maxLength));
+    lag = static_cast<int>((tSampleRate / 1000.0) * delay);
+}
+
+double LPComb::getFeedback1() const{
+    return feedback1;
+}
+double LPComb::getFeedback2() const{
+    return feedback2;
 }
\ No newline at end of file
@@ -1,110 +1,165 @@
 #ifndef __FILTERS_H__
 #define __FILTERS_H__
 
-#include "RtAudio.h"
-#include "FileWvOut.h"
+#include "Processor.h"
 
-class Allpass{
+class Allpass : public Processor{
 public:
-    static int MAX_BUFFER_LENGTH; //Static variable for maximum buffer length
     static int MAX_MS_DELAY; //Maximum length of the delay 
 
     ~Allpass(void);
     Allpass(void);
 
-    //initializes the delayBuffer into an array of proper size
+    //allocates the delay buffers at their maximum length for the stream, at the precision set
+    void prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels);
+
+    //sets the delay buffer length for the current delay and clears the buffers
     void initializeDelayBuffer(void);
 
     //destroys the current delay buffer
     void destroyDelayBuffer(void);
 
-    //Computation functions
-    int callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData );
+    //Processes one block, one channel at a time
+    void process(const StkFloat* const* in, StkFloat* const* out, int nFrames);
+
+    //Runs nFrames of channel through the filter. in and out may be the same buffer
+    void processChannel(const StkFloat* in, StkFloat* out, int nFrames, unsigned int channel);
 
-    void tick(void *outputBuffer, void *input,int nBufferFrames);
-    
-    StkFrames& tick(void *input, int nBufferFrames, StkFrames& frames);
-    
-    double computeSample(double& in);
+    double computeSample(double& in, unsigned int channel);
 
     void setAllpass(int tDelay, int tDecay);
 
+    //Changes the decay only, the delay line keeps running. Safe between blocks
+    void setDecay(int tDecay);
+
 private:
+    //Delay line state of a single channel
+    struct Channel{
+        double* delayBuffer; //Delay buffer at FLOAT64, cleared so the first echoes read silence
+        float* delayBuffer32; //The same at FLOAT32, only one of the two is allocated
+        int writePtr; //Cell the current sample is written to
+    };
+
     int delay; //0-5000ms
     int decay; //0%-100%
-    double* delayBuffer; //Delay buffer
+    double feedback; //decay / 100, worked out when decay is set instead of per sample
     int bufferLength; //Buffer length
-    int writePtr; //Write pointer for both buffers
-    int delayPtr; //Pointer to the delay cell
+    int tapAge; //Samples from writing a cell to reading it back as the echo
+    int maxBufferLength; //Buffer length of MAX_MS_DELAY at sampleRate
+    double fsPerMs; //Samples per millisecond at the prepared sample rate
+    Channel* channels; //One delay line per channel
+    unsigned int numChannels; //Number of delay lines in channels
 };
 
-class Comb{
+class Comb : public Processor{
 public:
-    static int MAX_BUFFER_LENGTH; //Static variable for maximum buffer length
     static int MAX_MS_DELAY; //Maximum length of the delay 
     ~Comb(void);
     Comb(void);
 
-    //initializes the delayBuffer into an array of proper size
+    //allocates the delay buffers at their maximum length for the stream, at the precision set
+    void prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels);
+
+    //sets the delay buffer length for the current delay and clears the buffers
     void initializeDelayBuffer(void);
 
     //destroys the current delay buffer
     void destroyDelayBuffer(void);
 
-    //Computation functions
-    int callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData );
+    //Processes one block, one channel at a time
+    void process(const StkFloat* const* in, StkFloat* const* out, int nFrames);
+
+    //Runs nFrames of channel through the filter. in and out may be the same buffer
+    void processChannel(const StkFloat* in, StkFloat* out, int nFrames, unsigned int channel);
 
-    void tick(void *outputBuffer, void *input,int nBufferFrames);
-    
-    StkFrames& tick(void *input, int nBufferFrames, StkFrames& frames);
-    
-    double computeSample(double& in);
+    double computeSample(double& in, unsigned int channel);
 
     void setComb(int tDelay, int tDecay);
 
+    //Changes the decay only, the delay line keeps running. Safe between blocks
+    void setDecay(int tDecay);
+
+    //Delay line that initializeDelayBuffer() would set up at tSampleRate: the first
+    //echo comes after lag samples, the buffer holds length samples. For CombBank
+    void getDelayLine(double tSampleRate, int& lag, int& length) const;
+
+    double getFeedback(void) const;
+
 private:
+    //Delay line state of a single channel
+    struct Channel{
+        double* delayBuffer; //Delay buffer at FLOAT64, cleared so the first echoes read silence
+        float* delayBuffer32; //The same at FLOAT32, only one of the two is allocated
+        int writePtr; //Cell the current sample is written to
+    };
+
     int delay; //0-5000ms
     int decay; //0%-100%
-    double* delayBuffer; //Delay buffer
+    double feedback; //decay / 100, worked out when decay is set instead of per sample
     int bufferLength; //Buffer length
-    int writePtr; //Write pointer for both buffers
-    int delayPtr; //Pointer to the delay cell
+    int tapAge; //Samples from writing a cell to reading it back as the echo
+    int maxBufferLength; //Buffer length of MAX_MS_DELAY at sampleRate
+    double fsPerMs; //Samples per millisecond at the prepared sample rate
+    Channel* channels; //One delay line per channel
+    unsigned int numChannels; //Number of delay lines in channels
 };
 
-class LPComb{
+class LPComb : public Processor{
 public:
-    static int MAX_BUFFER_LENGTH; //Static variable for maximum buffer length
     static int MAX_MS_DELAY; //Maximum length of the delay 
 
     ~LPComb(void);
     LPComb(void);
 
-    //initializes the delayBuffer into an array of proper size
+    //allocates the delay buffers at their maximum length for the stream, at the precision set
+    void prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels);
+
+    //sets the delay buffer length for the current delay and clears the buffers
     void initializeDelayBuffer(void);
 
     //destroys the current delay buffer
     void destroyDelayBuffer(void);
 
-    //Computation functions
-    int callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData );
+    //Processes one block, one channel at a time
+    void process(const StkFloat* const* in, StkFloat* const* out, int nFrames);
+
+    //Runs nFrames of channel through the filter. in and out may be the same buffer
+    void processChannel(const StkFloat* in, StkFloat* out, int nFrames, unsigned int channel);
 
-    void tick(void *outputBuffer, void *input,int nBufferFrames);
-    
-    StkFrames& tick(void *input, int nBufferFrames, StkFrames& frames);
-    
-    double computeSample(double& in);
+    double computeSample(double& in, unsigned int channel);
 
     void setLPComb(int tDelay, int tDecay1, int tDecay2); //implicitly defines delay2
 
+    //Changes the decays only, the delay line keeps running. Safe between blocks
+    void setDecays(int tDecay1, int tDecay2);
+
+    //Delay line that initializeDelayBuffer() would set up at tSampleRate: the first
+    //echo comes after lag samples, the buffer holds length samples. For CombBank
+    void getDelayLine(double tSampleRate, int& lag, int& length) const;
+
+    double getFeedback1(void) const;
+    double getFeedback2(void) const;
+
 private:
+    //Delay line state of a single channel
+    struct Channel{
+        double* delayBuffer; //Delay buffer at FLOAT64, cleared so the first echoes read silence
+        float* delayBuffer32; //The same at FLOAT32, only one of the two is allocated
+        int writePtr; //Cell the current sample is written to
+    };
+
     int delay; //0-5000ms
     int decay1; //0%-100%
     int decay2; //0%-100%
-    double* delayBuffer; //Delay buffer
+    double feedback1; //decay1 / 100, worked out when decay1 is set instead of per sample
+    double feedback2; //decay2 / 100, worked out when decay2 is set instead of per sample
     int bufferLength; //Buffer length
-    int writePtr; //Write pointer for both buffers
-    int delayPtr; //Pointer to the delay cell
-    int delayPtrN1; //Pointer to the feedback delay cell - 1
+    int tapAge; //Samples from writing a cell to reading it back as the echo
+    int tapAgeN1; //Same for the feedback tap one sample older
+    int maxBufferLength; //Buffer length of MAX_MS_DELAY at sampleRate
+    double fsPerMs; //Samples per millisecond at the prepared sample rate
+    Channel* channels; //One delay line per channel
+    unsigned int numChannels; //Number of delay lines in channels
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,164 @@
+/*
+InputPrefetcher.cpp
+
+Definitions of the InputPrefetcher class. A reader thread
+decodes the input file ahead of the audio callback into a
+lock-free ring of non-interleaved blocks.
+*/
+
+#include "InputPrefetcher.h"
+
+InputPrefetcher::~InputPrefetcher(){
+    close();
+}
+
+InputPrefetcher::InputPrefetcher(){
+    file = 0;
+    mappedFile = 0;
+    blockFrames = 0;
+    numChannels = 0;
+    numBlocks = 0;
+    blocks = 0;
+    channels = 0;
+    writeIndex = 0;
+    readIndex = 0;
+    endOfFile = 0;
+    stopping = 0;
+    underruns = 0;
+}
+
+bool InputPrefetcher::open(FileWvIn* tFile, unsigned int tBlockFrames, unsigned int tNumChannels, unsigned long lookaheadFrames){
+    close();
+
+    file = tFile;
+
+    return start(tBlockFrames, tNumChannels, lookaheadFrames);
+}
+
+bool InputPrefetcher::open(MappedWavFile* tFile, unsigned int tBlockFrames, unsigned int tNumChannels, unsigned long lookaheadFrames){
+    close();
+
+    mappedFile = tFile;
+
+    return start(tBlockFrames, tNumChannels, lookaheadFrames);
+}
+
+//Allocates the ring, fills it and starts the reader thread
+bool InputPrefetcher::start(unsigned int tBlockFrames, unsigned int tNumChannels, unsigned long lookaheadFrames){
+    blockFrames = tBlockFrames;
+    numChannels = tNumChannels;
+
+    //At least two blocks, so the reader can fill one while the callback reads the other
+    numBlocks = static_cast<unsigned int>((lookaheadFrames + blockFrames - 1) / blockFrames);
+    if(numBlocks < 2)
+        numBlocks = 2;
+
+    blocks = new StkFrames[numBlocks];
+    channels = new StkFloat*[numBlocks * numChannels];
+
+    for(unsigned int b = 0; b < numBlocks; b++){
+        blocks[b].resize(blockFrames, numChannels);
+        blocks[b].setInterleaved(false); //one contiguous block per channel
+
+        for(unsigned int c = 0; c < numChannels; c++)
+            channels[b * numChannels + c] = &blocks[b][c * blockFrames];
+    }
+
+    writeIndex = 0;
+    readIndex = 0;
+    endOfFile = 0;
+    stopping = 0;
+    underruns = 0;
+
+    //Start with a full ring so playback does not begin on a cold cache
+    if(!fill())
+        return true;
+
+    return reader.start(&InputPrefetcher::readerThread, (void *)this);
+}
+
+void InputPrefetcher::close(){
+    Atomic::store(stopping, 1);
+    reader.wait();
+
+    delete[ ] blocks;
+    blocks = 0;
+    delete[ ] channels;
+    channels = 0;
+    numBlocks = 0;
+    file = 0;
+    mappedFile = 0;
+}
+
+//Audio thread only
+const StkFloat* const* InputPrefetcher::acquire(){
+    unsigned int read = readIndex;
+
+    if(read == Atomic::load(writeIndex)){
+        //An empty ring at the end of the file is not an underrun
+        if(!Atomic::load(endOfFile))
+            underruns++;
+
+        return 0;
+    }
+
+    return channels + (read % numBlocks) * numChannels;
+}
+
+//Audio thread only
+void InputPrefetcher::release(){
+    Atomic::store(readIndex, readIndex + 1);
+}
+
+bool InputPrefetcher::isDrained() const{
+    return Atomic::load(endOfFile) && Atomic::load(readIndex) == Atomic::load(writeIndex);
+}
+
+bool InputPrefetcher::isReady() const{
+    return Atomic::load(endOfFile) || Atomic::load(readIndex) != Atomic::load(writeIndex);
+}
+
+unsigned long InputPrefetcher::getUnderruns() const{
+    return underruns;
+}
+
+unsigned int InputPrefetcher::getNumBlocks() const{
+    return numBlocks;
+}
+
+//Decodes blocks until the ring is full or the file ended
+bool InputPrefetcher::fill(){
+    unsigned int write = writeIndex;
+
+    while(write - Atomic::load(readIndex) < numBlocks){
+        if(mappedFile != 0 ? mappedFile->isFinished() : file->isFinished()){
+            Atomic::store(endOfFile, 1);
+            return false;
+        }
+
+        unsigned int block = write % numBlocks;
+        if(mappedFile != 0)
+            mappedFile->read(channels + block * numChannels, blockFrames);
+        else
+            file->tickFrame(blocks[block]);
+
+        //Publish the block only after it is decoded
+        Atomic::store(writeIndex, ++write);
+    }
+
+    return true;
+}
+
+//Reader thread body. Tops the ring up and naps while it is full
+THREAD_RETURN THREAD_TYPE InputPrefetcher::readerThread(void* ptr){
+    InputPrefetcher* prefetcher = (InputPrefetcher *) ptr;
+
+    while(!Atomic::load(prefetcher->stopping)){
+        if(!prefetcher->fill())
+            break;
+
+        Thread::sleep(1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#ifndef __INPUTPREFETCHER_H__
+#define __INPUTPREFETCHER_H__
+
+#include "FileWvIn.h"
+#include "MappedWavFile.h"
+#include "Thread.h"
+#include "Atomic.h"
+
+/*  Reads an input file ahead of the audio callback on a background
+    thread. FileWvIn reads long files from disk in chunks, and those
+    fseek/fread calls must never run inside the callback.
+
+    The reader thread decodes non-interleaved blocks into a lock-free
+    single-producer/single-consumer ring. The callback only takes
+    blocks out of memory: acquire() the oldest block, process it,
+    release() it. If the reader falls behind the callback gets no
+    block, plays silence and the underrun is counted.
+*/
+class InputPrefetcher{
+public:
+    ~InputPrefetcher(void);
+    InputPrefetcher(void);
+
+    //Sizes the ring for lookaheadFrames of blocks of blockFrames, fills it
+    //from file and starts the reader thread. The file must stay open until close()
+    bool open(FileWvIn* tFile, unsigned int tBlockFrames, unsigned int tNumChannels, unsigned long lookaheadFrames);
+
+    //Same, reading from a memory-mapped file. The reader thread takes the page faults
+    bool open(MappedWavFile* tFile, unsigned int tBlockFrames, unsigned int tNumChannels, unsigned long lookaheadFrames);
+
+    //Stops the reader thread and frees the ring
+    void close(void);
+
+    //Audio thread only. Channel pointers of the oldest decoded block,
+    //or 0 if none is ready. Call release() when done with it
+    const StkFloat* const* acquire(void);
+
+    //Audio thread only. Hands the acquired block back to the reader
+    void release(void);
+
+    //True once the whole file went through the ring
+    bool isDrained(void) const;
+
+    //True if acquire() has a block to hand out or the file has ended.
+    //Lets a driver that is not paced by a device wait for the reader
+    bool isReady(void) const;
+
+    //Times the callback asked for a block and none was ready
+    unsigned long getUnderruns(void) const;
+
+    //Blocks the ring holds
+    unsigned int getNumBlocks(void) const;
+
+private:
+    //Reader thread body
+    static THREAD_RETURN THREAD_TYPE readerThread(void* ptr);
+
+    //Allocates the ring, fills it and starts the reader thread
+    bool start(unsigned int tBlockFrames, unsigned int tNumChannels, unsigned long lookaheadFrames);
+
+    //Decodes blocks until the ring is full or the file ended. Returns false once the file ended
+    bool fill(void);
+
+    FileWvIn* file; //File being read, or 0
+    MappedWavFile* mappedFile; //Mapped file being read, or 0
+    unsigned int blockFrames; //Frames in a block
+    unsigned int numChannels; //Channels in a block
+    unsigned int numBlocks; //Blocks in the ring
+    StkFrames* blocks; //Ring of non-interleaved blocks
+    StkFloat** channels; //Start of every channel of every block
+
+    volatile unsigned int writeIndex; //Blocks decoded so far, only written by the reader
+    volatile unsigned int readIndex; //Blocks released so far, only written by the audio thread
+    volatile unsigned int endOfFile; //Set by the reader after it published the last block
+    volatile unsigned int stopping; //Set by close() to stop the reader
+    volatile unsigned long underruns; //Only written by the audio thread
+
+    Thread reader; //Background reader thread
+};
+
+#endif
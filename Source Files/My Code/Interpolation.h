@@ -20,6 +20,10 @@ Use these functions...
 
 sincBand(...)
 linInterp(...)
+
+or, for real-time bandlimited interpolation, hold a SincInterpolator
+object. It builds a windowed-sinc polyphase table once and then only
+does table lookups and multiply-adds per sample.
 */
 
 #ifndef __INTERPOLATION_H__
@@ -40,7 +44,8 @@ include the following lines of code when including this
 header file:
 
 using Interpolation::sincBand;
-using Interpolation::linInterp; */
+using Interpolation::linInterp;
+using Interpolation::SincInterpolator; */
 namespace Interpolation{
 
     //Declare M_PI for Weird VS2008 Error
@@ -54,12 +59,12 @@ namespace Interpolation{
     const int INTERP_MAX = 256;
 
     //minimum helper function
-    double minimum(double a, double b){
+    inline double minimum(double a, double b){
 	    return a<b ? a : b;
     }
 
     //sinc function
-    double sinc(double x){
+    inline double sinc(double x){
 	    if (x == 0.0)
 		    return 1;
 	    else
@@ -77,7 +82,7 @@ namespace Interpolation{
         at which the newFreq would have an integer sample.
         i.e. sampleDesired = 31.5; stdFreq = 44100; Then newFreq = 96000.
     */
-    double sincBand(double* buffer, int bufferLength, double sampleDesired, double stdFreq, double newFreq){
+    inline double sincBand(double* buffer, int bufferLength, double sampleDesired, double stdFreq, double newFreq){
         double sum = 0;
         int sampleStart = static_cast<int>(sampleDesired); //left sample
 
@@ -112,12 +117,150 @@ namespace Interpolation{
         return sum;
     }
 
+    /*********Polyphase Bandlimited Interpolation*******/
+
+    //Lowest cutoff (fraction of Nyquist) in the polyphase table.
+    //Cutoffs below half of Nyquist would need much longer filters
+    const double MIN_CUTOFF = 0.5;
+
+    /*  Windowed-sinc interpolator with a precomputed polyphase table.
+        sincBand() rebuilds a 512 point filter for every sample it computes,
+        which is far too slow for the callback. This class builds the filter
+        once per sample rate for a fixed set of ratio classes (cutoffs) and
+        fractional phases. interpolate() then picks the table for the ratio,
+        reads the two phases around the fractional position and blends them.
+
+        Call initialize() once before streaming (not from the callback).
+    */
+    class SincInterpolator{
+    public:
+        static const int ZERO_CROSSINGS = 8; //taps on each side of the desired sample
+        static const int TAPS = 2 * ZERO_CROSSINGS; //taps per phase
+        static const int PHASES = 128; //fractional positions between two samples
+        static const int RATIO_CLASSES = 8; //number of precomputed cutoffs
+
+        ~SincInterpolator(void){
+            delete[ ] table;
+            table = 0;
+        }
+
+        SincInterpolator(void){
+            table = 0;
+            sampleRate = 0.0;
+        }
+
+        //Builds the table. Does nothing if it was already built for this rate
+        void initialize(double fs){
+            if(table != 0 && fs == sampleRate)
+                return;
+
+            delete[ ] table;
+            sampleRate = fs;
+
+            //PHASES + 1 rows so that the phase after the last one can be read without wrapping
+            table = new double[RATIO_CLASSES * (PHASES + 1) * TAPS];
+
+            for(int c = 0; c < RATIO_CLASSES; c++){
+                double cutoff = MIN_CUTOFF + (1.0 - MIN_CUTOFF) * c / (RATIO_CLASSES - 1);
+
+                for(int p = 0; p <= PHASES; p++){
+                    double* row = table + (c * (PHASES + 1) + p) * TAPS;
+                    double fraction = static_cast<double>(p) / PHASES;
+                    double sum = 0;
+
+                    for(int k = 0; k < TAPS; k++){
+                        //distance from the desired sample to tap k
+                        double x = (k + 1 - ZERO_CROSSINGS) - fraction;
+
+                        row[k] = cutoff * sinc(cutoff * x) * window(x);
+                        sum += row[k];
+                    }
+
+                    //normalize to unity gain at DC so every phase has the same level
+                    for(int k = 0; k < TAPS; k++)
+                        row[k] /= sum;
+                }
+            }
+        }
+
+        /*  buffer: ring buffer holding the samples to interpolate
+            bufferLength: length of the ring
+            sampleDesired: "imaginary" index of the wanted sample, i.e. 31.5
+            ratio: newFreq / stdFreq, the resampling ratio at this sample
+        */
+        double interpolate(const double* buffer, int bufferLength, double sampleDesired, double ratio) const{
+            int sampleStart = static_cast<int>(sampleDesired); //left sample
+            double position = (sampleDesired - sampleStart) * PHASES;
+            int phase = static_cast<int>(position);
+            double phaseFraction = position - phase;
+
+            const double* row0 = table + (ratioClass(ratio) * (PHASES + 1) + phase) * TAPS;
+            const double* row1 = row0 + TAPS;
+
+            //first sample under the filter, wrapped into the ring
+            int first = sampleStart + 1 - ZERO_CROSSINGS;
+            if(first < 0)
+                first += bufferLength;
+            else if(first >= bufferLength)
+                first -= bufferLength;
+
+            double sum0 = 0, sum1 = 0;
+
+            //the filter fits without wrapping around the end of the ring
+            if(first + TAPS <= bufferLength){
+                const double* samples = buffer + first;
+                for(int k = 0; k < TAPS; k++){
+                    sum0 += samples[k] * row0[k];
+                    sum1 += samples[k] * row1[k];
+                }
+            }
+            else{
+                for(int k = 0; k < TAPS; k++){
+                    int i = first + k;
+                    if(i >= bufferLength)
+                        i -= bufferLength;
+                    sum0 += buffer[i] * row0[k];
+                    sum1 += buffer[i] * row1[k];
+                }
+            }
+
+            //blend the two phases around the fractional position
+            return sum0 + (sum1 - sum0) * phaseFraction;
+        }
+
+    private:
+        double* table; //RATIO_CLASSES x (PHASES + 1) x TAPS coefficients
+        double sampleRate; //rate the table was built for
+
+        //Blackman window over [-ZERO_CROSSINGS, ZERO_CROSSINGS]
+        static double window(double x){
+            if(x <= -ZERO_CROSSINGS || x >= ZERO_CROSSINGS)
+                return 0.0;
+
+            double t = (x + ZERO_CROSSINGS) / (2.0 * ZERO_CROSSINGS);
+            return 0.42 - 0.5 * cos(2 * M_PI * t) + 0.08 * cos(4 * M_PI * t);
+        }
+
+        //Maps a resampling ratio to the table with the nearest cutoff
+        static int ratioClass(double ratio){
+            double cutoff = minimum(1.0, ratio);
+            if(cutoff <= MIN_CUTOFF)
+                return 0;
+
+            return static_cast<int>((cutoff - MIN_CUTOFF) / (1.0 - MIN_CUTOFF) * (RATIO_CLASSES - 1) + 0.5);
+        }
+
+        //Not copyable, the table belongs to one interpolator
+        SincInterpolator(const SincInterpolator&);
+        SincInterpolator& operator=(const SincInterpolator&);
+    };
+
     /*********Linear Interpolation**************/
 
     //Calculates linear interopolation given the smaller sample, the "fraction" away
     //from the smaller sample to the next sample that the interpolation is occuring,
     //and the "slope" or difference between the left and right samples
-    double linInterp(double fraction, double slope, double leftSample){
+    inline double linInterp(double fraction, double slope, double leftSample){
         return slope*fraction + leftSample;
     }
 
@@ -0,0 +1,363 @@
+/*
+MappedWavFile.cpp
+
+Definitions of the MappedWavFile class. Memory-mapped
+.wav input that converts samples straight from the
+mapping into non-interleaved blocks.
+*/
+
+#include "MappedWavFile.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__OS_WINDOWS__)
+  #include <windows.h>
+#else
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+//static variables
+unsigned long MappedWavFile::NORMALIZE_THRESHOLD = 1000000; //FileWvIn's default chunkThreshold
+
+//Little-endian readers for the header and for 24-bit samples
+static unsigned int readLE16(const unsigned char* p){
+    return p[0] | (p[1] << 8);
+}
+static unsigned int readLE32(const unsigned char* p){
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+MappedWavFile::~MappedWavFile(){
+    close();
+}
+
+MappedWavFile::MappedWavFile(){
+    mapping = 0;
+    mappingSize = 0;
+    data = 0;
+    frames = 0;
+    channels = 0;
+    bytesPerSample = 0;
+    fileRate = 0.0;
+    type = SINT16;
+    formatGain = 1.0;
+    peakGain = 1.0;
+    position = 0;
+
+#if defined(__OS_WINDOWS__)
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = 0;
+#else
+    fileDescriptor = -1;
+#endif
+}
+
+bool MappedWavFile::open(const std::string& fileName){
+    close();
+
+#if defined(__OS_WINDOWS__)
+    fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx((HANDLE)fileHandle, &size) || size.QuadPart == 0){
+        unmap();
+        return false;
+    }
+    mappingSize = (size_t)size.QuadPart;
+
+    mappingHandle = CreateFileMappingA((HANDLE)fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mappingHandle == 0){
+        unmap();
+        return false;
+    }
+
+    mapping = (unsigned char *) MapViewOfFile((HANDLE)mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if(mapping == 0){
+        unmap();
+        return false;
+    }
+#else
+    fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+    if(fileDescriptor < 0)
+        return false;
+
+    struct stat info;
+    if(fstat(fileDescriptor, &info) != 0 || info.st_size == 0){
+        unmap();
+        return false;
+    }
+    mappingSize = (size_t)info.st_size;
+
+    void* address = mmap(0, mappingSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    if(address == MAP_FAILED){
+        unmap();
+        return false;
+    }
+    mapping = (unsigned char *) address;
+
+    //The effects read front to back, let the kernel read ahead and drop pages behind
+    madvise(address, mappingSize, MADV_SEQUENTIAL);
+#endif
+
+    if(!parseHeader()){
+        unmap();
+        return false;
+    }
+
+    //Scale like FileWvIn: short files are normalized to their peak, long ones
+    //(which FileWvIn reads in chunks) by their sample format only
+    peakGain = 1.0;
+    if(frames <= NORMALIZE_THRESHOLD){
+        double peak = 0.0;
+        size_t nSamples = (size_t)frames * channels;
+
+        for(size_t i = 0; i < nSamples; i++){
+            double value = fabs(sample(i) * formatGain);
+            if(value > peak)
+                peak = value;
+        }
+
+        if(peak > 0.0)
+            peakGain = 1.0 / peak;
+    }
+
+    position = 0;
+
+    return true;
+}
+
+void MappedWavFile::close(){
+    unmap();
+
+    data = 0;
+    frames = 0;
+    channels = 0;
+    position = 0;
+}
+
+bool MappedWavFile::isOpen() const{
+    return mapping != 0;
+}
+
+bool MappedWavFile::isFinished() const{
+    return position > frames;
+}
+
+unsigned long MappedWavFile::getFrames() const{
+    return frames;
+}
+unsigned int MappedWavFile::getChannels() const{
+    return channels;
+}
+double MappedWavFile::getFileRate() const{
+    return fileRate;
+}
+MappedWavFile::SampleType MappedWavFile::getSampleType() const{
+    return type;
+}
+
+const unsigned char* MappedWavFile::getData() const{
+    return data;
+}
+const short* MappedWavFile::getSint16() const{
+    return (type == SINT16) ? (const short *) data : 0;
+}
+const int* MappedWavFile::getSint32() const{
+    return (type == SINT32) ? (const int *) data : 0;
+}
+const float* MappedWavFile::getFloat32() const{
+    return (type == FLOAT32) ? (const float *) data : 0;
+}
+const double* MappedWavFile::getFloat64() const{
+    return (type == FLOAT64) ? (const double *) data : 0;
+}
+
+//Converts the next nFrames straight from the mapping into out
+unsigned long MappedWavFile::read(StkFloat* const* out, unsigned long nFrames){
+    unsigned long available = 0;
+    if(position < frames)
+        available = (frames - position < nFrames) ? frames - position : nFrames;
+
+    for(unsigned int c = 0; c < channels; c++){
+        StkFloat* output = out[c];
+        size_t i = (size_t)position * channels + c;
+
+        for(unsigned long f = 0; f < available; f++, i += channels)
+            output[f] = (sample(i) * formatGain) * peakGain;
+
+        for(unsigned long f = available; f < nFrames; f++)
+            output[f] = 0.0;
+    }
+
+    //Like FileWvIn, the file only counts as finished once a frame past its end was asked for
+    if(available < nFrames)
+        position = frames + 1;
+    else
+        position += nFrames;
+
+    return available;
+}
+
+//Walks the RIFF chunks for fmt and data
+bool MappedWavFile::parseHeader(){
+    if(mappingSize < 12 || readLE32(mapping) != 0x46464952 || readLE32(mapping + 8) != 0x45564157) //"RIFF", "WAVE"
+        return false;
+
+    unsigned int formatTag = 0;
+    unsigned int bits = 0;
+    bool haveFormat = false;
+    size_t offset = 12;
+
+    while(offset + 8 <= mappingSize){
+        unsigned int id = readLE32(mapping + offset);
+        size_t size = readLE32(mapping + offset + 4);
+        const unsigned char* chunk = mapping + offset + 8;
+
+        //"fmt "
+        if(id == 0x20746d66){
+            if(size < 16 || offset + 8 + size > mappingSize)
+                return false;
+
+            formatTag = readLE16(chunk);
+            channels = readLE16(chunk + 2);
+            fileRate = readLE32(chunk + 4);
+            bits = readLE16(chunk + 14);
+
+            //WAVE_FORMAT_EXTENSIBLE keeps the real tag at the head of the sub-format GUID
+            if(formatTag == 0xFFFE && size >= 26)
+                formatTag = readLE16(chunk + 24);
+
+            haveFormat = true;
+        }
+        //"data"
+        else if(id == 0x61746164){
+            if(!haveFormat || channels == 0)
+                return false;
+
+            //A truncated file keeps the frames it has
+            if(offset + 8 + size > mappingSize)
+                size = mappingSize - offset - 8;
+
+            data = chunk;
+            break;
+        }
+
+        //Chunks are padded to an even length
+        offset += 8 + size + (size & 1);
+    }
+
+    if(data == 0)
+        return false;
+
+    //1 is PCM, 3 is IEEE float
+    if(formatTag == 1 && bits == 16){
+        type = SINT16;
+        formatGain = 1.0 / 32768.0;
+    }
+    else if(formatTag == 1 && bits == 24){
+        type = SINT24;
+        formatGain = 1.0 / 8388608.0;
+    }
+    else if(formatTag == 1 && bits == 32){
+        type = SINT32;
+        formatGain = 1.0 / 2147483648.0;
+    }
+    else if(formatTag == 3 && bits == 32){
+        type = FLOAT32;
+        formatGain = 1.0;
+    }
+    else if(formatTag == 3 && bits == 64){
+        type = FLOAT64;
+        formatGain = 1.0;
+    }
+    else
+        return false;
+
+    bytesPerSample = bits / 8;
+    frames = (unsigned long)((mappingSize - (data - mapping)) / (bytesPerSample * channels));
+    size_t dataSize = readLE32(data - 4);
+    if(dataSize / (bytesPerSample * channels) < frames)
+        frames = (unsigned long)(dataSize / (bytesPerSample * channels));
+
+    return true;
+}
+
+//Sample i of the data, scaled by the format only
+double MappedWavFile::sample(size_t i) const{
+    const unsigned char* p = data + i * bytesPerSample;
+
+#if defined(__LITTLE_ENDIAN__)
+    switch(type){
+        case SINT16:
+            return ((const short *) data)[i];
+        case SINT32:
+            return ((const int *) data)[i];
+        case FLOAT32:
+            return ((const float *) data)[i];
+        case FLOAT64:
+            return ((const double *) data)[i];
+        default:
+            break;
+    }
+#else
+    switch(type){
+        case SINT16:
+            return (short) readLE16(p);
+        case SINT32:
+            return (int) readLE32(p);
+        case FLOAT32:{
+            unsigned int bits = readLE32(p);
+            float value;
+            memcpy(&value, &bits, 4);
+            return value;
+        }
+        case FLOAT64:{
+            unsigned char bytes[8];
+            for(int b = 0; b < 8; b++)
+                bytes[b] = p[7 - b];
+            double value;
+            memcpy(&value, bytes, 8);
+            return value;
+        }
+        default:
+            break;
+    }
+#endif
+
+    //24-bit, sign extended from the top byte
+    int value = p[0] | (p[1] << 8) | (p[2] << 16);
+    if(value & 0x800000)
+        value -= 0x1000000;
+
+    return value;
+}
+
+void MappedWavFile::unmap(){
+#if defined(__OS_WINDOWS__)
+    if(mapping != 0)
+        UnmapViewOfFile(mapping);
+    if(mappingHandle != 0)
+        CloseHandle((HANDLE)mappingHandle);
+    if(fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle((HANDLE)fileHandle);
+
+    mappingHandle = 0;
+    fileHandle = INVALID_HANDLE_VALUE;
+#else
+    if(mapping != 0)
+        munmap(mapping, mappingSize);
+    if(fileDescriptor >= 0)
+        ::close(fileDescriptor);
+
+    fileDescriptor = -1;
+#endif
+
+    mapping = 0;
+    mappingSize = 0;
+}
@@ -0,0 +1,95 @@
+#ifndef __MAPPEDWAVFILE_H__
+#define __MAPPEDWAVFILE_H__
+
+#include "Stk.h"
+#include <string>
+
+/*  Memory-mapped .wav input. The RIFF header is checked once in
+    open(), after that the sample data is read straight out of the
+    mapping: no fseek/fread per chunk and no temporary buffer, the
+    samples are converted directly into the caller's
+    non-interleaved block.
+
+    The data is scaled the way FileWvIn scales it, so a file reads
+    the same through either path: files of up to
+    NORMALIZE_THRESHOLD frames are normalized to a peak of 1.0,
+    longer files are only scaled by their sample format.
+
+    The typed views (getSint16() ...) are zero-copy and point into
+    the mapping. They hold little-endian data, so they are only
+    native values on little-endian hosts; read() converts on both.
+*/
+class MappedWavFile{
+public:
+    //Sample formats that can be mapped
+    enum SampleType {SINT16, SINT24, SINT32, FLOAT32, FLOAT64};
+
+    static unsigned long NORMALIZE_THRESHOLD; //Longest file, in frames, normalized to its peak (FileWvIn's chunkThreshold)
+
+    ~MappedWavFile(void);
+    MappedWavFile(void);
+
+    //Maps fileName and checks its header. Returns false if the file can't
+    //be mapped or is not a .wav of a supported sample type
+    bool open(const std::string& fileName);
+
+    void close(void);
+
+    bool isOpen(void) const;
+
+    //True once read() went past the last frame
+    bool isFinished(void) const;
+
+    unsigned long getFrames(void) const;
+    unsigned int getChannels(void) const;
+    double getFileRate(void) const;
+    SampleType getSampleType(void) const;
+
+    //Zero-copy views of the interleaved sample data. Each returns 0
+    //unless the file holds that type. 24-bit samples have no native
+    //type, getData() gives their 3-byte little-endian frames
+    const unsigned char* getData(void) const;
+    const short* getSint16(void) const;
+    const int* getSint32(void) const;
+    const float* getFloat32(void) const;
+    const double* getFloat64(void) const;
+
+    //Converts the next nFrames into out[c][0 .. nFrames-1] and moves on.
+    //Frames past the end of the file are zero. Returns the frames that came from the file
+    unsigned long read(StkFloat* const* out, unsigned long nFrames);
+
+private:
+    //Finds and checks the fmt and data chunks. Returns false for anything unsupported
+    bool parseHeader(void);
+
+    //Sample i of the data, scaled by the format only
+    double sample(size_t i) const;
+
+    //Unmaps and closes the file
+    void unmap(void);
+
+    unsigned char* mapping; //Start of the mapped file
+    size_t mappingSize; //Bytes mapped
+    const unsigned char* data; //Start of the sample data inside the mapping
+    unsigned long frames; //Frames in the data chunk
+    unsigned int channels; //Channels per frame
+    unsigned int bytesPerSample; //Bytes of one sample of one channel
+    double fileRate; //Sample rate of the file
+    SampleType type; //Sample format of the data
+    double formatGain; //Scales the sample format to -1.0 .. 1.0
+    double peakGain; //Normalizes the peak to 1.0, 1.0 for long files
+    unsigned long position; //Next frame read() converts
+
+#if defined(__OS_WINDOWS__)
+    void* fileHandle; //Win32 HANDLE of the open file
+    void* mappingHandle; //Win32 HANDLE of the file mapping
+#else
+    int fileDescriptor; //Descriptor of the open file
+#endif
+
+    //Not copyable, a mapping belongs to one file object
+    MappedWavFile(const MappedWavFile&);
+    MappedWavFile& operator=(const MappedWavFile&);
+};
+
+#endif
@@ -0,0 +1,58 @@
+/*
+MirroredRings.cpp
+
+Definitions of the MirroredRings class, the doubled
+struct-of-arrays delay lines of CombBank and FDNReverb.
+*/
+
+#include "MirroredRings.h"
+
+MirroredRings::~MirroredRings(){
+    destroy();
+}
+
+MirroredRings::MirroredRings(){
+    channels = 0;
+    numChannels = 0;
+    rows = 1;
+    lanes = 0;
+}
+
+//Frees the old rings, then sizes and clears one ring per channel
+void MirroredRings::allocate(unsigned int nChannels, int tRows, int tLanes, Processor::Precision precision){
+    destroy();
+
+    rows = tRows;
+    lanes = tLanes;
+    numChannels = nChannels;
+    channels = new Channel[numChannels];
+
+    for(unsigned int c = 0; c < numChannels; c++){
+        channels[c].ring = 0;
+        channels[c].ring32 = 0;
+
+        if(precision == Processor::FLOAT32){
+            channels[c].ring32 = new float[2 * rows * lanes];
+            for(int i = 0; i < 2 * rows * lanes; i++)
+                channels[c].ring32[i] = 0.0f;
+        }
+        else{
+            channels[c].ring = new double[2 * rows * lanes];
+            for(int i = 0; i < 2 * rows * lanes; i++)
+                channels[c].ring[i] = 0.0;
+        }
+
+        channels[c].writeRow = 0;
+    }
+}
+
+void MirroredRings::destroy(){
+    for(unsigned int c = 0; c < numChannels; c++){
+        delete[ ] channels[c].ring;
+        delete[ ] channels[c].ring32;
+    }
+
+    delete[ ] channels;
+    channels = 0;
+    numChannels = 0;
+}
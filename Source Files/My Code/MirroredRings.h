@@ -0,0 +1,50 @@
+#ifndef __MIRROREDRINGS_H__
+#define __MIRROREDRINGS_H__
+
+#include "Processor.h"
+
+/*  Struct-of-arrays delay lines for filters that run in lockstep,
+    like CombBank and FDNReverb. Each channel has one ring of rows,
+    and a row holds one sample of every lane. All lanes write the
+    same row, so there is one write index per channel, and each
+    lane reads its own row at its own age.
+
+    The ring is stored twice, back to back, so a tap up to rows
+    rows old reads straight from row writeRow + rows - age and
+    never wraps. A write goes to both copies, getMirror() apart.
+*/
+class MirroredRings{
+public:
+    //Delay line state of a single channel
+    struct Channel{
+        double* ring; //2 * rows rows of lanes samples at FLOAT64, the second half mirrors the first
+        float* ring32; //The same at FLOAT32, only one of the two is allocated
+        int writeRow; //Row the current sample is written to
+    };
+
+    ~MirroredRings(void);
+    MirroredRings(void);
+
+    //Frees the old rings, then sizes and clears one ring per channel
+    void allocate(unsigned int nChannels, int tRows, int tLanes, Processor::Precision precision);
+
+    //Frees every ring
+    void destroy(void);
+
+    Channel& operator[](unsigned int channel) { return channels[channel]; }
+
+    //Distance from a row to its copy in the second half
+    int getMirror(void) const { return rows * lanes; }
+
+private:
+    Channel* channels; //One ring per channel
+    unsigned int numChannels; //Number of rings in channels
+    int rows; //Rows in one copy of a ring
+    int lanes; //Samples in a row
+
+    //Not copyable, the rings belong to one filter
+    MirroredRings(const MirroredRings&);
+    MirroredRings& operator=(const MirroredRings&);
+};
+
+#endif
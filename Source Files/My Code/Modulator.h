@@ -3,36 +3,61 @@
 
 #include <math.h>
 #include <cmath>
-
+#include <iostream>
+
+/*  Low frequency oscillator of the choruses. Every shape is one
+    cycle in a wavetable of TABLE_LENGTH points, built once and
+    shared by every modulator. A modulator only keeps its phase,
+    a position in the table, and steps it by a fractional increment
+    each sample, so the frequency is not rounded to a whole number
+    of samples per cycle and can change smoothly while streaming.
+
+    The coefficients are 1 + depth * wave, around 1, and scale a
+    delay length.
+*/
 class Modulator{
 public:
-    static int STD_BUFFER_LENGTH; //Maximum length of the coefficient buffer
     static double MIN_HZ; //Minimum frequency of the modulator
     static double MAX_HZ; //Maximum frequency of the modulator
     static int MAX_MODS; //Maximum number of supported simultaneous Modulator objects for processing
-    
+    static const int TABLE_LENGTH = 2048; //Points in one cycle of a shared wavetable
+
     ~Modulator(void);
 
     Modulator(void);
 
-    void setModulator(void);
+    //Asks for the shape, frequency and depth. input gives the answers,
+    //prompts shows the questions
+    void setModulator(std::istream& input = std::cin, std::ostream& prompts = std::cout);
 
-    //Creates a buffer ring containing coefficient values calculated for
-    //the given Wave shape over 1 period of the shape
-    void initializeCoefficients(void);
+    //Sets the phase increment for the stream's sample rate and restarts the cycle
+    void prepare(double tSampleRate);
 
-    void destroyCoefficients(void);
+    //Changes the frequency without restarting the cycle, safe between blocks.
+    //For tempo sync pass beats per minute / 60 / beats per cycle
+    void setFrequency(double tFreq);
+
+    double getFrequency(void) const;
 
     double nextCoefficient(void);
 
+    //The next nFrames coefficients, written stride apart
+    void nextCoefficients(double* coefficients, int nFrames, int stride = 1);
+
 private:
-    enum modShape {sine, saw, triangular, square} shape; //Shape of the modulator wave
+    enum modShape {sine, saw, triangular, square, NUM_SHAPES} shape; //Shape of the modulator wave
+
+    //Builds the shared wavetables the first time a modulator is prepared
+    static void initializeTables(void);
+
+    static double* tables[NUM_SHAPES]; //One cycle of each shape from -1 to 1, plus a guard point
+
     double freq; //Frequency of the modulator wave
     double depth; //Amplitude of the modulator wave
-    int coefficientIndex; //Index of the currently considered coefficient
-    double* coefficient; //Pointer to head of buffer of coefficient that is modulated
-    int bufferLength; //Actual buffer length
+    double phase; //Position in the wavetable, 0 to TABLE_LENGTH
+    double increment; //Table points per sample, TABLE_LENGTH * freq / sampleRate
+    double sampleRate; //Sample rate the increment is set for
 };
 
 
-#endif
\ No newline at end of file
+#endif
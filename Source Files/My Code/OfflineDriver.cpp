@@ -0,0 +1,157 @@
+/*
+OfflineDriver.cpp
+
+Definitions of the OfflineDriver class. Drives an RtAudio
+callback from a thread on a simulated clock, with optional
+jitter, into a .wav file or memory.
+*/
+
+#include "OfflineDriver.h"
+
+OfflineDriver::~OfflineDriver(){
+    closeStream();
+}
+
+OfflineDriver::OfflineDriver(){
+    numChannels = 0;
+    sampleRate = 44100.0;
+    bufferFrames = 0;
+    callback = 0;
+    userData = 0;
+    ready = 0;
+    speed = 1.0;
+    jitter = 0.0;
+    seed = 1;
+    fileSink = 0;
+    lateCallbacks = 0;
+    stopping = 0;
+}
+
+void OfflineDriver::openStream(unsigned int tNumChannels, double tSampleRate, unsigned int tBufferFrames,
+    RtAudioCallback tCallback, void* tUserData){
+    closeStream();
+
+    numChannels = tNumChannels;
+    sampleRate = tSampleRate;
+    bufferFrames = tBufferFrames;
+    callback = tCallback;
+    userData = tUserData;
+
+    //The callback gets one contiguous block per channel, like RTAUDIO_NONINTERLEAVED
+    buffer.resize(bufferFrames, numChannels);
+    buffer.setInterleaved(false);
+
+    memorySink.assign(numChannels, std::vector<StkFloat>());
+    lateCallbacks = 0;
+}
+
+void OfflineDriver::setClock(double tSpeed, double tJitter, unsigned int tSeed){
+    speed = (tSpeed > 0.0) ? tSpeed : 0.0;
+    jitter = (tJitter > 0.0) ? tJitter : 0.0;
+    seed = tSeed;
+}
+
+void OfflineDriver::setReadyCheck(ReadyCheck check){
+    ready = check;
+}
+
+void OfflineDriver::setFileSink(FileWvOut* file){
+    fileSink = file;
+}
+
+bool OfflineDriver::startStream(){
+    if(stream.isRunning() || callback == 0 || bufferFrames == 0)
+        return false;
+
+    Atomic::store(stopping, 0);
+
+    return stream.start(&OfflineDriver::streamThread, (void *)this);
+}
+
+void OfflineDriver::closeStream(){
+    Atomic::store(stopping, 1);
+    stream.wait();
+}
+
+bool OfflineDriver::isStreamRunning() const{
+    return stream.isRunning() && !Atomic::load(stopping);
+}
+
+const std::vector<StkFloat>& OfflineDriver::getOutput(unsigned int c) const{
+    return memorySink[c];
+}
+
+unsigned long OfflineDriver::getLateCallbacks() const{
+    return lateCallbacks;
+}
+
+//Stream thread body
+THREAD_RETURN THREAD_TYPE OfflineDriver::streamThread(void* ptr){
+    OfflineDriver* driver = (OfflineDriver *) ptr;
+    driver->run();
+
+    return 0;
+}
+
+//Runs the callbacks until the stream ends
+void OfflineDriver::run(){
+    double period = bufferFrames / sampleRate;
+    double begin = Thread::now();
+    RtAudioStreamStatus status = 0;
+
+    for(unsigned long block = 0; !Atomic::load(stopping); block++){
+        double streamTime = block * period;
+
+        if(speed > 0.0){
+            //The device asks for the block a period after the last, give or take the jitter
+            double due = begin + (streamTime + jitter * period * nextJitter()) / speed;
+
+            //Whole milliseconds asleep, the rest given up a time slice at a time
+            for(double wait = due - Thread::now(); wait > 0.0; wait = due - Thread::now())
+                Thread::sleep(static_cast<unsigned long>(wait * 1000.0));
+        }
+        else if(ready){
+            while(!ready(userData) && !Atomic::load(stopping))
+                Thread::sleep(0);
+        }
+
+        int result = callback(&buffer[0], 0, bufferFrames, streamTime, status, userData);
+        status = 0;
+
+        //2 aborts the stream without playing the buffer
+        if(result == 2)
+            break;
+
+        if(fileSink)
+            fileSink->tickFrame(buffer);
+        else{
+            for(unsigned int c = 0; c < numChannels; c++)
+                memorySink[c].insert(memorySink[c].end(), &buffer[c * bufferFrames], &buffer[c * bufferFrames] + bufferFrames);
+        }
+
+        //The block had to be ready by the time the one before it finished playing.
+        //A device that ran dry picks up again from now, so the clock does too
+        double finished = Thread::now();
+        if(speed > 0.0 && finished > begin + (streamTime + period) / speed){
+            status = RTAUDIO_OUTPUT_UNDERFLOW;
+            lateCallbacks++;
+            begin = finished - (streamTime + period) / speed;
+        }
+
+        //1 stops the stream once the buffer has played
+        if(result != 0)
+            break;
+    }
+
+    Atomic::store(stopping, 1);
+}
+
+//Next number of the jitter generator, -1.0 to 1.0
+double OfflineDriver::nextJitter(){
+    if(jitter == 0.0)
+        return 0.0;
+
+    //The constants of Numerical Recipes' quick generator
+    seed = seed * 1664525u + 1013904223u;
+    return seed / 2147483648.0 - 1.0;
+}
@@ -0,0 +1,105 @@
+#ifndef __OFFLINEDRIVER_H__
+#define __OFFLINEDRIVER_H__
+
+#include "RtAudio.h"
+#include "FileWvOut.h"
+#include "Thread.h"
+#include "Atomic.h"
+#include <vector>
+
+/*  Stands in for an audio device. It calls an RtAudio callback on
+    a thread of its own, the way RtAudio's stream thread would, with
+    non-interleaved StkFloat buffers of a fixed size, and sends what
+    the callback wrote to a .wav file or keeps it in memory. Machines
+    without a sound card run the real-time code path through it.
+
+    The stream runs on a simulated clock. At speed 1 every callback
+    is asked for one buffer period after the one before, so the
+    timing is that of a device. Higher speeds squeeze the clock, at
+    speed 0 the callbacks run back to back. Jitter moves each request
+    early or late by up to that fraction of the period, from a seeded
+    generator so a run can be repeated. A callback that finishes
+    after its buffer was due to play gets RTAUDIO_OUTPUT_UNDERFLOW in
+    the status of the next one, as RtAudio reports it, and the clock
+    picks up from there the way a device that ran dry does.
+
+    Unpaced (speed 0), nothing waits for a reader thread feeding the
+    callback; hand in a ReadyCheck and every callback waits for it,
+    so the output does not depend on how the threads were scheduled.
+    Threads inside the callback, like the convolution tail, are the
+    host's to wait for, see ConvolutionReverb::WAIT_FOR_TAIL.
+*/
+class OfflineDriver{
+public:
+    //Asked before every callback of an unpaced stream, true once the callback can run
+    typedef bool (*ReadyCheck)(void* userData);
+
+    ~OfflineDriver(void);
+    OfflineDriver(void);
+
+    //Sets the stream up for callback(userData) with blocks of tBufferFrames
+    //frames of tNumChannels channels at tSampleRate. Not while running
+    void openStream(unsigned int tNumChannels, double tSampleRate, unsigned int tBufferFrames,
+        RtAudioCallback tCallback, void* tUserData);
+
+    //Simulated seconds per real second (0 for back to back), the largest
+    //shift of a request as a fraction of the period and the jitter's seed
+    void setClock(double tSpeed, double tJitter, unsigned int tSeed = 1);
+
+    //Called before each callback of an unpaced stream, 0 for none
+    void setReadyCheck(ReadyCheck check);
+
+    //Writes the output to file, which must be open for the stream's
+    //channels. 0 keeps it in memory instead, see getOutput()
+    void setFileSink(FileWvOut* file);
+
+    //Starts calling the callback. It runs until the callback returns
+    //non-zero or closeStream(). Returns false if the thread can't start
+    bool startStream(void);
+
+    //Stops the stream, after the callback it is in
+    void closeStream(void);
+
+    bool isStreamRunning(void) const;
+
+    //What the stream wrote to channel c of the memory sink
+    const std::vector<StkFloat>& getOutput(unsigned int c) const;
+
+    //Callbacks that finished after their buffer was due
+    unsigned long getLateCallbacks(void) const;
+
+private:
+    //Stream thread body
+    static THREAD_RETURN THREAD_TYPE streamThread(void* ptr);
+
+    //Runs the callbacks until the stream ends
+    void run(void);
+
+    //Next number of the jitter generator, -1.0 to 1.0
+    double nextJitter(void);
+
+    unsigned int numChannels; //Channels per buffer
+    double sampleRate; //Frames per simulated second
+    unsigned int bufferFrames; //Frames per buffer
+    RtAudioCallback callback; //Callback the stream drives
+    void* userData; //Handed to the callback
+    ReadyCheck ready; //Waited on before every unpaced callback, or 0
+
+    double speed; //Simulated seconds per real second, 0 is unpaced
+    double jitter; //Largest shift of a request, fraction of the period
+    unsigned int seed; //State of the jitter generator
+
+    FileWvOut* fileSink; //Where the output goes, or 0 for memory
+    std::vector< std::vector<StkFloat> > memorySink; //Output kept in memory, one vector per channel
+    StkFrames buffer; //Non-interleaved buffer the callback writes
+
+    unsigned long lateCallbacks; //Callbacks that finished after their buffer was due
+    volatile unsigned int stopping; //Set by closeStream() to stop the stream
+    Thread stream; //Calls the callback
+
+    //Not copyable, the stream thread points at the driver
+    OfflineDriver(const OfflineDriver&);
+    OfflineDriver& operator=(const OfflineDriver&);
+};
+
+#endif
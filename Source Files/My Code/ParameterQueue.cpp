@@ -0,0 +1,67 @@
+/*
+ParameterQueue.cpp
+
+Definitions of the ParameterQueue class. Single-producer,
+single-consumer ring that carries parameter changes from
+the control thread to the audio thread.
+*/
+
+#include "ParameterQueue.h"
+
+//static variables
+unsigned int ParameterQueue::CAPACITY = 256;
+
+ParameterQueue::~ParameterQueue(){
+    delete[ ] cells;
+}
+
+ParameterQueue::ParameterQueue(){
+    cells = new Change[CAPACITY];
+    mask = CAPACITY - 1;
+    writeIndex = 0;
+    readIndex = 0;
+}
+
+//Control thread only. The indices run freely, unsigned wrap-around keeps
+//writeIndex - readIndex the number of queued changes
+bool ParameterQueue::push(Processor* target, int parameter, double value){
+    unsigned int write = writeIndex;
+
+    if(write - Atomic::load(readIndex) >= CAPACITY)
+        return false;
+
+    Change& change = cells[write & mask];
+    change.target = target;
+    change.parameter = parameter;
+    change.value = value;
+
+    //Publish the cell only after it is filled in
+    Atomic::store(writeIndex, write + 1);
+
+    return true;
+}
+
+//Audio thread only
+bool ParameterQueue::pop(Change& change){
+    unsigned int read = readIndex;
+
+    if(read == Atomic::load(writeIndex))
+        return false;
+
+    change = cells[read & mask];
+
+    //Hand the cell back only after it was copied out
+    Atomic::store(readIndex, read + 1);
+
+    return true;
+}
+
+//Audio thread only
+void ParameterQueue::applyAll(){
+    Change change;
+
+    while(pop(change)){
+        if(change.target != 0)
+            change.target->setParameter(change.parameter, change.value);
+    }
+}
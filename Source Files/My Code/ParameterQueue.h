@@ -0,0 +1,51 @@
+#ifndef __PARAMETERQUEUE_H__
+#define __PARAMETERQUEUE_H__
+
+#include "Processor.h"
+#include "Atomic.h"
+
+/*  Lock-free single-producer/single-consumer queue of parameter
+    changes. The control thread pushes, the audio thread pops at
+    the start of every block and applies the change with
+    Processor::setParameter(), so no effect is ever touched while
+    it is in the middle of a block.
+
+    The ring is allocated once in the constructor. push() and pop()
+    never allocate, lock or block: a full queue simply refuses the
+    change and the caller may try again.
+*/
+class ParameterQueue{
+public:
+    static unsigned int CAPACITY; //Number of cells in the ring, a power of two
+
+    //One queued change
+    struct Change{
+        Processor* target; //Processor to change
+        int parameter; //Parameter id of target
+        double value; //New value
+    };
+
+    ~ParameterQueue(void);
+    ParameterQueue(void);
+
+    //Control thread only. Returns false if the queue is full
+    bool push(Processor* target, int parameter, double value);
+
+    //Audio thread only. Returns false if the queue is empty
+    bool pop(Change& change);
+
+    //Audio thread only. Pops every queued change and applies it
+    void applyAll(void);
+
+private:
+    Change* cells; //Ring of CAPACITY changes
+    unsigned int mask; //CAPACITY - 1
+    volatile unsigned int writeIndex; //Next cell to push to, only written by the control thread
+    volatile unsigned int readIndex; //Next cell to pop from, only written by the audio thread
+
+    //Not copyable, the ring belongs to one queue
+    ParameterQueue(const ParameterQueue&);
+    ParameterQueue& operator=(const ParameterQueue&);
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef __PROCESSOR_H__
+#define __PROCESSOR_H__
+
+#include "Stk.h"
+
+//Generic Base class for every block processing unit.
+//A Processor never touches files or devices, the host hands it
+//non-interleaved blocks: in[c] and out[c] point at nFrames samples of channel c.
+class Processor{
+public:
+        //Sample type of the delay lines. Samples are always computed in double,
+        //FLOAT32 only stores them as float, which halves the memory the lines
+        //take. FLOAT64 keeps every bit in the feedback paths
+        enum Precision {FLOAT64, FLOAT32};
+
+        //Destructor
+        virtual ~Processor(){}
+
+        Processor() : precision(FLOAT64) {}
+
+        //Heard from the next prepare(). Processors without delay lines ignore it
+        void setPrecision(Precision tPrecision) { precision = tPrecision; }
+        Precision getPrecision(void) const { return precision; }
+
+        //Sizes every buffer and table for the stream. Call once before streaming starts
+        virtual void prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels) = 0;
+
+        //Processes one block of every prepared channel. in and out may be the same buffers,
+        //nFrames must not exceed the maxBlockSize given to prepare()
+        virtual void process(const StkFloat* const* in, StkFloat* const* out, int nFrames) = 0;
+
+        //Frames of past input the output depends on while no parameter changes, or -1
+        //if the output feeds back and depends on all of it. An offline render can split
+        //the input of a processor that returns 0 or more into segments, see SegmentRenderer
+        virtual long getMemoryFrames(void) const { return -1; }
+
+        //Number of parameters that can change while streaming
+        virtual int getNumParameters(void) const { return 0; }
+
+        //Name of a live parameter, for menus
+        virtual const char* getParameterName(int /*parameter*/) const { return ""; }
+
+        //Applies one live parameter change. Only called between blocks, on the
+        //thread that calls process(), so it must not allocate or free anything
+        virtual void setParameter(int /*parameter*/, double /*value*/) {}
+
+protected:
+        Precision precision; //Sample type of the delay lines, read by prepare()
+};
+
+#endif
@@ -8,8 +8,6 @@ Reverb 3: 6 Low-Passed Comb filters in parallel into one Allpass filter
 */
 
 #include "Reverb.h"
-#include "FileWvIn.h"
-#include "AudioHandler.h"
 
 //static variables
 int Reverb1::MAX_MS_DELAY = 5000; //5 seconds
@@ -20,13 +18,13 @@ int Reverb3::A_MAX_MS_DELAY = 5000; //5 seconds
 
 
 Reverb1::~Reverb1(){
-    AP1.~Allpass();
-    AP2.~Allpass();
-    AP3.~Allpass();
-    AP4.~Allpass();
-    AP5.~Allpass();
+    //the member filters free their own delay lines
+    delete[ ] wetBlock;
 }
 Reverb1::Reverb1(){
+    numChannels = 0;
+    wetBlock = 0;
+
     setAP(1, 3500, 68);
     setAP(2, 3495, 50);
     setAP(3, 3480, 40);
@@ -35,62 +33,67 @@ Reverb1::Reverb1(){
     setMix(50);
 }
 
-//Computation functions
-int Reverb1::callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData ){
-    FileWvIn *input = (FileWvIn *) userData;
-        
-    tick(outputBuffer, input, nBufferFrames); 
-
-    if ( input->isFinished() ) {
-        AudioHandler::done = true;
-        return 1;
-    }
-    else
-        return 0;
-}
-
-void Reverb1::tick(void *outputBuffer, void *input,int nBufferFrames){
-    register StkFloat *out = (StkFloat *) outputBuffer;
-    FileWvIn *in = (FileWvIn *) input;
-    
-    StkFrames frames;
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
-
-    for(unsigned int i = 0; i<frames.size(); i++){
-        *out = computeSample(frames[i]); //assign output sample
-        out++; //move to next output sample
-    }
+void Reverb1::prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels){
+    numChannels = nChannels;
+    dryMix.prepare(tSampleRate);
+    wetMix.prepare(tSampleRate);
+
+    delete[ ] wetBlock;
+    wetBlock = new double[maxBlockSize];
+
+    //The filters' lines take the reverb's precision
+    AP1.setPrecision(precision);
+    AP2.setPrecision(precision);
+    AP3.setPrecision(precision);
+    AP4.setPrecision(precision);
+    AP5.setPrecision(precision);
+
+    AP1.prepare(tSampleRate, maxBlockSize, nChannels);
+    AP2.prepare(tSampleRate, maxBlockSize, nChannels);
+    AP3.prepare(tSampleRate, maxBlockSize, nChannels);
+    AP4.prepare(tSampleRate, maxBlockSize, nChannels);
+    AP5.prepare(tSampleRate, maxBlockSize, nChannels);
 }
 
-StkFrames& Reverb1::tick(void *input, int nBufferFrames, StkFrames& frames){
-    FileWvIn *in = (FileWvIn *) input;
-    
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
-
-    for(unsigned int i = 0; i<frames.size(); i++){
-        computeSample(frames[i]); //Frames[i] is passed by reference
+void Reverb1::process(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+    //Mix gains of this block, every channel walks the same ramps
+    double dryStep, wetStep;
+    double dryStart = dryMix.begin(nFrames, dryStep);
+    double wetStart = wetMix.begin(nFrames, wetStep);
+
+    //Every filter keeps a delay line per channel, so run the channels one after another
+    for(unsigned int c = 0; c < numChannels; c++){
+        const StkFloat *input = in[c];
+        StkFloat *output = out[c];
+        double dryNow = dryStart;
+        double wetNow = wetStart;
+
+        //The allpasses are in series, each runs over the whole block in turn
+        AP1.processChannel(input, wetBlock, nFrames, c);
+        AP2.processChannel(wetBlock, wetBlock, nFrames, c);
+        AP3.processChannel(wetBlock, wetBlock, nFrames, c);
+        AP4.processChannel(wetBlock, wetBlock, nFrames, c);
+        AP5.processChannel(wetBlock, wetBlock, nFrames, c);
+
+        for(int i = 0; i<nFrames; i++){
+            StkFloat sample = input[i];
+            computeSample(sample, wetBlock[i], dryNow, wetNow); //sample is passed by reference
+            output[i] = sample;
+
+            dryNow += dryStep;
+            wetNow += wetStep;
+        }
     }
 
-    return frames;
+    dryMix.end(nFrames);
+    wetMix.end(nFrames);
 }
 
-double Reverb1::computeSample(double& in){
-    double inComponent = ((100 - mix) / 100.0) * in; //store and adjust dry signal
-    
-    //Sequentially pass the input value
-    AP1.computeSample(in);
-    AP2.computeSample(in);
-    AP3.computeSample(in);
-    AP4.computeSample(in);
-    AP5.computeSample(in);
+double Reverb1::computeSample(double& in, double wetComponent, double dryGain, double wetGain){
+    double inComponent = dryGain * in; //store and adjust dry signal
 
-    in *= (mix / 100.0); //adjust the wet signal
+    //The input was passed through the allpasses in sequence, a block at a time
+    in = wetComponent * wetGain; //adjust the wet signal
 
     in += inComponent; //compute final output
 
@@ -108,6 +111,10 @@ void Reverb1::setMix(int tMix){
 
     if(mix > 100 || mix < 0)
         mix = 50;
+
+    //Ramps while streaming, prepare() settles it before
+    dryMix.setTarget((100 - mix) / 100.0);
+    wetMix.setTarget(mix / 100.0);
 }
 
 void Reverb1::setAP(int APnum, int tDelay, int tDecay){
@@ -132,16 +139,50 @@ void Reverb1::setAP(int APnum, int tDelay, int tDecay){
     }
 }
 
+//Live parameter changes, applied between blocks
+const char* Reverb1::PARAMETER_NAMES[] = {"Mix (0-100)", "Decay of all filters (0-99)"};
+
+int Reverb1::getNumParameters() const{
+    return NUM_PARAMETERS;
+}
+const char* Reverb1::getParameterName(int parameter) const{
+    if(parameter < 0 || parameter >= NUM_PARAMETERS)
+        return "";
+
+    return PARAMETER_NAMES[parameter];
+}
+void Reverb1::setParameter(int parameter, double value){
+    int percent = static_cast<int>(value);
+
+    switch(parameter){
+        case MIX:
+            if(percent >= 0 && percent <= 100)
+                setMix(percent);
+            break;
+        case DECAY:
+            AP1.setDecay(percent);
+            AP2.setDecay(percent);
+            AP3.setDecay(percent);
+            AP4.setDecay(percent);
+            AP5.setDecay(percent);
+            break;
+    }
+}
+
 
 Reverb2::~Reverb2(){
-    C1.~Comb();
-    C2.~Comb();
-    C3.~Comb();
-    C4.~Comb();
-    AP1.~Allpass();
-    AP2.~Allpass();
+    //the member filters and the bank free their own delay lines
+    delete[ ] wetBlock;
 }
 Reverb2::Reverb2(){
+    numChannels = 0;
+    wetBlock = 0;
+
+    combs.addComb(&C1);
+    combs.addComb(&C2);
+    combs.addComb(&C3);
+    combs.addComb(&C4);
+
     setComb(1, 32, 50);
     setComb(2, 33, 51);
     setComb(3, 34, 52);
@@ -151,85 +192,68 @@ Reverb2::Reverb2(){
     setMix(50);
 }
 
-//Computation functions
-int Reverb2::callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData ){
-    FileWvIn *input = (FileWvIn *) userData;
-        
-    tick(outputBuffer, input, nBufferFrames); 
+void Reverb2::prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels){
+    numChannels = nChannels;
+    dryMix.prepare(tSampleRate);
+    wetMix.prepare(tSampleRate);
 
-    if ( input->isFinished() ) {
-        AudioHandler::done = true;
-        return 1;
-    }
-    else
-        return 0;
-}
-
-void Reverb2::tick(void *outputBuffer, void *input,int nBufferFrames){
-    register StkFloat *out = (StkFloat *) outputBuffer;
-    FileWvIn *in = (FileWvIn *) input;
-    
-    StkFrames frames;
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
-
-    for(unsigned int i = 0; i<frames.size(); i++){
-        *out = computeSample(frames[i]); //assign output sample
-        out++; //move to next output sample
-    }
-}
-
-StkFrames& Reverb2::tick(void *input, int nBufferFrames, StkFrames& frames){
-    FileWvIn *in = (FileWvIn *) input;
-    
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
+    //The filters' lines take the reverb's precision
+    combs.setPrecision(precision);
+    AP1.setPrecision(precision);
+    AP2.setPrecision(precision);
 
-    for(unsigned int i = 0; i<frames.size(); i++){
-        computeSample(frames[i]); //Frames[i] is passed by reference
-    }
+    //The bank keeps the comb delay lines, C1-C4 need none of their own
+    combs.prepare(tSampleRate, nChannels);
+    delete[ ] wetBlock;
+    wetBlock = new double[maxBlockSize];
 
-    return frames;
+    AP1.prepare(tSampleRate, maxBlockSize, nChannels);
+    AP2.prepare(tSampleRate, maxBlockSize, nChannels);
 }
 
-double Reverb2::computeSample(double& in){
-    //Compute parallel values for comb filters
-    
-    double comb1 = in;
-
-    C1.computeSample(comb1);
-
-    double comb2 = in;
-
-    C2.computeSample(comb2);
-
-    double comb3 = in;
-
-    C3.computeSample(comb3);
+void Reverb2::process(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+    //Mix gains of this block, every channel walks the same ramps
+    double dryStep, wetStep;
+    double dryStart = dryMix.begin(nFrames, dryStep);
+    double wetStart = wetMix.begin(nFrames, wetStep);
+
+    //Every filter keeps a delay line per channel, so run the channels one after another
+    for(unsigned int c = 0; c < numChannels; c++){
+        const StkFloat *input = in[c];
+        StkFloat *output = out[c];
+        double dryNow = dryStart;
+        double wetNow = wetStart;
+
+        combs.process(input, wetBlock, nFrames, c);
+        AP1.processChannel(wetBlock, wetBlock, nFrames, c);
+        AP2.processChannel(wetBlock, wetBlock, nFrames, c);
+
+        for(int i = 0; i<nFrames; i++){
+            StkFloat sample = input[i];
+            computeSample(sample, wetBlock[i], dryNow, wetNow); //sample is passed by reference
+            output[i] = sample;
+
+            dryNow += dryStep;
+            wetNow += wetStep;
+        }
+    }
 
-    double comb4 = in;
+    dryMix.end(nFrames);
+    wetMix.end(nFrames);
+}
 
-    C4.computeSample(comb4);
+double Reverb2::computeSample(double& in, double wetComponent, double dryGain, double wetGain){
+    //The parallel comb values were summed by the bank and
+    //passed through the 2 allpass filters, a block at a time
 
     //Compute input component
-    double inComponent = in * ((100 - mix) / 100.0);
-
-    //Sum the parallel comb values
-    double combComponent = comb1 + comb2 + comb3 + comb4;
-
-    //Sequentially pass parallel comb values through 2 allpass filters
-    AP1.computeSample(combComponent);
-    AP2.computeSample(combComponent);
+    double inComponent = in * dryGain;
 
     //Adjust wet signal by mix ratio
-    combComponent *= (mix / 100.0);
+    wetComponent *= wetGain;
 
     //designate output value
-    in = inComponent + combComponent;
+    in = inComponent + wetComponent;
 
     //limit output
     if(in >= 1.0)
@@ -245,6 +269,10 @@ void Reverb2::setMix(int tMix){
 
     if(mix > 100 || mix < 0)
         mix = 50;
+
+    //Ramps while streaming, prepare() settles it before
+    dryMix.setTarget((100 - mix) / 100.0);
+    wetMix.setTarget(mix / 100.0);
 }
 
 void Reverb2::setAP(int APnum, int tDelay, int tDecay){
@@ -279,16 +307,52 @@ void Reverb2::setComb(int Combnum, int tDelay, int tDecay){
     }
 }
 
+//Live parameter changes, applied between blocks
+const char* Reverb2::PARAMETER_NAMES[] = {"Mix (0-100)", "Decay of all filters (0-99)"};
+
+int Reverb2::getNumParameters() const{
+    return NUM_PARAMETERS;
+}
+const char* Reverb2::getParameterName(int parameter) const{
+    if(parameter < 0 || parameter >= NUM_PARAMETERS)
+        return "";
+
+    return PARAMETER_NAMES[parameter];
+}
+void Reverb2::setParameter(int parameter, double value){
+    int percent = static_cast<int>(value);
+
+    switch(parameter){
+        case MIX:
+            if(percent >= 0 && percent <= 100)
+                setMix(percent);
+            break;
+        case DECAY:
+            C1.setDecay(percent);
+            C2.setDecay(percent);
+            C3.setDecay(percent);
+            C4.setDecay(percent);
+            AP1.setDecay(percent);
+            AP2.setDecay(percent);
+            break;
+    }
+}
+
 Reverb3::~Reverb3(){
-    LPC1.~LPComb();
-    LPC2.~LPComb();
-    LPC3.~LPComb();
-    LPC4.~LPComb();
-    LPC5.~LPComb();
-    LPC6.~LPComb();
-    AP.~Allpass();
+    //the member filters and the bank free their own delay lines
+    delete[ ] wetBlock;
 }
 Reverb3::Reverb3(){
+    numChannels = 0;
+    wetBlock = 0;
+
+    combs.addComb(&LPC1);
+    combs.addComb(&LPC2);
+    combs.addComb(&LPC3);
+    combs.addComb(&LPC4);
+    combs.addComb(&LPC5);
+    combs.addComb(&LPC6);
+
     setLPComb(1, 30, 40, 35);
     setLPComb(2, 31, 41, 36);
     setLPComb(3, 32, 42, 37);
@@ -299,97 +363,73 @@ Reverb3::Reverb3(){
     setMix(50);
 }
 
-//Computation functions
-int Reverb3::callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData ){
-    FileWvIn *input = (FileWvIn *) userData;
-        
-    tick(outputBuffer, input, nBufferFrames); 
-
-    if ( input->isFinished() ) {
-        AudioHandler::done = true;
-        return 1;
-    }
-    else
-        return 0;
-}
-
-void Reverb3::tick(void *outputBuffer, void *input,int nBufferFrames){
-    register StkFloat *out = (StkFloat *) outputBuffer;
-    FileWvIn *in = (FileWvIn *) input;
-    
-    StkFrames frames;
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
-
-    for(unsigned int i = 0; i<frames.size(); i++){
-        *out = computeSample(frames[i]); //assign output sample
-        out++; //move to next output sample
-    }
-}
+void Reverb3::prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels){
+    numChannels = nChannels;
+    dryMix.prepare(tSampleRate);
+    wetMix.prepare(tSampleRate);
 
-StkFrames& Reverb3::tick(void *input, int nBufferFrames, StkFrames& frames){
-    FileWvIn *in = (FileWvIn *) input;
-    
-    unsigned int channels = AudioHandler::nChannels;
-    frames.resize( nBufferFrames, channels );
-    
-    in->tickFrame( frames );
+    //The filters' lines take the reverb's precision
+    combs.setPrecision(precision);
+    AP.setPrecision(precision);
 
-    for(unsigned int i = 0; i<frames.size(); i++){
-        computeSample(frames[i]); //Frames[i] is passed by reference
-    }
+    //The bank keeps the comb delay lines, LPC1-LPC6 need none of their own
+    combs.prepare(tSampleRate, nChannels);
+    delete[ ] wetBlock;
+    wetBlock = new double[maxBlockSize];
 
-    return frames;
+    AP.prepare(tSampleRate, maxBlockSize, nChannels);
 }
 
-double Reverb3::computeSample(double& in){
-    //Compute parallel Low-Pass Comb filters
-
-    double comb1 = in;
-    
-    LPC1.computeSample(comb1);
-
-    double comb2 = in;
-
-    LPC2.computeSample(comb2);
-
-    double comb3 = in;
-
-    LPC3.computeSample(comb3);
-
-    double comb4 = in;
-
-    LPC4.computeSample(comb4);
-
-    double comb5 = in;
-
-    LPC5.computeSample(comb5);
-
-    double comb6 = in;
-
-    LPC6.computeSample(comb6);
-
-    //Sum the parallel comb values
-    double combComponent = comb1 + comb2 + comb3 + comb4 + comb5 + comb6;
+void Reverb3::process(const StkFloat* const* in, StkFloat* const* out, int nFrames){
+    //Mix gains of this block, every channel walks the same ramps
+    double dryStep, wetStep;
+    double dryStart = dryMix.begin(nFrames, dryStep);
+    double wetStart = wetMix.begin(nFrames, wetStep);
+
+    //Every filter keeps a delay line per channel, so run the channels one after another
+    for(unsigned int c = 0; c < numChannels; c++){
+        const StkFloat *input = in[c];
+        StkFloat *output = out[c];
+        double dryNow = dryStart;
+        double wetNow = wetStart;
+
+        combs.process(input, wetBlock, nFrames, c);
+
+        //limit the comb sums to clean up sound
+        for(int i = 0; i<nFrames; i++){
+            if(wetBlock[i] >= 1.0)
+                wetBlock[i] = 0.9999;
+            else if(wetBlock[i] <= -1.0)
+                wetBlock[i] = -0.9999;
+        }
+
+        AP.processChannel(wetBlock, wetBlock, nFrames, c);
+
+        for(int i = 0; i<nFrames; i++){
+            StkFloat sample = input[i];
+            computeSample(sample, wetBlock[i], dryNow, wetNow); //sample is passed by reference
+            output[i] = sample;
+
+            dryNow += dryStep;
+            wetNow += wetStep;
+        }
+    }
 
-    //limit the combComponent to clean up sound
-    if(combComponent >= 1.0)
-        combComponent = 0.9999;
-    else if(combComponent <= -1.0)
-        combComponent = -0.9999;
+    dryMix.end(nFrames);
+    wetMix.end(nFrames);
+}
 
-    //Pass through Allpass filter
-    AP.computeSample(combComponent);
+double Reverb3::computeSample(double& in, double wetComponent, double dryGain, double wetGain){
+    //The parallel Low-Pass Comb values were summed by the bank,
+    //limited and passed through the Allpass filter a block at a time
 
     //Adjust wet signal by mix
-    combComponent *= (mix / 100.0);
+    wetComponent *= wetGain;
 
     //Compute in component
-    double inComponent = in * ((100 - mix) / 100.0);
+    double inComponent = in * dryGain;
 
-    in = inComponent + combComponent;
+    in = inComponent + wetComponent;
 
     //limit output
     if(in >= 1.0)
@@ -405,6 +445,10 @@ void Reverb3::setMix(int tMix){
 
     if(mix > 100 || mix < 0)
         mix = 50;
+
+    //Ramps while streaming, prepare() settles it before
+    dryMix.setTarget((100 - mix) / 100.0);
+    wetMix.setTarget(mix / 100.0);
 }
 
 void Reverb3::setAP(int tDelay, int tDecay){
@@ -434,4 +478,48 @@ void Reverb3::setLPComb(int Combnum, int tDelay, int tDecay1, int tDecay2){
         default:
             LPC1.setLPComb(tDelay, tDecay1, tDecay2);
     }
-}
\ No newline at end of file
+}
+
+//Live parameter changes, applied between blocks
+const char* Reverb3::PARAMETER_NAMES[] = {"Mix (0-100)", "First decay of the Low-Pass Combs (0-99)",
+    "Second decay of the Low-Pass Combs (0-99)", "Decay of the Allpass (0-99)"};
+
+int Reverb3::getNumParameters() const{
+    return NUM_PARAMETERS;
+}
+const char* Reverb3::getParameterName(int parameter) const{
+    if(parameter < 0 || parameter >= NUM_PARAMETERS)
+        return "";
+
+    return PARAMETER_NAMES[parameter];
+}
+void Reverb3::setParameter(int parameter, double value){
+    int percent = static_cast<int>(value);
+
+    switch(parameter){
+        case MIX:
+            if(percent >= 0 && percent <= 100)
+                setMix(percent);
+            break;
+        //-1 leaves the other decay of the pair untouched
+        case COMB_DECAY1:
+            LPC1.setDecays(percent, -1);
+            LPC2.setDecays(percent, -1);
+            LPC3.setDecays(percent, -1);
+            LPC4.setDecays(percent, -1);
+            LPC5.setDecays(percent, -1);
+            LPC6.setDecays(percent, -1);
+            break;
+        case COMB_DECAY2:
+            LPC1.setDecays(-1, percent);
+            LPC2.setDecays(-1, percent);
+            LPC3.setDecays(-1, percent);
+            LPC4.setDecays(-1, percent);
+            LPC5.setDecays(-1, percent);
+            LPC6.setDecays(-1, percent);
+            break;
+        case AP_DECAY:
+            AP.setDecay(percent);
+            break;
+    }
+}
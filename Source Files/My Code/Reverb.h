@@ -1,102 +1,152 @@
 #ifndef __REVERB_H__
 #define __REVERB_H__
 
-#include "RtAudio.h"
-#include "FileWvOut.h"
+#include "Processor.h"
 #include "Filters.h"
+#include "CombBank.h"
+#include "Smoother.h"
 
-class Reverb1{
+class Reverb1 : public Processor{
 public:
     static int MAX_MS_DELAY; //Maximum length of the delay 
 
+    //Live parameters, see Processor::setParameter()
+    enum Parameter {MIX, DECAY, NUM_PARAMETERS};
+
     ~Reverb1(void);
     Reverb1(void);
 
-    //Computation functions
-    int callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData );
+    //Sizes every filter's delay lines for the stream. Call once before streaming starts
+    void prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels);
 
-    void tick(void *outputBuffer, void *input,int nBufferFrames);
-    
-    StkFrames& tick(void *input, int nBufferFrames, StkFrames& frames);
+    //Processes one block, one channel at a time
+    void process(const StkFloat* const* in, StkFloat* const* out, int nFrames);
 
-    double computeSample(double& in);
+    //wetComponent is the allpasses' output at this sample, dryGain and wetGain are the mix
+    double computeSample(double& in, double wetComponent, double dryGain, double wetGain);
 
     void setMix(int tMix);
 
     void setAP(int APnum, int tDelay, int tDecay);
 
+    //Live parameter changes, applied between blocks
+    int getNumParameters(void) const;
+    const char* getParameterName(int parameter) const;
+    void setParameter(int parameter, double value);
+
 private:
+    static const char* PARAMETER_NAMES[]; //Menu names of the live parameters
+
     int mix; //ratio of Wet / Dry signals
+    Smoother dryMix; //(100 - mix) / 100, ramped when the mix changes live
+    Smoother wetMix; //mix / 100, ramped when the mix changes live
+    unsigned int numChannels; //Number of channels the filters were prepared for
     Allpass AP1;
     Allpass AP2;
     Allpass AP3;
     Allpass AP4;
     Allpass AP5;
+    double* wetBlock; //The allpasses' output for one block of one channel
 };
 
-class Reverb2{
+class Reverb2 : public Processor{
 public:
     static int A_MAX_MS_DELAY; //Maximum length of the allpass delay 
     static int C_MAX_MS_DELAY; //Maximum length of the comb delay
 
+    //Live parameters, see Processor::setParameter()
+    enum Parameter {MIX, DECAY, NUM_PARAMETERS};
+
     ~Reverb2(void);
     Reverb2(void);
 
-    //Computation functions
-    int callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData );
+    //Sizes every filter's delay lines for the stream. Call once before streaming starts
+    void prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels);
 
-    void tick(void *outputBuffer, void *input,int nBufferFrames);
-    
-    StkFrames& tick(void *input, int nBufferFrames, StkFrames& frames);
+    //Processes one block, one channel at a time. The combs run over the
+    //whole block first, then each allpass in turn
+    void process(const StkFloat* const* in, StkFloat* const* out, int nFrames);
 
-    double computeSample(double& in);
+    //wetComponent is the allpass output at this sample, dryGain and wetGain are the mix
+    double computeSample(double& in, double wetComponent, double dryGain, double wetGain);
 
     void setMix(int tMix);
 
     void setAP(int APnum, int tDelay, int tDecay);
 
+    //Delay changes are heard from the next prepare()
     void setComb(int Combnum, int tDelay, int tDecay);
 
+    //Live parameter changes, applied between blocks
+    int getNumParameters(void) const;
+    const char* getParameterName(int parameter) const;
+    void setParameter(int parameter, double value);
+
 private:
+    static const char* PARAMETER_NAMES[]; //Menu names of the live parameters
+
     int mix; //ratio of Wet / Dry signals
-    Comb C1;
+    Smoother dryMix; //(100 - mix) / 100, ramped when the mix changes live
+    Smoother wetMix; //mix / 100, ramped when the mix changes live
+    unsigned int numChannels; //Number of channels the filters were prepared for
+    Comb C1; //The combs hold their settings, combs runs them
     Comb C2;
     Comb C3;
     Comb C4;
+    CombBank combs; //C1-C4 in lockstep
+    double* wetBlock; //The combs' sums for one block of one channel, then the allpass output
     Allpass AP1;
     Allpass AP2;
 };
 
-class Reverb3{
+class Reverb3 : public Processor{
 public:
     static int A_MAX_MS_DELAY; //Maximum length of the allpass delay 
     static int C_MAX_MS_DELAY; //Maximum length of the comb delay
+
+    //Live parameters, see Processor::setParameter()
+    enum Parameter {MIX, COMB_DECAY1, COMB_DECAY2, AP_DECAY, NUM_PARAMETERS};
+
     ~Reverb3(void);
     Reverb3(void);
 
-    //Computation functions
-    int callback( void *outputBuffer, void *notUsed, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData );
+    //Sizes every filter's delay lines for the stream. Call once before streaming starts
+    void prepare(double tSampleRate, unsigned int maxBlockSize, unsigned int nChannels);
 
-    void tick(void *outputBuffer, void *input,int nBufferFrames);
-    
-    StkFrames& tick(void *input, int nBufferFrames, StkFrames& frames);
+    //Processes one block, one channel at a time. The combs run over the
+    //whole block first, then the allpass
+    void process(const StkFloat* const* in, StkFloat* const* out, int nFrames);
 
-    double computeSample(double& in);
+    //wetComponent is the allpass output at this sample, dryGain and wetGain are the mix
+    double computeSample(double& in, double wetComponent, double dryGain, double wetGain);
 
     void setMix(int tMix);
 
     void setAP(int tDelay, int tDecay);
 
+    //Delay changes are heard from the next prepare()
     void setLPComb(int Combnum, int tDelay, int tDecay1, int tDecay2);
 
+    //Live parameter changes, applied between blocks
+    int getNumParameters(void) const;
+    const char* getParameterName(int parameter) const;
+    void setParameter(int parameter, double value);
+
 private:
+    static const char* PARAMETER_NAMES[]; //Menu names of the live parameters
+
     int mix; //ratio of Wet / Dry signals
-    LPComb LPC1;
+    Smoother dryMix; //(100 - mix) / 100, ramped when the mix changes live
+    Smoother wetMix; //mix / 100, ramped when the mix changes live
+    unsigned int numChannels; //Number of channels the filters were prepared for
+    LPComb LPC1; //The combs hold their settings, combs runs them
     LPComb LPC2;
     LPComb LPC3;
     LPComb LPC4;
     LPComb LPC5;
     LPComb LPC6;
+    CombBank combs; //LPC1-LPC6 in lockstep
+    double* wetBlock; //The combs' sums for one block of one channel, then the allpass output
     Allpass AP;
 };
 
@@ -0,0 +1,150 @@
+/*
+SegmentRenderer.cpp
+
+Definitions of the SegmentRenderer class. Cuts a window of a
+file into segments, renders each on its own thread and copy of
+the effect with a prefix that covers the effect's memory, and
+stitches the segments back together.
+*/
+
+#include "SegmentRenderer.h"
+#include <sstream>
+#include <vector>
+
+SegmentRenderer::~SegmentRenderer(){
+}
+
+SegmentRenderer::SegmentRenderer(){
+    precision = Processor::FLOAT64;
+    input = 0;
+    output = 0;
+    numFrames = 0;
+    memoryBlocks = 0;
+    sampleRate = 44100.0;
+    blockFrames = 256;
+    numChannels = 0;
+}
+
+bool SegmentRenderer::canSplit(const Effect& effect){
+    return effect.getMemoryFrames() >= 0;
+}
+
+//Whole blocks of prefix, so every segment's blocks line up with the serial render's
+unsigned long SegmentRenderer::getMemoryBlocks(const Effect& effect, unsigned int blockFrames){
+    if(!canSplit(effect) || blockFrames == 0)
+        return 0;
+
+    unsigned long memory = static_cast<unsigned long>(effect.getMemoryFrames());
+    return (memory + blockFrames - 1) / blockFrames;
+}
+
+//Renders the blocks from firstFrame on, one segment per thread
+bool SegmentRenderer::render(const Effect& effect, const StkFloat* const* in, StkFloat* const* out, unsigned long firstFrame,
+    unsigned long frames, double tSampleRate, unsigned int tBlockFrames, unsigned int nChannels, unsigned int numThreads){
+    if(!canSplit(effect) || tBlockFrames == 0)
+        return false;
+
+    if(numThreads == 0)
+        numThreads = Thread::countProcessors();
+
+    answers = effect.getAnswers();
+    precision = effect.getPrecision();
+    input = in;
+    output = out;
+    numFrames = frames;
+    sampleRate = tSampleRate;
+    blockFrames = tBlockFrames;
+    numChannels = nChannels;
+
+    memoryBlocks = getMemoryBlocks(effect, blockFrames);
+
+    unsigned long block = firstFrame / blockFrames;
+    unsigned long endBlock = (numFrames + blockFrames - 1) / blockFrames;
+    unsigned long numBlocks = (endBlock > block) ? endBlock - block : 0;
+    unsigned int numSegments = (numThreads < numBlocks) ? numThreads : static_cast<unsigned int>(numBlocks);
+    if(numSegments == 0)
+        return true;
+
+    //Every segment gets the same share of the blocks, the first ones one more
+    Segment* segments = new Segment[numSegments];
+
+    for(unsigned int s = 0; s < numSegments; s++){
+        unsigned long share = numBlocks / numSegments + ((s < numBlocks % numSegments) ? 1 : 0);
+
+        segments[s].renderer = this;
+        segments[s].firstBlock = block;
+        segments[s].endBlock = block + share;
+        segments[s].rendered = false;
+        block += share;
+    }
+
+    for(unsigned int s = 0; s < numSegments; s++){
+        if(!segments[s].thread.start(&SegmentRenderer::segmentThread, (void *)&segments[s]))
+            renderSegment(segments[s]); //no thread, render it on this one
+    }
+
+    bool rendered = true;
+    for(unsigned int s = 0; s < numSegments; s++){
+        segments[s].thread.wait();
+        rendered = rendered && segments[s].rendered;
+    }
+
+    delete[ ] segments;
+    return rendered;
+}
+
+//Thread body, renders one segment
+THREAD_RETURN THREAD_TYPE SegmentRenderer::segmentThread(void* ptr){
+    Segment* segment = (Segment *) ptr;
+    segment->renderer->renderSegment(*segment);
+
+    return 0;
+}
+
+//Sets up a copy of the effect and renders the segment, prefix first
+void SegmentRenderer::renderSegment(Segment& segment){
+    //The menus read the recorded answers, their questions go nowhere
+    std::istringstream menuAnswers(answers);
+    std::ostream prompts(0);
+
+    Effect effect;
+    effect.setConsole(menuAnswers, prompts);
+    effect.setPrecision(precision);
+    effect.prepare(sampleRate, blockFrames, numChannels);
+    if(!effect.chooseEffect() || menuAnswers.fail())
+        return;
+
+    effect.prepare(sampleRate, blockFrames, numChannels);
+
+    std::vector<StkFloat> frames(blockFrames * numChannels);
+    std::vector<StkFloat*> channels(numChannels);
+    for(unsigned int c = 0; c < numChannels; c++)
+        channels[c] = &frames[c * blockFrames];
+
+    unsigned long start = (segment.firstBlock > memoryBlocks) ? segment.firstBlock - memoryBlocks : 0;
+
+    for(unsigned long block = start; block < segment.endBlock; block++){
+        unsigned long first = block * blockFrames;
+        unsigned long count = (numFrames - first < blockFrames) ? numFrames - first : blockFrames;
+
+        for(unsigned int c = 0; c < numChannels; c++){
+            for(unsigned long i = 0; i < count; i++)
+                channels[c][i] = input[c][first + i];
+            for(unsigned long i = count; i < blockFrames; i++)
+                channels[c][i] = 0.0;
+        }
+
+        effect.process(&channels[0], &channels[0], blockFrames); //in place
+
+        //The prefix only fills the delay lines
+        if(block < segment.firstBlock)
+            continue;
+
+        for(unsigned int c = 0; c < numChannels; c++){
+            for(unsigned long i = 0; i < count; i++)
+                output[c][first + i] = channels[c][i];
+        }
+    }
+
+    segment.rendered = true;
+}
@@ -0,0 +1,77 @@
+#ifndef __SEGMENTRENDERER_H__
+#define __SEGMENTRENDERER_H__
+
+#include "Effect.h"
+#include "Thread.h"
+#include <string>
+
+/*  Renders a file through a feed-forward effect on several
+    threads at once. An effect whose getMemoryFrames() is not -1
+    only hears a bounded stretch of past input, so the file can be
+    cut into segments of whole blocks and each rendered on its own
+    copy of the effect. A segment starts early by enough blocks to
+    cover the memory, the prefix fills the delay lines the way the
+    blocks before it did and its output is thrown away.
+
+    The blocks line up with the serial render's, so the output is
+    the same, bit for bit, as rendering the file in one pass.
+
+    The file can be rendered a window at a time. A window starts
+    with the last getMemoryBlocks() blocks of the one before it,
+    which are only heard, and renders the blocks after them.
+
+    Each thread sets its copy up from the effect's answers, see
+    Effect::getAnswers(). Parameters changed live are not copied,
+    an offline render has none.
+*/
+class SegmentRenderer{
+public:
+    ~SegmentRenderer(void);
+    SegmentRenderer(void);
+
+    //True if effect only depends on a bounded stretch of past input
+    static bool canSplit(const Effect& effect);
+
+    //Whole blocks of blockFrames that cover the effect's memory, 0 if it can't be split
+    static unsigned long getMemoryBlocks(const Effect& effect, unsigned int blockFrames);
+
+    //Renders frames firstFrame to frames of in to out on numThreads threads (0 for
+    //one per processor), blockFrames at a time. The frames before firstFrame are
+    //only heard, firstFrame is a whole number of blocks. in[c] and out[c] hold
+    //frames frames of channel c, frames past the end of in are taken as silence.
+    //Returns false if the effect can't be split or a copy of it can't be set up
+    bool render(const Effect& effect, const StkFloat* const* in, StkFloat* const* out, unsigned long firstFrame,
+        unsigned long frames, double tSampleRate, unsigned int tBlockFrames, unsigned int nChannels, unsigned int numThreads);
+
+private:
+    //One segment and the thread rendering it
+    struct Segment{
+        SegmentRenderer* renderer; //Renderer the segment belongs to
+        unsigned long firstBlock; //First block of output
+        unsigned long endBlock; //Block past the last one of output
+        bool rendered; //False if the copy of the effect could not be set up
+        Thread thread; //Runs segmentThread(this)
+    };
+
+    //Thread body, renders one segment
+    static THREAD_RETURN THREAD_TYPE segmentThread(void* ptr);
+
+    //Sets up a copy of the effect and renders segment on the calling thread
+    void renderSegment(Segment& segment);
+
+    std::string answers; //Answers that set the effect up
+    Processor::Precision precision; //Precision of the effect
+    const StkFloat* const* input; //Input, one buffer per channel
+    StkFloat* const* output; //Output, one buffer per channel
+    unsigned long numFrames; //Frames of output
+    unsigned long memoryBlocks; //Blocks before a segment that reach its output
+    double sampleRate; //Sample rate of the file
+    unsigned int blockFrames; //Frames per block
+    unsigned int numChannels; //Channels in input and output
+
+    //Not copyable, segments point at the renderer
+    SegmentRenderer(const SegmentRenderer&);
+    SegmentRenderer& operator=(const SegmentRenderer&);
+};
+
+#endif
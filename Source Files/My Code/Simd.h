@@ -0,0 +1,23 @@
+#ifndef __SIMD_H__
+#define __SIMD_H__
+
+/*  The one check for SSE2, shared by every kernel that has a
+    two-doubles-per-register path. __SIMD_SSE2__ is defined when
+    the compiler may use it, the plain loops are used otherwise.
+*/
+
+//SSE2 is always there on x64 and with /arch:SSE2 or -msse2 on x86
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define __SIMD_SSE2__
+  #include <emmintrin.h>
+
+//Two samples into a ring of either sample type, float rings are rounded
+static inline void storePair(double* samples, __m128d pair){
+    _mm_storeu_pd(samples, pair);
+}
+static inline void storePair(float* samples, __m128d pair){
+    _mm_storel_pi((__m64 *) samples, _mm_cvtpd_ps(pair));
+}
+#endif
+
+#endif
@@ -0,0 +1,78 @@
+/*
+Smoother.cpp
+
+Definitions of the Smoother class, a per-block linear
+ramp for parameters that change while streaming.
+*/
+
+#include "Smoother.h"
+
+//static variables
+double Smoother::RAMP_MS = 20.0; //20 ms, short enough to follow a knob, long enough not to click
+
+Smoother::~Smoother(){}
+
+Smoother::Smoother(){
+    current = 0.0;
+    target = 0.0;
+    rampFrames = 1;
+    framesLeft = 0;
+}
+
+void Smoother::prepare(double tSampleRate){
+    rampFrames = static_cast<int>((RAMP_MS / 1000.0) * tSampleRate);
+
+    if(rampFrames < 1)
+        rampFrames = 1;
+
+    //A new stream starts settled
+    current = target;
+    framesLeft = 0;
+}
+
+void Smoother::setValue(double value){
+    current = value;
+    target = value;
+    framesLeft = 0;
+}
+
+void Smoother::setTarget(double tTarget){
+    target = tTarget;
+    framesLeft = (current == target) ? 0 : rampFrames;
+}
+
+double Smoother::getTarget() const{
+    return target;
+}
+
+bool Smoother::isRamping() const{
+    return framesLeft > 0;
+}
+
+//A ramp that ends inside the block is stretched to the end of the block,
+//so the step stays constant over the whole block
+double Smoother::begin(int nFrames, double& step) const{
+    if(framesLeft <= 0){
+        step = 0.0;
+        return current;
+    }
+
+    int frames = (framesLeft > nFrames) ? framesLeft : nFrames;
+    step = (target - current) / frames;
+
+    return current;
+}
+
+void Smoother::end(int nFrames){
+    if(framesLeft <= 0)
+        return;
+
+    if(framesLeft <= nFrames){
+        current = target;
+        framesLeft = 0;
+    }
+    else{
+        current += ((target - current) / framesLeft) * nFrames;
+        framesLeft -= nFrames;
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef __SMOOTHER_H__
+#define __SMOOTHER_H__
+
+/*  Linear ramp from the current value of a parameter to a new
+    target, so live changes glide instead of jumping.
+
+    The effects run one channel at a time, so the ramp is handed
+    out a block at a time: begin() gives the value at the first
+    frame of the block and the step per frame, every channel walks
+    that same line, and end() moves the ramp past the block. With
+    no ramp running the step is exactly 0 and the value exactly
+    the target, so a steady parameter costs one multiply per sample
+    and no divide.
+*/
+class Smoother{
+public:
+    static double RAMP_MS; //Length of a ramp in milliseconds
+
+    ~Smoother(void);
+    Smoother(void);
+
+    //Sets the ramp length for the stream's sample rate
+    void prepare(double tSampleRate);
+
+    //Jumps straight to value. Use before streaming starts
+    void setValue(double value);
+
+    //Ramps from wherever the value is now to target over RAMP_MS
+    void setTarget(double target);
+
+    double getTarget(void) const;
+
+    //True while a ramp is running
+    bool isRamping(void) const;
+
+    //Value at the first frame of the next block of nFrames, step holds the change per frame
+    double begin(int nFrames, double& step) const;
+
+    //Moves the ramp past a block of nFrames
+    void end(int nFrames);
+
+private:
+    double current; //Value at the first frame of the next block
+    double target; //Value the ramp ends at
+    int rampFrames; //Length of a ramp in frames
+    int framesLeft; //Frames until the ramp reaches target, 0 when it is not ramping
+};
+
+#endif
@@ -0,0 +1,135 @@
+/*
+Thread.cpp
+
+Definitions of the Thread and Mutex classes. Win32
+threads and critical sections on Windows, pthreads
+everywhere else.
+*/
+
+#include "Thread.h"
+
+#if !defined(__OS_WINDOWS__)
+  #include <unistd.h>
+  #include <time.h>
+#endif
+#if defined(__OS_MACOSX__)
+  #include <sys/time.h>
+#endif
+
+Thread::~Thread(){
+    //Never leave a thread running on a destroyed object
+    wait();
+}
+
+Thread::Thread(){
+    thread = 0;
+    running = false;
+}
+
+bool Thread::start(THREAD_FUNCTION routine, void* ptr){
+    if(running)
+        return false;
+
+#if defined(__OS_WINDOWS__)
+    unsigned threadId;
+    thread = _beginthreadex(NULL, 0, routine, ptr, 0, &threadId);
+    running = (thread != 0);
+#else
+    running = (pthread_create(&thread, NULL, routine, ptr) == 0);
+#endif
+
+    return running;
+}
+
+bool Thread::wait(){
+    if(!running)
+        return false;
+
+#if defined(__OS_WINDOWS__)
+    WaitForSingleObject((HANDLE)thread, INFINITE);
+    CloseHandle((HANDLE)thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+
+    thread = 0;
+    running = false;
+
+    return true;
+}
+
+bool Thread::isRunning() const{
+    return running;
+}
+
+//Processors threads can run on
+unsigned int Thread::countProcessors(){
+#if defined(__OS_WINDOWS__)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? static_cast<unsigned int>(count) : 1;
+#endif
+}
+
+void Thread::sleep(unsigned long milliseconds){
+#if defined(__OS_WINDOWS__)
+    Sleep((DWORD) milliseconds);
+#else
+    struct timespec time;
+    time.tv_sec = milliseconds / 1000;
+    time.tv_nsec = (milliseconds % 1000) * 1000000L;
+    nanosleep(&time, 0);
+#endif
+}
+
+double Thread::now(){
+#if defined(__OS_WINDOWS__)
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (double) count.QuadPart / frequency.QuadPart;
+#elif defined(__OS_MACOSX__)
+    struct timeval time;
+    gettimeofday(&time, 0);
+    return time.tv_sec + time.tv_usec * 1e-6;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+#endif
+}
+
+Mutex::~Mutex(){
+#if defined(__OS_WINDOWS__)
+    DeleteCriticalSection(&mutex);
+#else
+    pthread_mutex_destroy(&mutex);
+#endif
+}
+
+Mutex::Mutex(){
+#if defined(__OS_WINDOWS__)
+    InitializeCriticalSection(&mutex);
+#else
+    pthread_mutex_init(&mutex, NULL);
+#endif
+}
+
+void Mutex::lock(){
+#if defined(__OS_WINDOWS__)
+    EnterCriticalSection(&mutex);
+#else
+    pthread_mutex_lock(&mutex);
+#endif
+}
+
+void Mutex::unlock(){
+#if defined(__OS_WINDOWS__)
+    LeaveCriticalSection(&mutex);
+#else
+    pthread_mutex_unlock(&mutex);
+#endif
+}
@@ -0,0 +1,82 @@
+#ifndef __THREAD_H__
+#define __THREAD_H__
+
+#include "Stk.h"
+
+/*  Thin wrappers around a platform thread and mutex, on the model
+    of the STK Thread and Mutex classes: Win32 threads and critical
+    sections on Windows, pthreads everywhere else. The thread
+    function has the platform's signature, so declare it as
+
+        THREAD_RETURN THREAD_TYPE routine(void* ptr)
+*/
+#if defined(__OS_WINDOWS__)
+  #include <windows.h>
+  #include <process.h>
+
+  typedef unsigned long THREAD_HANDLE;
+  typedef CRITICAL_SECTION MUTEX;
+  typedef unsigned (__stdcall *THREAD_FUNCTION)(void *);
+  #define THREAD_RETURN unsigned
+  #define THREAD_TYPE __stdcall
+#else
+  #include <pthread.h>
+
+  typedef pthread_t THREAD_HANDLE;
+  typedef pthread_mutex_t MUTEX;
+  typedef void * (*THREAD_FUNCTION)(void *);
+  #define THREAD_RETURN void *
+  #define THREAD_TYPE
+#endif
+
+class Thread{
+public:
+    ~Thread(void);
+    Thread(void);
+
+    //Starts routine(ptr) on a new thread. Returns false if it is already
+    //running or the thread could not be created
+    bool start(THREAD_FUNCTION routine, void* ptr = 0);
+
+    //Blocks until the thread returns. Returns false if it was not running
+    bool wait(void);
+
+    bool isRunning(void) const;
+
+    //Processors threads can run on, at least 1
+    static unsigned int countProcessors(void);
+
+    //Seconds on a clock that only moves forward, for timing and pacing
+    static double now(void);
+
+    //Sleeps the calling thread, 0 gives up its time slice. Unlike Stk::sleep()
+    //it sleeps in builds without an audio API too, headless ones included
+    static void sleep(unsigned long milliseconds);
+
+private:
+    THREAD_HANDLE thread; //Platform handle of the running thread
+    bool running; //True between start() and wait()
+
+    //Not copyable, a handle belongs to one Thread
+    Thread(const Thread&);
+    Thread& operator=(const Thread&);
+};
+
+//Lock for state shared between threads outside the audio callback
+class Mutex{
+public:
+    ~Mutex(void);
+    Mutex(void);
+
+    void lock(void);
+    void unlock(void);
+
+private:
+    MUTEX mutex; //Platform mutex
+
+    //Not copyable, a mutex belongs to one Mutex
+    Mutex(const Mutex&);
+    Mutex& operator=(const Mutex&);
+};
+
+#endif
@@ -0,0 +1,458 @@
+/*
+EffectBenchmark.cpp
+
+Times every effect and filter on its own. Each one is run over
+white noise and, if one is given, a real recording, at every
+block size, channel count and sample rate of the sweep below.
+The report gives nanoseconds per sample (one channel's sample),
+the realtime factor and, where Linux perf events can be opened,
+the cache misses per sample. The results are written as JSON
+so two runs can be diffed.
+
+Build it next to the effects, for example with g++:
+
+    g++ -O2 -I"../My Code" -I"../STK and Direct Sound Files" -D__LITTLE_ENDIAN__ EffectBenchmark.cpp
+        "../My Code/Delays.cpp" "../My Code/Chorus.cpp" "../My Code/Filters.cpp"
+        "../My Code/CombBank.cpp" "../My Code/Reverb.cpp" "../My Code/FDNReverb.cpp"
+        "../My Code/Smoother.cpp" "../My Code/Thread.cpp"
+        "../STK and Direct Sound Files/Stk.cpp" "../STK and Direct Sound Files/FileRead.cpp"
+        -lpthread -o effectbenchmark
+
+Run it as
+
+    effectbenchmark [results.json] [input .wav] [quick]
+
+results.json defaults to effect_benchmark.json. quick only runs
+256 frame blocks of 2 channels at 44.1kHz.
+*/
+
+#include "Delays.h"
+#include "Chorus.h"
+#include "Filters.h"
+#include "Reverb.h"
+#include "FDNReverb.h"
+#include "FileRead.h"
+#include "Thread.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+  #include <cstring>
+#endif
+
+using std::cout;
+using std::endl;
+using std::string;
+
+//static variables
+static const double MIN_SECONDS = 0.1; //Wall clock time each measurement runs for at least
+static const double WARMUP_SECONDS = 0.05; //Audio run through before timing starts
+static const unsigned int BLOCK_SIZES[] = {64, 256, 1024};
+static const unsigned int CHANNEL_COUNTS[] = {1, 2};
+static const double SAMPLE_RATES[] = {44100.0, 48000.0, 96000.0};
+
+//Sets up one effect the way the menus would
+static Processor* singleDelay(){
+    SingleDelay* delay = new SingleDelay;
+    delay->setSingleDelay(0.9, 0.5, 200);
+    return delay;
+}
+static Processor* doubleDelay(){
+    DoubleDelay* delay = new DoubleDelay;
+    delay->setDoubleDelay(0.5, 0.8, 0.4, 150, 400);
+    return delay;
+}
+static Processor* feedbackDelay(){
+    FeedbackDelay* delay = new FeedbackDelay;
+    delay->setFeedbackDelay(0.9, 85, 75);
+    return delay;
+}
+static Processor* chorus(bool bandlimited){
+    //Three delays, two modulators: sine and triangle
+    std::istringstream modulators("0 1.3 68 2 0.9 50");
+    std::ostream prompts(0);
+    MultiChorus* chorus = new MultiChorus;
+    chorus->setMultiChorus(50, 50, 10, 20, 30, 3, 2, bandlimited, modulators, prompts);
+    return chorus;
+}
+static Processor* linearChorus(){
+    return chorus(false);
+}
+static Processor* bandlimitedChorus(){
+    return chorus(true);
+}
+static Processor* flanger(){
+    std::istringstream modulator("0 0.75 60");
+    std::ostream prompts(0);
+    FeedbackChorus* flanger = new FeedbackChorus;
+    flanger->setFeedbackChorus(50, 25, false, modulator, prompts);
+    return flanger;
+}
+static Processor* reverb1(){
+    Reverb1* verb = new Reverb1;
+    verb->setMix(50);
+    int delays[] = {7, 13, 29, 53, 111};
+    for(int a = 0; a < 5; a++)
+        verb->setAP(a + 1, delays[a], 50);
+    return verb;
+}
+static Processor* reverb2(){
+    Reverb2* verb = new Reverb2;
+    verb->setMix(50);
+    int delays[] = {30, 31, 33, 35};
+    for(int c = 0; c < 4; c++)
+        verb->setComb(c + 1, delays[c], 50);
+    verb->setAP(1, 100, 50);
+    verb->setAP(2, 50, 50);
+    return verb;
+}
+static Processor* reverb3(){
+    Reverb3* verb = new Reverb3;
+    verb->setMix(50);
+    int delays[] = {30, 31, 32, 33, 34, 35};
+    for(int c = 0; c < 6; c++)
+        verb->setLPComb(c + 1, delays[c], 40, 35);
+    verb->setAP(100, 30);
+    return verb;
+}
+static Processor* fdnReverb(){
+    FDNReverb* verb = new FDNReverb;
+    verb->setMix(30);
+    verb->setNetwork(8, FDNReverb::HOUSEHOLDER, 100);
+    verb->setReverbTime(2000);
+    verb->setDamping(30);
+    return verb;
+}
+static Processor* allpass(){
+    Allpass* filter = new Allpass;
+    filter->setAllpass(53, 50);
+    return filter;
+}
+static Processor* comb(){
+    Comb* filter = new Comb;
+    filter->setComb(31, 50);
+    return filter;
+}
+static Processor* lpComb(){
+    LPComb* filter = new LPComb;
+    filter->setLPComb(31, 40, 35);
+    return filter;
+}
+
+struct Case{
+    const char* name;
+    Processor* (*make)(void);
+};
+
+static const Case CASES[] = {
+    {"SingleDelay", singleDelay},
+    {"DoubleDelay", doubleDelay},
+    {"FeedbackDelay", feedbackDelay},
+    {"MultiChorus linear", linearChorus},
+    {"MultiChorus bandlimited", bandlimitedChorus},
+    {"FeedbackChorus", flanger},
+    {"Reverb1", reverb1},
+    {"Reverb2", reverb2},
+    {"Reverb3", reverb3},
+    {"FDNReverb", fdnReverb},
+    {"Allpass", allpass},
+    {"Comb", comb},
+    {"LPComb", lpComb}
+};
+
+//Counts the cache misses of this thread while open, where the kernel lets it
+class CacheCounter{
+public:
+    CacheCounter() : fd(-1) {
+#if defined(__linux__)
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+    ~CacheCounter(){
+#if defined(__linux__)
+        if(fd >= 0)
+            close(fd);
+#endif
+    }
+
+    bool isOpen(void) const { return fd >= 0; }
+
+    void start(void){
+#if defined(__linux__)
+        if(fd >= 0){
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    //Misses since start()
+    double stop(void){
+#if defined(__linux__)
+        long long count = 0;
+        if(fd >= 0){
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if(read(fd, &count, sizeof(count)) != sizeof(count))
+                count = 0;
+        }
+        return static_cast<double>(count);
+#else
+        return 0.0;
+#endif
+    }
+
+private:
+    int fd; //perf event, -1 if there is none
+};
+
+//One measurement
+struct Result{
+    string effect;
+    string input;
+    double sampleRate;
+    unsigned int channels;
+    unsigned int blockFrames;
+    double nsPerSample;
+    double realtime;
+    double missesPerSample; //-1 without perf events
+};
+
+//A signal to loop through the effects, one vector per channel
+typedef std::vector< std::vector<double> > Signal;
+
+//Two seconds of white noise at half scale, the same every run
+static void makeNoise(Signal& signal, double sampleRate){
+    std::srand(1);
+    signal.assign(2, std::vector<double>(static_cast<size_t>(2 * sampleRate)));
+    for(unsigned int c = 0; c < signal.size(); c++){
+        for(size_t i = 0; i < signal[c].size(); i++)
+            signal[c][i] = std::rand() / (double)RAND_MAX - 0.5;
+    }
+}
+
+//Reads a .wav file, returns false if it does not open
+static bool readFile(Signal& signal, const string& fileName){
+    try{
+        FileRead file(fileName);
+        unsigned long frames = file.fileSize();
+        StkFrames data(frames, file.channels());
+        file.read(data, 0, false);
+
+        signal.assign(file.channels(), std::vector<double>(frames));
+        for(unsigned int c = 0; c < file.channels(); c++){
+            for(unsigned long i = 0; i < frames; i++)
+                signal[c][i] = data(i, c);
+        }
+    }
+    catch( StkError & ){
+        return false;
+    }
+
+    return !signal.empty() && !signal[0].empty();
+}
+
+//Runs the effect over the signal, a block at a time, until MIN_SECONDS have gone by
+static Result measure(const Case& test, const Signal& signal, const string& inputName,
+    double sampleRate, unsigned int nChannels, unsigned int blockFrames, CacheCounter& counter){
+    Processor* effect = test.make();
+    effect->prepare(sampleRate, blockFrames, nChannels);
+
+    size_t length = signal[0].size();
+    std::vector<StkFloat> buffer(blockFrames * nChannels);
+    std::vector<StkFloat*> in(nChannels), out(nChannels);
+    for(unsigned int c = 0; c < nChannels; c++){
+        in[c] = &buffer[c * blockFrames];
+        out[c] = in[c]; //in place, the way the host runs them
+    }
+
+    size_t position = 0;
+    long warmupBlocks = static_cast<long>(WARMUP_SECONDS * sampleRate / blockFrames) + 1;
+    long blocks = 0;
+    double misses = 0.0;
+    double start = 0.0, elapsed = 0.0;
+
+    for(long b = 0; ; b++){
+        //The next block of the signal, channels beyond the signal's repeat it
+        for(unsigned int c = 0; c < nChannels; c++){
+            const std::vector<double>& source = signal[c % signal.size()];
+            for(unsigned int i = 0; i < blockFrames; i++)
+                in[c][i] = source[(position + i) % length];
+        }
+        position = (position + blockFrames) % length;
+
+        if(b == warmupBlocks){
+            start = Thread::now();
+            counter.start();
+        }
+
+        effect->process(&in[0], &out[0], blockFrames);
+
+        if(b >= warmupBlocks){
+            blocks++;
+            elapsed = Thread::now() - start;
+            if(elapsed >= MIN_SECONDS)
+                break;
+        }
+    }
+    misses = counter.stop();
+
+    delete effect;
+
+    double samples = (double)blocks * blockFrames * nChannels;
+
+    Result result;
+    result.effect = test.name;
+    result.input = inputName;
+    result.sampleRate = sampleRate;
+    result.channels = nChannels;
+    result.blockFrames = blockFrames;
+    result.nsPerSample = elapsed * 1e9 / samples;
+    result.realtime = (blocks * blockFrames / sampleRate) / elapsed;
+    result.missesPerSample = counter.isOpen() ? misses / samples : -1.0;
+    return result;
+}
+
+//Quotes a string for JSON
+static string quoted(const string& text){
+    string out = "\"";
+    for(size_t i = 0; i < text.size(); i++){
+        if(text[i] == '"' || text[i] == '\\')
+            out += '\\';
+        out += text[i];
+    }
+    return out + "\"";
+}
+
+static bool writeJson(const std::vector<Result>& results, const string& fileName, bool perf){
+    std::ofstream json(fileName.c_str());
+    if(!json)
+        return false;
+
+    json << "{\n  \"benchmark\": \"EffectBenchmark\",\n";
+    json << "  \"perfCounters\": " << (perf ? "true" : "false") << ",\n";
+    json << "  \"results\": [\n";
+
+    for(size_t r = 0; r < results.size(); r++){
+        const Result& result = results[r];
+        json << "    {\"effect\": " << quoted(result.effect)
+             << ", \"input\": " << quoted(result.input)
+             << ", \"sampleRate\": " << static_cast<long>(result.sampleRate)
+             << ", \"channels\": " << result.channels
+             << ", \"blockFrames\": " << result.blockFrames
+             << std::fixed << std::setprecision(3)
+             << ", \"nsPerSample\": " << result.nsPerSample
+             << ", \"realtime\": " << std::setprecision(1) << result.realtime
+             << ", \"cacheMissesPerSample\": ";
+        if(result.missesPerSample >= 0.0)
+            json << std::setprecision(4) << result.missesPerSample;
+        else
+            json << "null";
+        json.unsetf(std::ios::floatfield);
+        json << "}" << (r + 1 < results.size() ? "," : "") << "\n";
+    }
+
+    json << "  ]\n}\n";
+    return true;
+}
+
+int main(int argc, char* argv[]){
+    string jsonFile = "effect_benchmark.json";
+    string inputFile;
+    bool quick = false;
+
+    for(int a = 1; a < argc; a++){
+        string option = argv[a];
+        string extension = option.size() > 4 ? option.substr(option.size() - 4) : "";
+
+        if(option == "quick")
+            quick = true;
+        else if(extension == ".wav" || extension == ".WAV")
+            inputFile = option;
+        else
+            jsonFile = option;
+    }
+
+    //The signals: noise, and the recording if there is one
+    std::vector<Signal> signals(1);
+    std::vector<string> signalNames(1, "noise");
+    makeNoise(signals[0], 48000.0);
+
+    if(!inputFile.empty()){
+        Signal file;
+        if(readFile(file, inputFile)){
+            signals.push_back(file);
+            signalNames.push_back(inputFile);
+        }
+        else
+            cout << "The input file " << inputFile << " did not open, running on noise only." << endl;
+    }
+
+    std::vector<unsigned int> blockSizes(BLOCK_SIZES, BLOCK_SIZES + sizeof(BLOCK_SIZES) / sizeof(BLOCK_SIZES[0]));
+    std::vector<unsigned int> channelCounts(CHANNEL_COUNTS, CHANNEL_COUNTS + sizeof(CHANNEL_COUNTS) / sizeof(CHANNEL_COUNTS[0]));
+    std::vector<double> sampleRates(SAMPLE_RATES, SAMPLE_RATES + sizeof(SAMPLE_RATES) / sizeof(SAMPLE_RATES[0]));
+    if(quick){
+        blockSizes.assign(1, 256);
+        channelCounts.assign(1, 2);
+        sampleRates.assign(1, 44100.0);
+    }
+
+    CacheCounter counter;
+    if(!counter.isOpen())
+        cout << "Perf events are not available, cache misses are not counted." << endl;
+
+    cout << std::left << std::setw(25) << "effect" << std::right << std::setw(8) << "input" << std::setw(8) << "rate"
+         << std::setw(4) << "ch" << std::setw(7) << "block" << std::setw(12) << "ns/sample"
+         << std::setw(11) << "realtime" << std::setw(14) << "misses/sample" << endl;
+
+    std::vector<Result> results;
+    for(unsigned int t = 0; t < sizeof(CASES) / sizeof(CASES[0]); t++){
+        for(unsigned int s = 0; s < signals.size(); s++){
+            for(unsigned int r = 0; r < sampleRates.size(); r++){
+                for(unsigned int c = 0; c < channelCounts.size(); c++){
+                    for(unsigned int b = 0; b < blockSizes.size(); b++){
+                        Result result = measure(CASES[t], signals[s], signalNames[s],
+                            sampleRates[r], channelCounts[c], blockSizes[b], counter);
+                        results.push_back(result);
+
+                        cout << std::left << std::setw(25) << result.effect << std::right
+                             << std::setw(8) << (s == 0 ? "noise" : "file")
+                             << std::setw(8) << std::setprecision(0) << std::fixed << result.sampleRate
+                             << std::setw(4) << result.channels << std::setw(7) << result.blockFrames
+                             << std::setw(12) << std::setprecision(2) << result.nsPerSample
+                             << std::setw(10) << std::setprecision(0) << result.realtime << "x";
+                        if(result.missesPerSample >= 0.0)
+                            cout << std::setw(14) << std::setprecision(4) << result.missesPerSample;
+                        else
+                            cout << std::setw(14) << "-";
+                        cout << endl;
+                    }
+                }
+            }
+        }
+    }
+
+    if(!writeJson(results, jsonFile, counter.isOpen())){
+        cout << "Could not write " << jsonFile << "." << endl;
+        return 1;
+    }
+
+    cout << "Wrote " << results.size() << " results to " << jsonFile << "." << endl;
+    return 0;
+}
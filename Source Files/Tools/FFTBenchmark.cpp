@@ -0,0 +1,163 @@
+/*
+FFTBenchmark.cpp
+
+Checks the FFT class against a naive DFT and times both.
+Every size from 4 to 65536 samples is transformed out of place
+and in place and sent back through the inverse. Up to 4096
+samples the bins are also compared with the DFT and the DFT is
+timed, past that it takes too long to be worth waiting for and
+only the round trip is checked.
+
+Build it next to the effects, for example with g++:
+
+    g++ -O2 -I"../My Code" -I"../STK and Direct Sound Files" FFTBenchmark.cpp
+        "../My Code/FFT.cpp" "../My Code/Thread.cpp" -lpthread -o fftbenchmark
+
+Returns 0 if every size is within tolerance.
+*/
+
+#include "FFT.h"
+#include "Thread.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using std::cout;
+using std::endl;
+
+//static variables
+static const int MAX_DFT_SIZE = 4096; //Largest size checked against the DFT
+static const double TOLERANCE = 1e-9; //Largest error allowed, relative to the biggest bin
+
+//Naive DFT of size real samples, size/2 + 1 bins
+static void dft(const double* in, double* re, double* im, int size){
+    double twoPi = 8.0 * atan(1.0);
+
+    for(int k = 0; k <= size / 2; k++){
+        double sumRe = 0.0, sumIm = 0.0;
+        for(int n = 0; n < size; n++){
+            //k * n taken mod size keeps the angle small and exact
+            double angle = twoPi * ((static_cast<long>(k) * n) % size) / size;
+            sumRe += in[n] * cos(angle);
+            sumIm -= in[n] * sin(angle);
+        }
+        re[k] = sumRe;
+        im[k] = sumIm;
+    }
+}
+
+//Seconds per call of a transform, run until it has taken a tenth of a second
+template <class Transform>
+static double timeOf(Transform& transform){
+    long runs = 0;
+    double start = Thread::now();
+    double elapsed;
+
+    do{
+        transform();
+        runs++;
+        elapsed = Thread::now() - start;
+    } while(elapsed < 0.1);
+
+    return elapsed / runs;
+}
+
+struct ForwardCall{
+    FFT* fft; const double* in; double* re; double* im;
+    void operator()(){ fft->forward(in, re, im); }
+};
+struct InPlaceCall{
+    FFT* fft; const double* in; double* data; int size;
+    void operator()(){ std::copy(in, in + size, data); fft->forward(data); } //fresh input every run
+};
+struct DFTCall{
+    const double* in; double* re; double* im; int size;
+    void operator()(){ dft(in, re, im, size); }
+};
+
+int main(){
+    bool passed = true;
+
+    cout << std::setw(6) << "size" << std::setw(12) << "dft error" << std::setw(12) << "round trip"
+         << std::setw(12) << "fft (us)" << std::setw(12) << "in place" << std::setw(12) << "dft (us)"
+         << std::setw(10) << "speedup" << endl;
+
+    std::srand(1);
+
+    for(int size = 4; size <= 65536; size *= 2){
+        int bins = size / 2 + 1;
+        std::vector<double> in(size), re(bins), im(bins), out(size), packed(size);
+        std::vector<double> dftRe(bins), dftIm(bins);
+
+        for(int n = 0; n < size; n++)
+            in[n] = 2.0 * std::rand() / RAND_MAX - 1.0;
+
+        FFT fft;
+        fft.setSize(size);
+        fft.forward(&in[0], &re[0], &im[0]);
+
+        //The packed spectrum has to hold the same bins
+        double packError = 0.0;
+        packed = in;
+        fft.forward(&packed[0]);
+        packError = fabs(packed[0] - re[0]) + fabs(packed[1] - re[size / 2]);
+        for(int k = 1; k < size / 2; k++)
+            packError += fabs(packed[2 * k] - re[k]) + fabs(packed[2 * k + 1] - im[k]);
+
+        //Back again, out of place and in place
+        double roundTrip = 0.0;
+        fft.inverse(&re[0], &im[0], &out[0]);
+        fft.inverse(&packed[0]);
+        for(int n = 0; n < size; n++){
+            roundTrip = std::max(roundTrip, fabs(out[n] - in[n]));
+            roundTrip = std::max(roundTrip, fabs(packed[n] - in[n]));
+        }
+
+        ForwardCall forward = {&fft, &in[0], &re[0], &im[0]};
+        double fftTime = timeOf(forward);
+
+        InPlaceCall inPlace = {&fft, &in[0], &packed[0], size};
+        double inPlaceTime = timeOf(inPlace);
+
+        cout << std::setw(6) << size;
+
+        if(size <= MAX_DFT_SIZE){
+            dft(&in[0], &dftRe[0], &dftIm[0], size);
+            fft.forward(&in[0], &re[0], &im[0]);
+
+            double largest = 0.0, error = 0.0;
+            for(int k = 0; k < bins; k++){
+                largest = std::max(largest, sqrt(dftRe[k] * dftRe[k] + dftIm[k] * dftIm[k]));
+                error = std::max(error, sqrt((re[k] - dftRe[k]) * (re[k] - dftRe[k]) + (im[k] - dftIm[k]) * (im[k] - dftIm[k])));
+            }
+            error /= largest;
+
+            DFTCall naive = {&in[0], &dftRe[0], &dftIm[0], size};
+            double dftTime = timeOf(naive);
+
+            cout << std::setw(12) << std::setprecision(2) << std::scientific << error;
+            cout << std::setw(12) << roundTrip << std::fixed;
+            cout << std::setw(12) << std::setprecision(3) << fftTime * 1e6 << std::setw(12) << inPlaceTime * 1e6;
+            cout << std::setw(12) << std::setprecision(1) << dftTime * 1e6;
+            cout << std::setw(9) << std::setprecision(0) << dftTime / fftTime << "x";
+
+            if(error > TOLERANCE)
+                passed = false;
+        }
+        else{
+            cout << std::setw(12) << "-" << std::setw(12) << std::setprecision(2) << std::scientific << roundTrip << std::fixed;
+            cout << std::setw(12) << std::setprecision(3) << fftTime * 1e6 << std::setw(12) << inPlaceTime * 1e6;
+            cout << std::setw(12) << "-" << std::setw(10) << "-";
+        }
+        cout << endl;
+
+        if(roundTrip > TOLERANCE || packError > TOLERANCE * size)
+            passed = false;
+    }
+
+    cout << (passed ? "All sizes within tolerance." : "FAILED: a size is out of tolerance.") << endl;
+    return passed ? 0 : 1;
+}
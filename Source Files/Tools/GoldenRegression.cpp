@@ -0,0 +1,691 @@
+/*
+GoldenRegression.cpp
+
+Checks the effects against the reference renders shipped in
+Delays, Frequency Modulations and Reverberations. The parameters
+of each render are parsed from its file name, W.WAV is rendered
+through an Effect set up from the same menu answers, 256 frames
+at a time the way the file output does, and the result is
+compared with the reference. Every file is reported with its
+status, its error and how fast it rendered.
+
+The names only hold some of the parameters, the rest are the
+defaults the references were rendered with:
+
+    single delay    dry 0.5, wet 0.5
+    double delay    dry 0.5, short delay's wet 0.5 (0.3 for
+                    quieter_echoes), the long delay's wet is 0.3
+    feedback delay  output gain 0.7
+    reverb 1        mix 50%
+    chorus          dry 50%, wet 50%, linear unless the name
+                    says bandlim (not confirmed)
+    flanger         linear (not confirmed)
+
+The original code only reproduces two of the chorus and flanger
+references, REPRODUCED names them. They were re-rendered with update
+after the modulated effects changed their output on purpose:
+interpolation no longer skips the fraction (an operator precedence
+bug) and the modulated taps convert ms to samples like the initial
+delay does. The rest came from an older modulator and mix, they are
+left as shipped and skipped. Names without their parameters
+(louder_echoes, unitprimes, the Reverb 2 and Reverb 3 presets) are
+skipped too. A few references were rendered off the defaults,
+EXCEPTIONS holds their answers.
+
+fbk_delay_0ms_50dec is not a shipped reference, it was rendered
+with update after the 0 ms tap was clamped to 1 sample. It matches
+this model of FeedbackDelay exactly, not a plain feedback loop:
+
+    s[0] = 0.7 x[0]                 the warm-up frame stores the
+                                    gained input, there is no tap yet
+    s[n] = x[n] + 0.5 s[n-1]        the ring holds s unclipped
+    y[n] = 0.7 s[n] for n > 0, y[0] = s[0], then any y above 1.0
+    becomes 0.999 and any below -1.0 becomes -0.999
+
+Build it next to the effects, for example with g++:
+
+    g++ -O2 -I"../My Code" -I"../STK and Direct Sound Files" -D__LITTLE_ENDIAN__ GoldenRegression.cpp
+        "../My Code/Effect.cpp" "../My Code/EffectGraph.cpp" "../My Code/ParameterQueue.cpp"
+        "../My Code/Delays.cpp" "../My Code/Chorus.cpp" "../My Code/Filters.cpp"
+        "../My Code/CombBank.cpp" "../My Code/Reverb.cpp" "../My Code/FDNReverb.cpp"
+        "../My Code/ConvolutionReverb.cpp" "../My Code/Convolver.cpp" "../My Code/FFT.cpp"
+        "../My Code/MappedWavFile.cpp" "../My Code/Smoother.cpp" "../My Code/Thread.cpp"
+        "../My Code/AllocationGuard.cpp"
+        "../STK and Direct Sound Files/Stk.cpp" "../STK and Direct Sound Files/FileRead.cpp"
+        "../STK and Direct Sound Files/FileWrite.cpp" -lpthread -o goldenregression
+
+Run it from the top of the repository as
+
+    goldenregression [root] [exact | max=<error> | snr=<dB>] [update]
+
+root can only come first and defaults to the current directory,
+W.WAV is read from its Executable and Input Files. exact, the
+default, wants every sample the same. max= passes a file whose
+largest error is at most error, snr= one whose signal to error
+ratio is at least dB. update writes the render over every
+checked reference that fails, for when an effect changes its
+output on purpose. Say why in the commit that carries the new
+references, and check that the original code reproduced them.
+Any other argument prints the usage.
+
+Returns 0 if no file fails.
+*/
+
+#include "Effect.h"
+#include "MappedWavFile.h"
+#include "FileRead.h"
+#include "FileWrite.h"
+#include "Thread.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__OS_WINDOWS__) || defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <dirent.h>
+#endif
+
+using std::cout;
+using std::endl;
+using std::string;
+
+//static variables
+static const unsigned int BLOCK_FRAMES = 256; //Block size the file output renders with
+static const char* INPUT_FILE = "Executable and Input Files/W.WAV";
+
+//A signal, one vector per channel
+typedef std::vector< std::vector<double> > Signal;
+
+//How close a render has to be to its reference
+struct Tolerance{
+    enum Kind {EXACT, MAX_ERROR, SNR} kind;
+    double limit;
+};
+
+//One folder of references and how its names turn into menu answers
+struct Category{
+    const char* folder;
+    const char* prefix; //Every name in the folder starts with it
+    bool reproduced; //False if the original code does not reproduce the references, see REPRODUCED
+    bool (*answers)(const std::vector<string>& words, string& menu, string& reason);
+};
+
+//A reference rendered off the defaults
+struct Exception{
+    const char* name;
+    const char* menu; //Answers it was rendered with, 0 if they are not known
+    const char* reason;
+};
+
+static const Exception EXCEPTIONS[] = {
+    {"fbk_delay_75ms_85dec.wav", "3 75 85 0.65", "output gain 0.65"},
+    {"fbk_delay_30ms_30dec.wav", 0, "does not match the settings in its name"}
+};
+
+//The references the original code reproduces in folders where it does not
+//reproduce the rest. Only these are checked, and only these can be updated
+static const char* REPRODUCED[] = {
+    "chorus_10ms_linear_sine_2f_75dep.wav",
+    "flanger_1ms_30dec_sine_0p75f_60dep.wav"
+};
+
+//One checked file
+struct Report{
+    enum Status {PASS, FAIL, SKIP, UPDATE} status;
+    string reason;
+    double maxError;
+    double snr;
+    double realtime;
+};
+
+//Splits a name without its extension at the underscores
+static std::vector<string> splitName(const string& name){
+    std::vector<string> words;
+    string stem = name.substr(0, name.rfind('.'));
+    std::istringstream parts(stem);
+    string word;
+    while(std::getline(parts, word, '_'))
+        words.push_back(word);
+    return words;
+}
+
+//Reads the number at the front of word followed by unit, 1p3f is 1.3 and f.
+//p stands for the decimal point. Returns false if word is anything else
+static bool number(const string& word, const string& unit, double& value){
+    if(word.size() <= unit.size() || word.compare(word.size() - unit.size(), unit.size(), unit) != 0)
+        return false;
+
+    string digits = word.substr(0, word.size() - unit.size());
+    std::replace(digits.begin(), digits.end(), 'p', '.');
+    if(digits.find_first_not_of("0123456789.") != string::npos)
+        return false;
+
+    value = std::atof(digits.c_str());
+    return true;
+}
+
+//Every delay in a run of words like 28ms48ms
+static bool delays(const string& word, std::vector<double>& lengths){
+    size_t start = 0;
+    while(start < word.size()){
+        size_t end = word.find("ms", start);
+        double value;
+        if(end == string::npos || !number(word.substr(start, end + 2 - start), "ms", value))
+            return false;
+        lengths.push_back(value);
+        start = end + 2;
+    }
+    return !lengths.empty();
+}
+
+//Modulator shape as the menu numbers it, -1 if word is not a shape
+static int shape(const string& word){
+    if(word == "sine") return 0;
+    if(word == "saw") return 1;
+    if(word == "tri") return 2;
+    if(word == "square") return 3;
+    return -1;
+}
+
+//single_delay_200ms
+static bool singleDelay(const std::vector<string>& words, string& menu, string& reason){
+    std::vector<double> lengths;
+    if(words.size() != 3 || !delays(words[2], lengths) || lengths.size() != 1){
+        reason = "no delay in the name";
+        return false;
+    }
+
+    std::ostringstream answers;
+    answers << "1 " << lengths[0] << " 0.5 0.5";
+    menu = answers.str();
+    return true;
+}
+
+//double_delay_28ms48ms, double_delay_150ms300ms_quieter_echoes
+static bool doubleDelay(const std::vector<string>& words, string& menu, string& reason){
+    std::vector<double> lengths;
+    if(words.size() < 3 || !delays(words[2], lengths) || lengths.size() != 2){
+        reason = "no delays in the name";
+        return false;
+    }
+
+    double wet = 0.5;
+    if(words.size() > 3){
+        if(words[3] != "quieter"){
+            reason = "gains not in the name";
+            return false;
+        }
+        wet = 0.3;
+    }
+
+    std::ostringstream answers;
+    answers << "2 " << std::max(lengths[0], lengths[1]) << " " << std::min(lengths[0], lengths[1])
+            << " 0.5 0.3 " << wet;
+    menu = answers.str();
+    return true;
+}
+
+//fbk_delay_75ms_85dec
+static bool feedbackDelay(const std::vector<string>& words, string& menu, string& reason){
+    std::vector<double> lengths;
+    double decay;
+    if(words.size() != 4 || !delays(words[2], lengths) || lengths.size() != 1 || !number(words[3], "dec", decay)){
+        reason = "no delay or decay in the name";
+        return false;
+    }
+
+    std::ostringstream answers;
+    answers << "3 " << lengths[0] << " " << decay << " 0.7";
+    menu = answers.str();
+    return true;
+}
+
+//Modulators from words like sine_1p3f_68dep_tri_1p1f_60dep. Shapes without
+//their own frequency and depth share the next ones, sine_saw_tri_1f_50dep
+static bool modulators(const std::vector<string>& words, size_t first, std::vector<string>& settings){
+    std::vector<int> pending;
+
+    for(size_t w = first; w < words.size(); w++){
+        int s = shape(words[w]);
+        double freq, depth;
+
+        if(s >= 0)
+            pending.push_back(s);
+        else if(number(words[w], "f", freq) && w + 1 < words.size() && number(words[w + 1], "dep", depth) && !pending.empty()){
+            for(size_t p = 0; p < pending.size(); p++){
+                std::ostringstream setting;
+                setting << pending[p] << " " << freq << " " << depth;
+                settings.push_back(setting.str());
+            }
+            pending.clear();
+            w++;
+        }
+        else
+            return false;
+    }
+
+    return pending.empty() && !settings.empty();
+}
+
+//chorus_35ms_54ms_sine_1p3f_60dep_tri_1p1f_60dep, chorus_1ms_bandlim_sine_2f_75dep
+static bool chorus(const std::vector<string>& words, string& menu, string& reason){
+    std::vector<double> lengths;
+    size_t w = 1;
+    while(w < words.size() && delays(words[w], lengths))
+        w++;
+
+    int interpolation = 0;
+    if(w < words.size() && (words[w] == "linear" || words[w] == "bandlim")){
+        interpolation = (words[w] == "bandlim") ? 1 : 0;
+        w++;
+    }
+
+    std::vector<string> settings;
+    if(lengths.empty() || lengths.size() > 3 || !modulators(words, w, settings) || settings.size() > lengths.size()){
+        reason = "delays or modulators not in the name";
+        return false;
+    }
+
+    //The menu wants the delays from longest to shortest
+    std::sort(lengths.rbegin(), lengths.rend());
+
+    std::ostringstream answers;
+    answers << "4 50 50 " << lengths.size();
+    for(size_t d = 0; d < lengths.size(); d++)
+        answers << " " << lengths[d];
+    answers << " " << settings.size() << " " << interpolation;
+    for(size_t m = 0; m < settings.size(); m++)
+        answers << " " << settings[m];
+    menu = answers.str();
+    return true;
+}
+
+//flanger_15ms_50dec_saw_0p75f_60dep
+static bool flanger(const std::vector<string>& words, string& menu, string& reason){
+    std::vector<double> lengths;
+    std::vector<string> settings;
+    double decay;
+    if(words.size() < 4 || !delays(words[1], lengths) || lengths.size() != 1 || !number(words[2], "dec", decay)
+        || !modulators(words, 3, settings) || settings.size() != 1){
+        reason = "delay, decay or modulator not in the name";
+        return false;
+    }
+
+    std::ostringstream answers;
+    answers << "5 " << lengths[0] << " " << decay << " 0 " << settings[0];
+    menu = answers.str();
+    return true;
+}
+
+//verb1_50dec_7_13_29_53_111
+static bool reverb1(const std::vector<string>& words, string& menu, string& reason){
+    double decay;
+    if(words.size() != 7 || !number(words[1], "dec", decay)){
+        reason = "decay or allpass delays not in the name";
+        return false;
+    }
+
+    std::ostringstream answers;
+    answers << "6 50 " << decay;
+    for(size_t w = 2; w < words.size(); w++){
+        if(words[w].find_first_not_of("0123456789") != string::npos){
+            reason = "decay or allpass delays not in the name";
+            return false;
+        }
+        answers << " " << words[w];
+    }
+    menu = answers.str();
+    return true;
+}
+
+//The Reverb 2 and 3 references are presets, none of their settings are in the name
+static bool preset(const std::vector<string>&, string&, string& reason){
+    reason = "preset, its settings are not in the name";
+    return false;
+}
+
+static const Category CATEGORIES[] = {
+    {"Delays/Single Delay", "single_delay", true, singleDelay},
+    {"Delays/Double Delay", "double_delay", true, doubleDelay},
+    {"Delays/Feedback Delay", "fbk_delay", true, feedbackDelay},
+    {"Frequency Modulations/Chorus", "chorus", false, chorus},
+    {"Frequency Modulations/Flanger", "flanger", false, flanger},
+    {"Reverberations/Reverb 1", "verb1", true, reverb1},
+    {"Reverberations/Reverb 2", "verb2", true, preset},
+    {"Reverberations/Reverb 3", "verb3", true, preset}
+};
+
+//Names of the .wav files in folder, sorted. Empty if it does not open
+static std::vector<string> listFiles(const string& folder){
+    std::vector<string> names;
+
+#if defined(__OS_WINDOWS__) || defined(_WIN32)
+    WIN32_FIND_DATAA found;
+    HANDLE search = FindFirstFileA((folder + "\\*.wav").c_str(), &found);
+    if(search != INVALID_HANDLE_VALUE){
+        do{
+            names.push_back(found.cFileName);
+        } while(FindNextFileA(search, &found));
+        FindClose(search);
+    }
+#else
+    DIR* directory = opendir(folder.c_str());
+    if(directory){
+        while(struct dirent* entry = readdir(directory)){
+            string name = entry->d_name;
+            if(name.size() > 4 && (name.substr(name.size() - 4) == ".wav" || name.substr(name.size() - 4) == ".WAV"))
+                names.push_back(name);
+        }
+        closedir(directory);
+    }
+#endif
+
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+//Reads the input the way the file input does, short files normalized
+//to their peak. Returns false if it does not open
+static bool readInput(Signal& signal, double& sampleRate, const string& fileName){
+    MappedWavFile file;
+    if(!file.open(fileName))
+        return false;
+
+    signal.assign(file.getChannels(), std::vector<double>(file.getFrames()));
+    std::vector<StkFloat*> channels(file.getChannels());
+    for(unsigned int c = 0; c < file.getChannels(); c++)
+        channels[c] = &signal[c][0];
+
+    file.read(&channels[0], file.getFrames());
+    sampleRate = file.getFileRate();
+    return !signal.empty() && !signal[0].empty();
+}
+
+//Reads a reference render as it was written. Returns false if it does not open
+static bool readFile(Signal& signal, double& sampleRate, const string& fileName){
+    try{
+        FileRead file(fileName);
+        unsigned long frames = file.fileSize();
+        StkFrames data(frames, file.channels());
+        file.read(data, 0, false);
+
+        signal.assign(file.channels(), std::vector<double>(frames));
+        for(unsigned int c = 0; c < file.channels(); c++){
+            for(unsigned long i = 0; i < frames; i++)
+                signal[c][i] = data(i, c);
+        }
+        sampleRate = file.fileRate();
+    }
+    catch( StkError & ){
+        return false;
+    }
+
+    return !signal.empty() && !signal[0].empty();
+}
+
+//Writes a render over its reference, 64 bit float like the references.
+//Returns false if it does not write
+static bool writeFile(const Signal& signal, double sampleRate, const string& fileName){
+    try{
+        Stk::setSampleRate(sampleRate);
+        FileWrite file(fileName, static_cast<unsigned int>(signal.size()), FileWrite::FILE_WAV, Stk::STK_FLOAT64);
+        StkFrames data(static_cast<unsigned int>(signal[0].size()), static_cast<unsigned int>(signal.size()));
+        for(unsigned int c = 0; c < signal.size(); c++){
+            for(unsigned long i = 0; i < signal[c].size(); i++)
+                data(i, c) = signal[c][i];
+        }
+        file.write(data);
+    }
+    catch( StkError & ){
+        return false;
+    }
+
+    return true;
+}
+
+//Renders input through the effect the answers set up, in whole blocks with the
+//last one padded by silence. Returns the seconds it took, -1 if the answers did not take
+static double render(const string& menu, const Signal& input, double sampleRate, Signal& output){
+    unsigned int nChannels = static_cast<unsigned int>(input.size());
+    std::istringstream menuAnswers(menu);
+    std::ostream prompts(0);
+
+    Effect effect;
+    effect.setConsole(menuAnswers, prompts);
+    effect.prepare(sampleRate, BLOCK_FRAMES, nChannels);
+    effect.chooseEffect();
+    if(menuAnswers.fail())
+        return -1.0;
+    effect.prepare(sampleRate, BLOCK_FRAMES, nChannels);
+
+    size_t length = input[0].size();
+    size_t blocks = (length + BLOCK_FRAMES - 1) / BLOCK_FRAMES;
+    output.assign(nChannels, std::vector<double>(blocks * BLOCK_FRAMES));
+
+    std::vector<StkFloat> buffer(BLOCK_FRAMES * nChannels);
+    std::vector<StkFloat*> channels(nChannels);
+    for(unsigned int c = 0; c < nChannels; c++)
+        channels[c] = &buffer[c * BLOCK_FRAMES];
+
+    double start = Thread::now();
+
+    for(size_t b = 0; b < blocks; b++){
+        size_t first = b * BLOCK_FRAMES;
+        for(unsigned int c = 0; c < nChannels; c++){
+            for(unsigned int i = 0; i < BLOCK_FRAMES; i++)
+                channels[c][i] = (first + i < length) ? input[c][first + i] : 0.0;
+        }
+
+        effect.process(&channels[0], &channels[0], BLOCK_FRAMES); //in place
+
+        for(unsigned int c = 0; c < nChannels; c++)
+            std::copy(channels[c], channels[c] + BLOCK_FRAMES, output[c].begin() + first);
+    }
+
+    return Thread::now() - start;
+}
+
+//Compares a render with its reference and fills in the report's errors
+static bool compare(const Signal& rendered, const Signal& reference, const Tolerance& tolerance, Report& report){
+    if(rendered.size() != reference.size() || rendered[0].size() != reference[0].size()){
+        report.reason = "length or channels differ from the reference";
+        return false;
+    }
+
+    double signal = 0.0, noise = 0.0;
+    report.maxError = 0.0;
+    for(size_t c = 0; c < reference.size(); c++){
+        for(size_t i = 0; i < reference[c].size(); i++){
+            double error = rendered[c][i] - reference[c][i];
+            report.maxError = std::max(report.maxError, fabs(error));
+            signal += reference[c][i] * reference[c][i];
+            noise += error * error;
+        }
+    }
+    report.snr = (noise > 0.0) ? 10.0 * log10(signal / noise) : HUGE_VAL;
+
+    switch(tolerance.kind){
+        case Tolerance::EXACT:
+            return report.maxError == 0.0;
+        case Tolerance::MAX_ERROR:
+            return report.maxError <= tolerance.limit;
+        default:
+            return report.snr >= tolerance.limit;
+    }
+}
+
+static void printUsage(){
+    cout << "Usage: goldenregression [root] [exact | max=<error> | snr=<dB>] [update]" << endl;
+}
+
+//Reads the number after the = of option. Returns false if there is none
+static bool limit(const string& option, double& value){
+    const char* start = option.c_str() + option.find('=') + 1;
+    char* end;
+    value = std::strtod(start, &end);
+    return end != start && *end == '\0';
+}
+
+//Checks one reference file
+static Report check(const Category& category, const string& folder, const string& name,
+    const Signal& input, double sampleRate, const Tolerance& tolerance, bool update){
+    Report report;
+    report.status = Report::SKIP;
+    report.maxError = 0.0;
+    report.snr = 0.0;
+    report.realtime = 0.0;
+
+    string menu;
+    const Exception* exception = 0;
+    for(size_t e = 0; e < sizeof(EXCEPTIONS) / sizeof(EXCEPTIONS[0]); e++){
+        if(name == EXCEPTIONS[e].name)
+            exception = &EXCEPTIONS[e];
+    }
+
+    if(exception){
+        if(!exception->menu){
+            report.reason = exception->reason;
+            return report;
+        }
+        menu = exception->menu;
+    }
+    else if(!category.answers(splitName(name), menu, report.reason))
+        return report;
+
+    if(!category.reproduced){
+        bool listed = false;
+        for(size_t r = 0; r < sizeof(REPRODUCED) / sizeof(REPRODUCED[0]); r++){
+            if(name == REPRODUCED[r])
+                listed = true;
+        }
+        if(!listed){
+            report.reason = "the original code does not reproduce it either";
+            return report;
+        }
+    }
+
+    Signal reference;
+    double referenceRate;
+    if(!readFile(reference, referenceRate, folder + "/" + name) || referenceRate != sampleRate){
+        report.status = Report::FAIL;
+        report.reason = "reference did not open or is at another rate";
+        return report;
+    }
+
+    Signal rendered;
+    double seconds = render(menu, input, sampleRate, rendered);
+    if(seconds < 0.0){
+        report.status = Report::FAIL;
+        report.reason = "the menus did not take the answers " + menu;
+        return report;
+    }
+    report.realtime = (seconds > 0.0) ? (rendered[0].size() / sampleRate) / seconds : HUGE_VAL;
+
+    report.status = compare(rendered, reference, tolerance, report) ? Report::PASS : Report::FAIL;
+
+    if(report.status == Report::FAIL && update){
+        if(!writeFile(rendered, sampleRate, folder + "/" + name))
+            report.reason = "could not write the new reference";
+        else
+            report.status = Report::UPDATE;
+    }
+    return report;
+}
+
+int main(int argc, char* argv[]){
+    string root = ".";
+    Tolerance tolerance = {Tolerance::EXACT, 0.0};
+    bool update = false;
+
+    for(int a = 1; a < argc; a++){
+        string option = argv[a];
+
+        if(option == "update")
+            update = true;
+        else if(option == "exact")
+            tolerance.kind = Tolerance::EXACT;
+        else if(option.compare(0, 4, "max=") == 0 && limit(option, tolerance.limit))
+            tolerance.kind = Tolerance::MAX_ERROR;
+        else if(option.compare(0, 4, "snr=") == 0 && limit(option, tolerance.limit))
+            tolerance.kind = Tolerance::SNR;
+        else if(a == 1 && option.find('=') == string::npos)
+            root = option;
+        else{
+            cout << "Invalid argument " << option << "." << endl;
+            printUsage();
+            return 1;
+        }
+    }
+
+    Signal input;
+    double sampleRate = 0.0;
+    if(!readInput(input, sampleRate, root + "/" + INPUT_FILE)){
+        cout << "The input file " << root << "/" << INPUT_FILE << " did not open." << endl;
+        printUsage();
+        return 1;
+    }
+
+    int passed = 0, failed = 0, skipped = 0, updated = 0;
+
+    cout << std::left << std::setw(6) << "status" << std::right << std::setw(12) << "max error"
+         << std::setw(10) << "snr (dB)" << std::setw(10) << "realtime" << "  file" << endl;
+
+    for(size_t k = 0; k < sizeof(CATEGORIES) / sizeof(CATEGORIES[0]); k++){
+        const Category& category = CATEGORIES[k];
+        string folder = root + "/" + category.folder;
+        std::vector<string> names = listFiles(folder);
+
+        for(size_t n = 0; n < names.size(); n++){
+            if(names[n].compare(0, strlen(category.prefix), category.prefix) != 0)
+                continue;
+
+            Report report = check(category, folder, names[n], input, sampleRate, tolerance, update);
+            string file = string(category.folder) + "/" + names[n];
+
+            if(report.status == Report::SKIP){
+                cout << std::left << std::setw(38) << "skip" << "  " << file << " (" << report.reason << ")" << endl;
+                skipped++;
+                continue;
+            }
+
+            const char* status = "FAIL";
+            if(report.status == Report::PASS)
+                status = "pass";
+            else if(report.status == Report::UPDATE)
+                status = "new";
+            cout << std::left << std::setw(6) << status << std::right;
+            if(!report.reason.empty())
+                cout << std::setw(32) << "-" << "  " << file << " (" << report.reason << ")";
+            else{
+                cout << std::setw(12) << std::setprecision(3) << std::scientific << report.maxError << std::fixed;
+                if(report.snr == HUGE_VAL)
+                    cout << std::setw(10) << "inf";
+                else
+                    cout << std::setw(10) << std::setprecision(1) << report.snr;
+                cout << std::setw(9) << std::setprecision(0) << report.realtime << "x  " << file;
+            }
+            cout.unsetf(std::ios::floatfield);
+            cout << endl;
+
+            if(report.status == Report::PASS)
+                passed++;
+            else if(report.status == Report::UPDATE)
+                updated++;
+            else
+                failed++;
+        }
+    }
+
+    cout << passed << " passed, " << failed << " failed, " << skipped << " skipped";
+    if(update)
+        cout << ", " << updated << " updated";
+    cout << "." << endl;
+    return (failed == 0 && passed + updated > 0) ? 0 : 1;
+}